@@ -0,0 +1,315 @@
+/****************************************************/
+/* File: basescan.c                                 */
+/* Baseline of the scanner benchmark (make bench):  */
+/* the scanner before the skip kernels, which reads */
+/* the mapped source one character at a time,       */
+/* timed like scanbench                             */
+/* usage: basescan <file>                           */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "srcbuf.h"
+
+/* RUNS = times the file is scanned */
+#define RUNS 10
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int Error = FALSE;
+
+/* the scanner as it was, its token string and
+   tracing left out */
+#define BASE_MAXTOKENLEN 40
+
+/* states in scanner DFA */
+typedef enum
+{
+  START,
+  IN_LT_OR_LE,
+  IN_GT_OR_GE,
+  IN_NOT_EQUAL,
+  IN_ASSIGN_OR_EQUAL,
+  IN_OVER_OR_COMMENT,
+  IN_COMMENT_END,
+  INCOMMENT,
+  INNUM,
+  INID,
+  DONE
+} StateType;
+
+static char tokenString[BASE_MAXTOKENLEN + 1];
+
+static SourceBuffer srcBuf;         /* whole text of the source file */
+static const char *bufPos = NULL;  /* next character to be read */
+static const char *lineEnd = NULL; /* one past the end of the current line */
+static const char *bufEnd = NULL;  /* one past the last character of source */
+static int EOF_flag = FALSE;       /* corrects ungetNextChar behavior on EOF */
+
+/* getNextChar fetches the next character of the
+   current line, advancing to the next line of the
+   in-memory source when the current one is exhausted */
+static int getNextChar(void)
+{
+  if (!(bufPos < lineEnd))
+  {
+    lineno++;
+    if (bufPos < bufEnd)
+    {
+      lineEnd = memchr(bufPos, '\n', bufEnd - bufPos);
+      lineEnd = (lineEnd == NULL) ? bufEnd : lineEnd + 1;
+      return *bufPos++;
+    }
+    else
+    {
+      EOF_flag = TRUE;
+      return EOF;
+    }
+  }
+  else
+    return *bufPos++;
+}
+
+/* ungetNextChar backtracks one character
+   in the current line */
+static void ungetNextChar(void)
+{
+  if (!EOF_flag)
+    bufPos--;
+}
+
+/* lookup table of reserved words */
+static struct
+{
+  char *str;
+  TokenType tok;
+} reservedWords[MAXRESERVED] = {
+  { "if", IF },
+  { "else", ELSE },
+  { "while", WHILE },
+  { "return", RETURN },
+  { "int", INT },
+  { "void", VOID }
+};
+
+/* lookup an identifier to see if it is a reserved word */
+/* uses linear search */
+static TokenType reservedLookup(char *s)
+{
+  int i;
+  for (i = 0; i < MAXRESERVED; i++)
+    if (!strcmp(s, reservedWords[i].str))
+      return reservedWords[i].tok;
+  return ID;
+}
+
+/* getToken returns the next token in the source */
+static TokenType getToken(void)
+{
+  int tokenStringIndex = 0;
+  TokenType currentToken = ERROR;
+  StateType state = START;
+  int save;
+  while (state != DONE)
+  {
+    int c = getNextChar();
+    save = TRUE;
+
+    switch (state) {
+    case START:
+      if (isdigit(c)) {
+        state = INNUM;
+      } else if (isalpha(c)) {
+        state = INID;
+      } else if (c == '<') {
+        state = IN_LT_OR_LE;
+      } else if (c == '>') {
+        state = IN_GT_OR_GE;
+      } else if (c == '=') {
+        state = IN_ASSIGN_OR_EQUAL;
+      } else if (c == '/') {
+        save = FALSE;
+        state = IN_OVER_OR_COMMENT;
+      } else if (c == '!') {
+        state = IN_NOT_EQUAL;
+      } else if ((c == ' ') || (c == '\t') || (c == '\n')) {
+        save = FALSE;
+      } else {
+        state = DONE;
+        switch (c) {
+        case EOF: save = FALSE; currentToken = ENDFILE; break;
+        case '+': currentToken = PLUS; break;
+        case '-': currentToken = MINUS; break;
+        case '*': currentToken = TIMES; break;
+        case '(': currentToken = LPAREN; break;
+        case ')': currentToken = RPAREN; break;
+        case '[': currentToken = LBRACE; break;
+        case ']': currentToken = RBRACE; break;
+        case '{': currentToken = LCURLY; break;
+        case '}': currentToken = RCURLY; break;
+        case ',': currentToken = COMMA; break;
+        case ';': currentToken = SEMI; break;
+        default: currentToken = ERROR; break;
+        }
+      }
+      break;
+    case IN_OVER_OR_COMMENT:
+      if (c == '*') {
+        save = FALSE;
+        state = INCOMMENT;
+      } else {
+        ungetNextChar();
+        state = DONE;
+        c = '/';
+        currentToken = OVER;
+      }
+      break;
+    case INCOMMENT:
+      save = FALSE;
+      if (c == EOF) {
+        state = DONE;
+        currentToken = ENDFILE;
+      } else if (c == '*') {
+        state = IN_COMMENT_END;
+      }
+      break;
+    case IN_COMMENT_END:
+      save = FALSE;
+      if (c == '/') {
+        state = START;
+      } else {
+        ungetNextChar();
+        state = INCOMMENT;
+      }
+      break;
+    case IN_ASSIGN_OR_EQUAL:
+      state = DONE;
+      if (c == '=') {
+        currentToken = EQ;
+      } else {
+        ungetNextChar();
+        save = FALSE;
+        currentToken = ASSIGN;
+      }
+      break;
+    case IN_NOT_EQUAL:
+      state = DONE;
+      if (c == '=') {
+        currentToken = NE;
+      } else {
+        ungetNextChar();
+        save = FALSE;
+        currentToken = ERROR;
+      }
+      break;
+    case IN_LT_OR_LE:
+      state = DONE;
+      if (c == '=') {
+        currentToken = LE;
+      } else {
+        ungetNextChar();
+        save = FALSE;
+        currentToken = LT;
+      }
+      break;
+    case IN_GT_OR_GE:
+      state = DONE;
+      if (c == '=') {
+        currentToken = GE;
+      } else {
+        ungetNextChar();
+        save = FALSE;
+        currentToken = GT;
+      }
+      break;
+    case INNUM:
+      if (!isdigit(c)) {
+        ungetNextChar();
+        save = FALSE;
+        state = DONE;
+        currentToken = NUM;
+      }
+      break;
+    case INID:
+      if (!isalpha(c) && !isdigit(c)) {
+        ungetNextChar();
+        save = FALSE;
+        state = DONE;
+        currentToken = ID;
+      }
+      break;
+    case DONE:
+    default:
+      state = DONE;
+      currentToken = ERROR;
+      break;
+    }
+
+    if ((save) && (tokenStringIndex <= BASE_MAXTOKENLEN))
+      tokenString[tokenStringIndex++] = (char)c;
+    if (state == DONE)
+    {
+      tokenString[tokenStringIndex] = '\0';
+      if (currentToken == ID)
+        currentToken = reservedLookup(tokenString);
+    }
+  }
+  return currentToken;
+}
+
+/* seconds returns a monotonic time in seconds */
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  double best = 0;
+  int count = 0, i;
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <file>\n", argv[0]);
+    return 1;
+  }
+  source = fopen(argv[1], "r");
+  listing = stdout;
+  if (source == NULL || !loadSource(&srcBuf, source))
+  {
+    fprintf(stderr, "File %s not found\n", argv[1]);
+    return 1;
+  }
+  for (i = 0; i < RUNS; i++)
+  {
+    double t;
+    bufPos = lineEnd = srcBuf.text;
+    bufEnd = srcBuf.text + srcBuf.size;
+    EOF_flag = FALSE;
+    lineno = 0;
+    count = 0;
+    t = seconds();
+    do
+      count++;
+    while (getToken() != ENDFILE);
+    t = seconds() - t;
+    if (i == 0 || t < best)
+      best = t;
+  }
+  printf("  %s: %.1f MB, %d tokens, %d lines: %.3f s, %.0f MB/s\n",
+         argv[1], srcBuf.size / 1e6, count, lineno, best, srcBuf.size / 1e6 / best);
+  releaseSource(&srcBuf);
+  fclose(source);
+  return 0;
+}
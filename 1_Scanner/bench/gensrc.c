@@ -0,0 +1,135 @@
+/****************************************************/
+/* File: gensrc.c                                   */
+/* Generates C-Minus sources for the scanner        */
+/* benchmark (make bench)                           */
+/* usage: gensrc comments|idents <megabytes>        */
+/*   comments: functions about half block comments  */
+/*   and indentation by size                        */
+/*   idents: functions dense in identifiers and     */
+/*   reserved words                                 */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* words of the generated comments */
+static const char *words[] = {
+  "the", "value", "of", "each", "element", "is", "checked", "against",
+  "limit", "before", "loop", "ends", "and", "result", "returned", "to",
+  "caller", "index", "array", "counts", "from", "zero", "up"
+};
+#define NWORDS (int)(sizeof(words) / sizeof(words[0]))
+
+/* NNAMES = identifiers used by the idents input */
+#define NNAMES 256
+
+static char names[NNAMES][12];
+
+static unsigned long seed = 12345;
+
+/* nextRandom returns a pseudo-random number below n,
+   the same sequence on every run */
+static int nextRandom(int n)
+{
+  seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+  return (int)((seed >> 33) % (unsigned long)n);
+}
+
+/* comment writes a block comment of lines lines,
+   indented by indent blanks */
+static long comment(int indent, int lines)
+{
+  long size = 0;
+  int i, j;
+  size += printf("%*s/*", indent, "");
+  for (i = 0; i < lines; i++)
+  {
+    if (i > 0)
+      size += printf("%*s *", indent, "");
+    for (j = 0; j < 4 + nextRandom(5); j++)
+      size += printf(" %s", words[nextRandom(NWORDS)]);
+    size += printf("\n");
+  }
+  size += printf("%*s */\n", indent, "");
+  return size;
+}
+
+/* commentedFunction writes function number n with
+   a comment above it and inside its body */
+static long commentedFunction(int n)
+{
+  long size = 0;
+  size += comment(0, 1 + nextRandom(2));
+  size += printf("int f%d(int a, int b)\n{\n", n);
+  size += printf("    int x;\n    int i;\n");
+  if (nextRandom(2) == 0)
+    size += comment(4, 1);
+  size += printf("    x = a + b * %d;\n", nextRandom(100));
+  size += printf("    i = 0;\n");
+  size += printf("    while (i < %d)\n    {\n", 1 + nextRandom(10));
+  size += printf("        if (x > %d)\n", nextRandom(1000));
+  size += printf("            x = x - i;\n");
+  size += printf("        else\n            x = x + i * 2;\n");
+  size += printf("        i = i + 1;\n    }\n");
+  size += printf("    return x;\n}\n\n");
+  return size;
+}
+
+/* makeNames fills names with lower-case identifiers
+   of 2 to 11 letters, many as long as a reserved
+   word and sharing its first or last letter */
+static void makeNames(void)
+{
+  int i, j;
+  for (i = 0; i < NNAMES; i++)
+  {
+    int len = 2 + nextRandom(10);
+    for (j = 0; j < len; j++)
+      names[i][j] = "eirtvwnlsdaou"[nextRandom(13)];
+    names[i][len] = '\0';
+  }
+}
+
+/* name returns one of names at random */
+static const char *name(void)
+{
+  return names[nextRandom(NNAMES)];
+}
+
+/* identFunction writes function number n, whose
+   statements are mostly identifiers */
+static long identFunction(int n)
+{
+  long size = 0;
+  int i;
+  size += printf("int g%d(int %s, int %s)\n{\n", n, name(), name());
+  for (i = 0; i < 6; i++)
+    size += printf("    int %s;\n", name());
+  for (i = 0; i < 12; i++)
+    size += printf("    %s = %s + %s * %s - %s;\n", name(), name(), name(), name(), name());
+  size += printf("    if (%s < %s)\n        return %s;\n", name(), name(), name());
+  size += printf("    else\n        %s = %s;\n", name(), name());
+  size += printf("    while (%s != %s)\n        %s = %s;\n", name(), name(), name(), name());
+  size += printf("    return %s;\n}\n\n", name());
+  return size;
+}
+
+int main(int argc, char *argv[])
+{
+  long limit, size = 0;
+  int n = 0, idents;
+  if (argc != 3 || (strcmp(argv[1], "comments") != 0 && strcmp(argv[1], "idents") != 0))
+  {
+    fprintf(stderr, "usage: %s comments|idents <megabytes>\n", argv[0]);
+    return 1;
+  }
+  idents = strcmp(argv[1], "idents") == 0;
+  limit = atol(argv[2]) * 1000000L;
+  if (idents)
+    makeNames();
+  while (size < limit)
+    size += idents ? identFunction(n++) : commentedFunction(n++);
+  printf("void main(void)\n{\n    output(%s0(1, 2));\n}\n", idents ? "g" : "f");
+  return 0;
+}
@@ -0,0 +1,142 @@
+/****************************************************/
+/* File: kwbench.c                                  */
+/* Reserved word classification benchmark (make     */
+/* bench): classifies every identifier and reserved */
+/* word of a source file with the perfect hash of   */
+/* keyword.c and with the linear strcmp search it   */
+/* replaced                                         */
+/* usage: kwbench <file>                            */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "scan.h"
+#include "srcbuf.h"
+#include "keyword.h"
+
+/* LOOKUPS = classifications timed for each method,
+   at least; the words are classified in whole passes */
+#define LOOKUPS 50000000L
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int Error = FALSE;
+
+/* the table and search of the scanner before the
+   perfect hash, which looked up a copy of the lexeme
+   in tokenString */
+static struct
+{
+  char *str;
+  TokenType tok;
+} reservedWords[MAXRESERVED] = {
+  { "if", IF },
+  { "else", ELSE },
+  { "while", WHILE },
+  { "return", RETURN },
+  { "int", INT },
+  { "void", VOID }
+};
+
+static TokenType linearLookup(char *s)
+{
+  int i;
+  for (i = 0; i < MAXRESERVED; i++)
+    if (!strcmp(s, reservedWords[i].str))
+      return reservedWords[i].tok;
+  return ID;
+}
+
+/* seconds returns a monotonic time in seconds */
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  SourceBuffer buf;
+  TokenArray tokens;
+  unsigned int *start, *length;
+  long hashed = 0, linear = 0, lookups;
+  int nwords = 0, passes, pass, w, k;
+  double t1, t2;
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <file>\n", argv[0]);
+    return 1;
+  }
+  source = fopen(argv[1], "r");
+  listing = stdout;
+  if (source == NULL || !loadSource(&buf, source))
+  {
+    fprintf(stderr, "File %s not found\n", argv[1]);
+    return 1;
+  }
+  memset(&tokens, 0, sizeof(tokens));
+  tokenize(buf.text, buf.size, &tokens);
+
+  /* the words: identifiers and reserved words */
+  start = malloc(tokens.count * sizeof(unsigned int));
+  length = malloc(tokens.count * sizeof(unsigned int));
+  if (start == NULL || length == NULL)
+  {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+  for (k = 0; k < tokens.count; k++)
+    if (tokens.kind[k] == ID || (tokens.kind[k] >= IF && tokens.kind[k] <= VOID))
+    {
+      start[nwords] = tokens.offset[k];
+      length[nwords++] = tokens.length[k];
+    }
+  if (nwords == 0)
+  {
+    fprintf(stderr, "No identifiers in %s\n", argv[1]);
+    return 1;
+  }
+
+  passes = (int)((LOOKUPS + nwords - 1) / nwords);
+  lookups = (long)passes * nwords;
+
+  t1 = seconds();
+  for (pass = 0; pass < passes; pass++)
+    for (w = 0; w < nwords; w++)
+      if (reservedLookup(buf.text + start[w], length[w]) != ID)
+        hashed++;
+  t1 = seconds() - t1;
+
+  t2 = seconds();
+  for (pass = 0; pass < passes; pass++)
+    for (w = 0; w < nwords; w++)
+    {
+      int n = length[w] > MAXTOKENLEN ? MAXTOKENLEN : (int)length[w];
+      memcpy(tokenString, buf.text + start[w], n);
+      tokenString[n] = '\0';
+      if (linearLookup(tokenString) != ID)
+        linear++;
+    }
+  t2 = seconds() - t2;
+
+  printf("  %d words, %ld lookups each, reserved %ld / %ld\n",
+         nwords, lookups, hashed, linear);
+  printf("  perfect hash:  %.2f ns/word\n", t1 * 1e9 / lookups);
+  printf("  linear strcmp: %.2f ns/word\n", t2 * 1e9 / lookups);
+  free(start);
+  free(length);
+  releaseSource(&buf);
+  fclose(source);
+  return 0;
+}
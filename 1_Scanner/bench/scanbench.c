@@ -0,0 +1,75 @@
+/****************************************************/
+/* File: scanbench.c                                */
+/* Scanner throughput benchmark (make bench):       */
+/* tokenizes a source file several times and        */
+/* reports the best time                            */
+/* usage: scanbench <file>                          */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "scan.h"
+#include "srcbuf.h"
+
+/* RUNS = times the file is tokenized */
+#define RUNS 10
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+
+int Error = FALSE;
+
+/* seconds returns a monotonic time in seconds */
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+  SourceBuffer buf;
+  TokenArray tokens;
+  double best = 0;
+  int i;
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <file>\n", argv[0]);
+    return 1;
+  }
+  source = fopen(argv[1], "r");
+  listing = stdout;
+  if (source == NULL || !loadSource(&buf, source))
+  {
+    fprintf(stderr, "File %s not found\n", argv[1]);
+    return 1;
+  }
+  memset(&tokens, 0, sizeof(tokens));
+  for (i = 0; i < RUNS; i++)
+  {
+    double t;
+    tokens.count = 0;
+    tokens.lineBytes = 0;
+    tokens.lastLine = 0;
+    t = seconds();
+    tokenize(buf.text, buf.size, &tokens);
+    t = seconds() - t;
+    if (i == 0 || t < best)
+      best = t;
+  }
+  printf("  %s: %.1f MB, %d tokens, %d lines: %.3f s, %.0f MB/s\n",
+         argv[1], buf.size / 1e6, tokens.count, lineno, best, buf.size / 1e6 / best);
+  releaseSource(&buf);
+  fclose(source);
+  return 0;
+}
@@ -8,6 +8,8 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "skip.h"
+#include "keyword.h"
 
 /* states in scanner DFA */
 typedef enum
@@ -25,96 +27,87 @@ typedef enum
   DONE
 } StateType;
 
-/* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN + 1];
+static const char *bufStart = NULL; /* first character of the source text */
+static const char *bufPos = NULL;   /* next character to be read */
+static const char *lineEnd = NULL;  /* one past the end of the current line */
+static const char *bufEnd = NULL;   /* one past the last character of source */
+static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
 
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
+/* first character of the token being scanned; the
+   lexeme is the slice [tokenStart, bufPos) */
+static const char *tokenStart = NULL;
 
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0;      /* current position in LineBuf */
-static int bufsize = 0;      /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
+/* fetchLine makes the line starting at bufPos
+   the current line */
+static void fetchLine(void)
+{
+  lineno++;
+  lineEnd = memchr(bufPos, '\n', bufEnd - bufPos);
+  lineEnd = (lineEnd == NULL) ? bufEnd : lineEnd + 1;
+}
 
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
+/* getNextChar fetches the next character of the
+   current line, advancing to the next line of the
+   in-memory source when the current one is exhausted */
 static int getNextChar(void)
 {
-  if (!(linepos < bufsize))
+  if (!(bufPos < lineEnd))
   {
-    lineno++;
-    if (fgets(lineBuf, BUFLEN - 1, source))
+    if (bufPos < bufEnd)
     {
-      if (EchoSource)
-        fprintf(listing, "%4d: %s", lineno, lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
+      fetchLine();
+      return *bufPos++;
     }
     else
     {
+      lineno++;
       EOF_flag = TRUE;
       return EOF;
     }
   }
   else
-    return lineBuf[linepos++];
+    return *bufPos++;
 }
 
-/* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
+/* jumpTo moves the read position forward to q,
+   leaving lineno and the current line as if every
+   character before q had been read by getNextChar */
+static void jumpTo(const char *q)
 {
-  if (!EOF_flag)
-    linepos--;
+  if (q > lineEnd)
+  { /* count the lines starting before q in bulk */
+    lineno += 1 + countNewlines(lineEnd, q - 1);
+    lineEnd = memchr(q - 1, '\n', bufEnd - (q - 1));
+    lineEnd = (lineEnd == NULL) ? bufEnd : lineEnd + 1;
+  }
+  bufPos = q;
 }
 
-/* lookup table of reserved words */
-static struct
-{
-  char *str;
-  TokenType tok;
-} reservedWords[MAXRESERVED] = {
-  { "if", IF },
-  { "else", ELSE },
-  { "while", WHILE },
-  { "return", RETURN },
-  { "int", INT },
-  { "void", VOID }
-};
-
-/* lookup an identifier to see if it is a reserved word */
-/* uses linear search */
-static TokenType reservedLookup(char *s)
+/* ungetNextChar backtracks one character
+   in the current line */
+static void ungetNextChar(void)
 {
-  int i;
-  for (i = 0; i < MAXRESERVED; i++)
-    if (!strcmp(s, reservedWords[i].str))
-      return reservedWords[i].tok;
-  return ID;
+  if (!EOF_flag)
+    bufPos--;
 }
 
 /****************************************/
 /* the primary function of the scanner  */
 /****************************************/
-/* function getToken returns the
- * next token in source file
+/* function scanToken returns the next token
+ * of the source text
  */
-TokenType getToken(void)
-{ /* index for storing into tokenString */
-  int tokenStringIndex = 0;
-  /* holds current token to be returned */
+static TokenType scanToken(void)
+{ /* holds current token to be returned */
   TokenType currentToken;
   /* current state - always begins at START */
   StateType state = START;
-  /* flag to indicate save to tokenString */
-  int save;
   while (state != DONE)
   {
-    int c = getNextChar();
-    save = TRUE;
+    int c;
+    if (state == START)
+      tokenStart = bufPos;
+    c = getNextChar();
 
     switch (state) {
     case START:
@@ -129,17 +122,15 @@ TokenType getToken(void)
       } else if (c == '=') {
         state = IN_ASSIGN_OR_EQUAL;
       } else if (c == '/') {
-        save = FALSE;
         state = IN_OVER_OR_COMMENT;
       }  else if (c == '!') {
         state = IN_NOT_EQUAL;
       } else if ((c == ' ') || (c == '\t') || (c == '\n')) {
-        save = FALSE;
+        jumpTo(skipBlanks(bufPos, bufEnd));
       } else {
         state = DONE;
         switch (c) {
         case EOF:
-          save = FALSE;
           currentToken = ENDFILE;
           break;
         case '+':
@@ -183,19 +174,23 @@ TokenType getToken(void)
       break;
     case IN_OVER_OR_COMMENT:
       if (c == '*') {
-        save = FALSE;
-        state = INCOMMENT;
+        /* jump over the whole comment body at once; an
+           unclosed comment runs to EOF in INCOMMENT */
+        const char *commentEnd = findCommentEnd(bufPos, bufEnd);
+        if (commentEnd != NULL) {
+          jumpTo(commentEnd);
+          state = START;
+        } else {
+          jumpTo(bufEnd);
+          state = INCOMMENT;
+        }
       } else {
         ungetNextChar();
         state = DONE;
-        // /이 들어온 시점에서는 다음 토큰이 나누기인지, 주석 시작인지 알 수 없기 때문에 tokenString에 저장할 수 없음
-        // 따라서 나누기임이 확정된 현재 시점에 /을 tokenString에 저장하도록 c를 변경함
-        c = '/';
         currentToken = OVER;
       }
       break;
     case INCOMMENT:
-      save = FALSE;
       if (c == EOF) {
         state = DONE;
         currentToken = ENDFILE;
@@ -204,12 +199,10 @@ TokenType getToken(void)
       }
       break;
     case IN_COMMENT_END:
-      save = FALSE;
       if (c == '/') {
         state = START;
       } else {
         ungetNextChar();
-        save = FALSE;
         state = INCOMMENT;
       }
       break;
@@ -220,7 +213,6 @@ TokenType getToken(void)
       } else {
         /* backup in the input */
         ungetNextChar();
-        save = FALSE;
         currentToken = ASSIGN;
       }
       break;
@@ -230,7 +222,6 @@ TokenType getToken(void)
         currentToken = NE;
       } else {
         ungetNextChar();
-        save = FALSE;
         currentToken = ERROR;
       }
       break;
@@ -240,7 +231,6 @@ TokenType getToken(void)
         currentToken = LE;
       } else {
         ungetNextChar();
-        save = FALSE;
         currentToken = LT;
       }
       break;
@@ -250,7 +240,6 @@ TokenType getToken(void)
         currentToken = GE;
       } else {
         ungetNextChar();
-        save = FALSE;
         currentToken = GT;
       }
       break;
@@ -258,7 +247,6 @@ TokenType getToken(void)
       if (!isdigit(c))
       { /* backup in the input */
         ungetNextChar();
-        save = FALSE;
         state = DONE;
         currentToken = NUM;
       }
@@ -267,7 +255,6 @@ TokenType getToken(void)
       if (!isalpha(c) && !isdigit(c))
       { /* backup in the input */
         ungetNextChar();
-        save = FALSE;
         state = DONE;
         currentToken = ID;
       }
@@ -279,20 +266,28 @@ TokenType getToken(void)
       currentToken = ERROR;
       break;
     }
-
-    if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-      tokenString[tokenStringIndex++] = (char)c;
-    if (state == DONE)
-    {
-      tokenString[tokenStringIndex] = '\0';
-      if (currentToken == ID)
-        currentToken = reservedLookup(tokenString);
-    }
-  }
-  if (TraceScan)
-  {
-    fprintf(listing, "\t%d: ", lineno);
-    printToken(currentToken, tokenString);
   }
+  if (currentToken == ID)
+    currentToken = reservedLookup(tokenStart, bufPos - tokenStart);
+  if (currentToken == ENDFILE)
+    bufPos = tokenStart = bufEnd;
   return currentToken;
-} /* end getToken */
+} /* end scanToken */
+
+/* Procedure tokenize scans the size characters at
+ * text and appends every token, up to and including
+ * ENDFILE, to tokens
+ */
+void tokenize(const char *text, size_t size, TokenArray *tokens)
+{
+  TokenType currentToken;
+  bufStart = bufPos = lineEnd = text;
+  bufEnd = text + size;
+  EOF_flag = FALSE;
+  lineno = 0;
+  do
+  {
+    currentToken = scanToken();
+    appendToken(tokens, currentToken, lineno, tokenStart - bufStart, bufPos - tokenStart);
+  } while (currentToken != ENDFILE);
+}
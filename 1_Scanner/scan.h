@@ -11,12 +11,54 @@
 /* MAXTOKENLEN is the maximum size of a token */
 #define MAXTOKENLEN 40
 
-/* tokenString array stores the lexeme of each token */
+/* tokenString array stores the lexeme of each token
+ * (filled on demand by currentTokenString)
+ */
 extern char tokenString[MAXTOKENLEN+1];
 
-/* function getToken returns the 
+/* TokenArray holds the whole token stream of a source
+ * buffer as parallel arrays. Lexemes are not copied:
+ * each token is an (offset, length) slice of the text
+ * it was scanned from. Line numbers are packed: each
+ * one is the varint (7 bits a byte, low bits first)
+ * of its difference from the line of the token before
+ * it, or from 0 for the first token, so most tokens
+ * take one byte. They are read back in token order
+ */
+typedef struct
+{
+  int count;             /* number of tokens, ENDFILE included */
+  int capacity;          /* allocated length of each array */
+  unsigned short *kind;  /* TokenType of each token */
+  unsigned char *lines;  /* packed source line of each token */
+  int lineBytes;         /* bytes used in lines */
+  int lineCapacity;      /* allocated length of lines */
+  int lastLine;          /* line of the last token, base of the next delta */
+  unsigned int *offset;  /* start of the lexeme in the text */
+  unsigned int *length;  /* length of the lexeme */
+} TokenArray;
+
+/* Procedure tokenize scans the size characters at
+ * text and appends every token, up to and including
+ * ENDFILE, to tokens
+ */
+void tokenize(const char *text, size_t size, TokenArray *tokens);
+
+/* Procedure appendToken adds one token to the end
+ * of tokens, growing the arrays when needed
+ */
+void appendToken(TokenArray *tokens, TokenType kind, int lineno,
+                 unsigned int offset, unsigned int length);
+
+/* function getToken returns the
  * next token in source file
  */
 TokenType getToken(void);
 
+/* Function currentTokenString copies the lexeme of
+ * the token last returned by getToken into
+ * tokenString and returns it
+ */
+char *currentTokenString(void);
+
 #endif
@@ -0,0 +1,166 @@
+/****************************************************/
+/* File: tokens.c                                   */
+/* Token array and token cursor shared by the       */
+/* hand-written and the flex C-Minus scanners       */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "srcbuf.h"
+
+/* INITTOKENS = initial capacity of the token array */
+#define INITTOKENS 4096
+
+/* MAXVARINT = most bytes a packed line delta takes */
+#define MAXVARINT 5
+
+/* lexeme of the current token */
+char tokenString[MAXTOKENLEN + 1];
+
+static SourceBuffer srcBuf; /* whole text of the source file */
+static TokenArray tokens;   /* token stream of srcBuf */
+static int current = -1;    /* index of the token last returned */
+static int linePos = 0;     /* packed line of the next token */
+static int currentLine = 0; /* line of the token last returned */
+
+/* echo position for EchoSource: the next line
+   to be listed and its line number */
+static const char *echoPos = NULL;
+static int echoLine = 0;
+
+/* growArray reallocates one of the token arrays */
+static void *growArray(void *array, int capacity, size_t elemSize)
+{
+  void *grown = realloc(array, capacity * elemSize);
+  if (grown == NULL)
+  {
+    fprintf(listing, "Out of memory error at line %d\n", lineno);
+    exit(1);
+  }
+  return grown;
+}
+
+/* packLine appends line as the varint of its
+   difference from the line of the last token */
+static void packLine(TokenArray *tokens, int line)
+{
+  unsigned int delta = (unsigned int)(line - tokens->lastLine);
+  if (tokens->lineCapacity - tokens->lineBytes < MAXVARINT)
+  {
+    tokens->lineCapacity = (tokens->lineCapacity == 0) ? INITTOKENS : tokens->lineCapacity * 2;
+    tokens->lines = growArray(tokens->lines, tokens->lineCapacity, 1);
+  }
+  while (delta >= 0x80)
+  {
+    tokens->lines[tokens->lineBytes++] = (unsigned char)(delta | 0x80);
+    delta >>= 7;
+  }
+  tokens->lines[tokens->lineBytes++] = (unsigned char)delta;
+  tokens->lastLine = line;
+}
+
+/* unpackLine returns the line of the token whose
+   packed delta starts at *pos, given the line of
+   the token before it, and moves *pos past it */
+static int unpackLine(const TokenArray *tokens, int *pos, int line)
+{
+  unsigned int delta = 0;
+  int shift = 0;
+  unsigned char byte;
+  do
+  {
+    byte = tokens->lines[(*pos)++];
+    delta |= (unsigned int)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return (int)((unsigned int)line + delta);
+}
+
+/* Procedure appendToken adds one token to the end
+ * of tokens, growing the arrays when needed
+ */
+void appendToken(TokenArray *tokens, TokenType kind, int lineno,
+                 unsigned int offset, unsigned int length)
+{
+  int i = tokens->count;
+  if (i == tokens->capacity)
+  {
+    tokens->capacity = (i == 0) ? INITTOKENS : i * 2;
+    tokens->kind = growArray(tokens->kind, tokens->capacity, sizeof(unsigned short));
+    tokens->offset = growArray(tokens->offset, tokens->capacity, sizeof(unsigned int));
+    tokens->length = growArray(tokens->length, tokens->capacity, sizeof(unsigned int));
+  }
+  tokens->kind[i] = (unsigned short)kind;
+  packLine(tokens, lineno);
+  tokens->offset[i] = offset;
+  tokens->length[i] = length;
+  tokens->count++;
+}
+
+/* echoThrough lists every source line up to
+   and including line number last */
+static void echoThrough(int last)
+{
+  const char *end = srcBuf.text + srcBuf.size;
+  while (echoLine < last && echoPos < end)
+  {
+    const char *eol = memchr(echoPos, '\n', end - echoPos);
+    eol = (eol == NULL) ? end : eol + 1;
+    echoLine++;
+    fprintf(listing, "%4d: %.*s", echoLine, (int)(eol - echoPos), echoPos);
+    echoPos = eol;
+  }
+}
+
+/* function getToken returns the
+ * next token in source file
+ */
+TokenType getToken(void)
+{
+  TokenType currentToken;
+  if (current < 0)
+  {
+    if (!loadSource(&srcBuf, source))
+    {
+      fprintf(listing, "Unable to read source file\n");
+      exit(1);
+    }
+    tokenize(srcBuf.text, srcBuf.size, &tokens);
+    echoPos = srcBuf.text;
+  }
+  /* stay on ENDFILE once it has been reached */
+  if (current < tokens.count - 1)
+  {
+    current++;
+    currentLine = unpackLine(&tokens, &linePos, currentLine);
+  }
+  currentToken = tokens.kind[current];
+  lineno = currentLine;
+  if (EchoSource)
+    echoThrough(lineno);
+  if (TraceScan)
+  {
+    fprintf(listing, "\t%d: ", lineno);
+    printToken(currentToken, currentTokenString());
+  }
+  return currentToken;
+}
+
+/* Function currentTokenString copies the lexeme of
+ * the token last returned by getToken into
+ * tokenString and returns it
+ */
+char *currentTokenString(void)
+{
+  unsigned int n = 0;
+  if (current >= 0)
+  {
+    n = tokens.length[current];
+    if (n > MAXTOKENLEN)
+      n = MAXTOKENLEN;
+    memcpy(tokenString, srcBuf.text + tokens.offset[current], n);
+  }
+  tokenString[n] = '\0';
+  return tokenString;
+}
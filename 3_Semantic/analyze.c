@@ -8,352 +8,406 @@
 
 #include "globals.h"
 #include "symtab.h"
+#include "visit.h"
+#include "compact.h"
+#include "sigtab.h"
+#include "pool.h"
+#include "diag.h"
+#include "parse.h"
 #include "analyze.h"
 
-
-typedef void (* TraverseInvokeFun) (TreeNode *, ScopeList);
-
-static void printUndeclaredFunctionError (char *name, int line) {
-  fprintf(listing, "Error: Undeclared function \"%s\" is called at line %d\n", name, line);
-}
-
-static void printUndeclaredVariableError (char *name, int line) {
-  fprintf(listing, "Error: Undeclared variable \"%s\" is used at line %d\n", name, line);
-}
-
-static void printRedefineError (char* name, int line) {
-  fprintf(listing, "Error: Symbol \"%s\" is redefined at line %d\n", name, line);
-}
-
-static void printNonIntegerIndexError (char *name, int line) {
-  fprintf(listing, "Error: Invalid array indexing at line %d (name : \"%s\"). Indicies should be integer\n", line, name);
-}
-
-static void printNonArrayIndexingError (char *name, int line) {
-  fprintf(listing, "Error: Invalid array indexing at line %d (name : \"%s\"). Indexing can only be allowed for int[] variables\n", line, name);
-}
-
-static void printInvalidFunctionCall (char *name, int line) {
-  fprintf(listing, "Error: Invalid function call at line %d (name : \"%s\")\n", line, name);
-}
-
-static void printVoidVariableError (char* name, int line) {
-  fprintf(listing, "Error: The void-type variable is declared at line %d (name : \"%s\")\n", line, name);
-}
-
-static void printInvalidOperation (int line) {
-  fprintf(listing, "Error: Invalid operation at line %d\n", line);
-}
-
-static void printInvalidAssignment (int line) {
-  fprintf(listing, "Error: Invalid assignment at line %d\n", line);
-}
-
-static void printInvalidCondition (int line) {
-  fprintf(listing, "Error: Invalid condition at line %d\n", line); 
-}
-
-static void printInvalidReturn (int line) {
-  fprintf(listing, "Error: Invalid return at line %d\n", line);
+/* Reference is a use of a global symbol found by a
+   thread checking a function body; it is added to the
+   line index once all bodies are done, in job order */
+typedef struct {
+  BucketList symbol;
+  int lineno;
+} Reference;
+
+/* AnalyzerRec is the whole state of one analysis;
+   the thread pool gives every function body a copy
+   that records into the segment of its declaration */
+struct AnalyzerRec {
+  ScopeList global;
+  int isNextCompoundFunctionBody; /* set by a FunK node: its body does not open a scope */
+  DiagBuffer *diagnostics; /* where errors go: own, or a declaration's segment */
+  DiagBuffer own;
+  struct FunctionJob *job; /* body checked by the thread pool, or NULL */
+};
+
+/* FunctionJob is the body of one function declaration,
+   checked by the thread pool against the frozen global
+   scope */
+typedef struct FunctionJob {
+  TreeNode *decl;
+  struct AnalyzerRec context;
+  Reference *refs;
+  int refCount;
+  int refCapacity;
+} FunctionJob;
+
+static void report (Analyzer a, DiagKind kind, int lineno, char *name) {
+  addDiagnostic(a->diagnostics, kind, lineno, name);
 }
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
- * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
- */
-static void traverse(TreeNode * t,
-               ScopeList currentScope,
-               TraverseInvokeFun preProc,
-               TraverseInvokeFun postProc)
-{
-  if (t == NULL) { 
-    return ;
-  }
-
-  preProc(t, currentScope);
-
-  ScopeList prevScope = NULL;
-  if (t->scope != NULL) {
-    prevScope = currentScope;
-    currentScope = t->scope;
-  }
-
-  for (int i=0; i < MAXCHILDREN; i++)
-    traverse(t->child[i], currentScope, preProc, postProc);
-
-  if (prevScope != NULL) {
-    currentScope = prevScope;
-  }
-
-  postProc(t, currentScope);
-  traverse(t->sibling, currentScope, preProc, postProc);
-}
-
-/* nullProc is a do-nothing procedure to 
- * generate preorder-only or postorder-only
- * traversals from traverse
- */
-static void nullProc(TreeNode * t, ScopeList scope)
-{ if (t==NULL) return;
-  else return;
-}
-
-
-static void insertVariableSymbol (TreeNode *t, ScopeList scope) {
-  BucketList sameNameSymbol = lookupScope(scope, t->attr.name, ALL_SYMBOL);
+static BucketList insertVariableSymbol (Analyzer a, char *name, ExpType type, int lineno, ScopeList scope) {
+  BucketList sameNameSymbol = lookupScope(scope, name, ALL_SYMBOL);
 
   if (sameNameSymbol != NULL) {
     // 현재 스코프에 같은 이름의 심볼이 있는 경우, redefine error가 발생. 
-    printRedefineError(t->attr.name, t->lineno);
-  } else if (t->type == Void || t->type == VoidArray) {
+    report(a, RedefinedSymbolDiag, lineno, name);
+  } else if (type == Void || type == VoidArray) {
     // redefine이 아니면서 void 타입 변수를 사용하는 경우, void-type variable error가 발생.
-    printVoidVariableError(t->attr.name, t->lineno);
+    report(a, VoidVariableDiag, lineno, name);
   }
 
   // 이후 타입 체크를 위해 중복 정의더라도 Fun / Var 각 하나씩은 저장
-  sameNameSymbol = lookupScope(scope, t->attr.name, ONLY_VAR_SYMBOL);
+  sameNameSymbol = lookupScope(scope, name, ONLY_VAR_SYMBOL);
   if (sameNameSymbol == NULL) {
-    insertSymbol(scope, t->attr.name, VarSymbol, t->type, t->lineno);
+    sameNameSymbol = insertSymbol(scope, name, VarSymbol, type, lineno);
   }
+  return sameNameSymbol;
 }
 
 
-static int insertFunctionSymbol (TreeNode *t, ScopeList scope) {
-  BucketList sameNameSymbol = lookupScope(scope, t->attr.name, ALL_SYMBOL);
+static BucketList insertFunctionSymbol (Analyzer a, char *name, ExpType type, int lineno, ScopeList scope) {
+  BucketList sameNameSymbol = lookupScope(scope, name, ALL_SYMBOL);
 
   if (sameNameSymbol != NULL) {
     // 현재 스코프에 같은 이름의 심볼이 있는 경우, redeclare error가 발생. 
-    printRedefineError(t->attr.name, t->lineno);
+    report(a, RedefinedSymbolDiag, lineno, name);
   }
 
   // 타입 체크를 위해 재정의라도 무조건 symbol에 추가해야함
-  return insertSymbol(scope, t->attr.name, FuncSymbol, t->type, t->lineno)->memloc;
+  return insertSymbol(scope, name, FuncSymbol, type, lineno);
 }
 
 
-static void insertParamSymbol (TreeNode *t, ScopeList scope) {
-  if (t->type == Void && t->attr.name == NULL) {
+static BucketList insertParamSymbol (Analyzer a, char *name, ExpType type, int lineno, ScopeList scope) {
+  if (type == Void && name == NULL) {
     // 파라미터가 없는 (void) 형태
-    return ;
+    return NULL;
   }
 
-  BucketList sameNameSymbol = lookupScope(scope, t->attr.name, ONLY_VAR_SYMBOL);
+  BucketList sameNameSymbol = lookupScope(scope, name, ONLY_VAR_SYMBOL);
 
   if (sameNameSymbol != NULL) {
     // 현재 스코프에 같은 이름의 심볼이 있는 경우 = 같은 이름의 파라미터가 앞에 존재하는 경우
-    printRedefineError(t->attr.name, t->lineno);
-    return ;
-  } else if (t->type == Void || t->type == VoidArray) {
+    report(a, RedefinedSymbolDiag, lineno, name);
+    return sameNameSymbol;
+  } else if (type == Void || type == VoidArray) {
     // 재정의가 아니면서, void 타입 변수를 쓰는 경우
-    printVoidVariableError(t->attr.name, t->lineno);
+    report(a, VoidVariableDiag, lineno, name);
   }
 
   // 함수 스코프 안에 변수 추가
-  insertSymbol(scope, t->attr.name, VarSymbol, t->type, t->lineno);
+  sameNameSymbol = insertSymbol(scope, name, VarSymbol, type, lineno);
 
   // 상위 스코프의 함수 심볼에 파라미터 타입 추가
-  addParameterType(scope, t->type);
+  addParameterType(scope, type);
+  return sameNameSymbol;
 }
 
-/* Procedure insertNode inserts 
- * identifiers stored in t into 
- * the symbol table 
+/**
+ * @brief symbol의 line index에 lineno를 추가합니다. 병렬로 함수 본문을 검사하는 중에
+ * global 심볼을 참조하면, 다른 스레드와 겹치지 않도록 job에 모아 두었다가 나중에 순서대로 추가합니다.
  */
-static void insertNode (TreeNode * t, ScopeList scope) {
-  static int isNextCompoundFunctionBody = FALSE;
-  int funcLocation = -1;
+static void recordReference (Analyzer a, BucketList symbol, int lineno) {
+  FunctionJob *job = a->job;
+
+  if (job == NULL || symbol->scope != a->global) {
+    addReference(symbol, lineno);
+    return;
+  }
+
+  if (job->refCount == job->refCapacity) {
+    job->refCapacity = job->refCapacity == 0 ? 64 : job->refCapacity * 2;
+    job->refs = realloc(job->refs, job->refCapacity * sizeof(Reference));
+    assert(job->refs != NULL);
+  }
+  job->refs[job->refCount].symbol = symbol;
+  job->refs[job->refCount].lineno = lineno;
+  job->refCount++;
+}
+
+/**
+ * @brief 노드 하나의 선언을 scope에 추가하고, 노드가 새 스코프를 여는 경우 그 스코프를 반환합니다.
+ * TreeNode와 CompactTree 양쪽의 insert 단계가 공유합니다.
+ *
+ * @param declared 선언 노드이면 선언된 심볼을 (코드 생성용으로) 저장합니다.
+ * @return ScopeList 새 스코프가 없으면 NULL을 반환합니다.
+ */
+static ScopeList enterNode (Analyzer a, NodeKind nodekind, int kind, char *name, ExpType type, int lineno, ScopeList scope, BucketList *declared) {
+  BucketList funcSymbol = NULL;
+  ScopeList newScope = NULL;
 
   // 선언으로부터 심볼 추가
-  if (t->nodekind == DeclK) {
-      switch (t->kind.decl) {
+  if (nodekind == DeclK) {
+      switch (kind) {
         case VarK: // 변수 선언
-          insertVariableSymbol(t, scope);
+          *declared = insertVariableSymbol(a, name, type, lineno, scope);
           break;
         case FunK: // 함수 선언
-          funcLocation = insertFunctionSymbol(t, scope);
-          isNextCompoundFunctionBody = TRUE;
+          *declared = funcSymbol = insertFunctionSymbol(a, name, type, lineno, scope);
+          a->isNextCompoundFunctionBody = TRUE;
           break;
         case ParamK: // 파라미터
-          insertParamSymbol(t, scope);
+          *declared = insertParamSymbol(a, name, type, lineno, scope);
           break;
       }
   }
 
   // Function Declaration 노드인 경우, 새로운 스코프를 생성
-  if (t->nodekind == DeclK && t->kind.decl == FunK) {
-    t->scope = createLocalScope(t->attr.name, scope);
-    t->scope->funcSymbolLocOnGlobal = funcLocation;
+  if (nodekind == DeclK && kind == FunK) {
+    newScope = createLocalScope(name, scope);
+    newScope->function = funcSymbol;
   }
 
   // Compound Statement면서, 부모가 Function Declaration 노드가 아닌 경우, 새로운 스코프를 생성
-  if (t->nodekind == StmtK && t->kind.stmt == CompoundK) {
-    if (!isNextCompoundFunctionBody) {
-      t->scope = createLocalScope(scope->name, scope);
-      t->scope->funcSymbolLocOnGlobal = scope->funcSymbolLocOnGlobal;
+  if (nodekind == StmtK && kind == CompoundK) {
+    if (!a->isNextCompoundFunctionBody) {
+      newScope = createLocalScope(scope->name, scope);
     } else {
-      isNextCompoundFunctionBody = FALSE;
+      // 파라미터가 모두 등록되었으므로 함수 시그니처는 여기서 한 번 intern
+      functionSignature(scope->function);
+      a->isNextCompoundFunctionBody = FALSE;
     }
   }
+
+  return newScope;
+}
+
+/* Procedure insertNode inserts 
+ * identifiers stored in t into 
+ * the symbol table 
+ */
+static void insertNode (TreeNode * t, ScopeList scope, void * context) {
+  Analyzer a = context;
+  ScopeList newScope;
+
+  if (t->nodekind == StmtK && t->kind.stmt == CompoundK && t->attr.lazy != NULL) {
+    // --lazy로 건너뛴 함수 본문은 처음 방문할 때 파싱 (자식을 읽기 전이므로 그대로 이어서 방문됨)
+    parseBody(t);
+  }
+
+  newScope = enterNode(a, t->nodekind, t->kind.stmt,
+    (t->nodekind == DeclK) ? t->attr.name : NULL, t->type, t->lineno, scope, &t->symbol);
+
+  if (newScope != NULL) {
+    t->scope = newScope;
+  }
 }
 
-static void printScopeOfNode (TreeNode *t, ScopeList scope) {
+static void printScopeOfNode (TreeNode *t, ScopeList scope, void *context) {
+  (void) scope;
+  (void) context;
   if (t->scope != NULL) {
     printScope(listing, t->scope);
   }
 }
 
-static void typeCheckSingleIdExpr (TreeNode *node, ScopeList scope) {
-  BucketList symbol = lookupScopeRecursive(scope, node->attr.name, ONLY_VAR_SYMBOL);
+static void printXrefOfNode (TreeNode *t, ScopeList scope, void *context) {
+  (void) scope;
+  (void) context;
+  if (t->scope != NULL) {
+    printXref(listing, t->scope);
+  }
+}
+
+/**
+ * @brief 변수 이름을 선언된 심볼로 resolve하고 참조한 줄을 심볼에 추가합니다. 결과는 IdK 노드에 기록되어,
+ * 이후 단계에서는 심볼 테이블을 다시 찾지 않고 memloc, scope에 접근합니다.
+ *
+ * @return BucketList 선언되지 않은 변수면 에러를 출력하고 NULL을 반환합니다.
+ */
+static BucketList lookupVariable (Analyzer a, char *name, int lineno, ScopeList scope) {
+  BucketList symbol = lookupScopeRecursive(scope, name, ONLY_VAR_SYMBOL);
 
   if (symbol == NULL) {
-    printUndeclaredVariableError(node->attr.name, node->lineno);
-    node->type = Unknown;
+    report(a, UndeclaredVariableDiag, lineno, name);
   } else {
-    node->type = symbol->type.varType;
+    recordReference(a, symbol, lineno);
   }
+  return symbol;
 }
 
-static void typeCheckArrayRefIdExpr (TreeNode *node, ScopeList scope) {
-  BucketList symbol = lookupScopeRecursive(scope, node->attr.name, ONLY_VAR_SYMBOL);
-  node->type = Integer;
+static ExpType typeCheckSingleIdExpr (BucketList symbol) {
+  if (symbol == NULL) {
+    return Unknown;
+  }
+  return symbol->type.varType;
+}
+
+static ExpType typeCheckArrayRefIdExpr (Analyzer a, BucketList symbol, char *name, int lineno, ExpType indexType) {
+  ExpType type = Integer;
 
   // symbol 정의 여부 확인
   if (symbol == NULL) {
-    printUndeclaredVariableError(node->attr.name, node->lineno);
-    node->type = Unknown;
+    type = Unknown;
   } else if (symbol->type.varType != IntegerArray) {
     // symbol 타입 확인
-    printNonArrayIndexingError(node->attr.name, node->lineno);
-    node->type = Unknown;
+    report(a, NonArrayIndexDiag, lineno, name);
+    type = Unknown;
   }
 
   // index 타입 확인
-  if (node->child[0]->type != Integer) {
-    printNonIntegerIndexError(node->attr.name, node->lineno);
+  if (indexType != Integer) {
+    report(a, NonIntegerIndexDiag, lineno, name);
   }
 
+  return type;
 }
 
-static void typeCheckAssignment (TreeNode *node, ScopeList scope) {
-  if (node->child[0]->type != Unknown
-  && node->child[1]->type != Unknown
-  && node->child[0]->type == node->child[1]->type
-  ) {
-    node->type = node->child[0]->type;
-  } else {
-    printInvalidAssignment(node->lineno);
-    node->type = Unknown;
+static ExpType typeCheckAssignment (Analyzer a, ExpType lhs, ExpType rhs, int lineno) {
+  if (lhs != Unknown && rhs != Unknown && lhs == rhs) {
+    return lhs;
   }
+  report(a, InvalidAssignmentDiag, lineno, NULL);
+  return Unknown;
 }
 
-static void typeCheckBinaryOp (TreeNode *node, ScopeList scope) {
-  if (node->child[0]->type != Integer || node->child[1]->type != Integer) {
-    printInvalidOperation(node->lineno);
-    node->type = Unknown;
-  } else {
-    node->type = Integer;
+static ExpType typeCheckBinaryOp (Analyzer a, ExpType lhs, ExpType rhs, int lineno) {
+  if (lhs != Integer || rhs != Integer) {
+    report(a, InvalidOperationDiag, lineno, NULL);
+    return Unknown;
   }
+  return Integer;
 }
 
-static void typeCheckCall (TreeNode *node, ScopeList scope) {
-  BucketList symbol = lookupScopeRecursive(scope, node->attr.name, ONLY_FUNC_SYMBOL);
+/**
+ * @brief 호출되는 함수 심볼을 찾고 참조한 줄을 심볼에 추가합니다. 결과는 CallK 노드에 기록됩니다.
+ *
+ * @return BucketList 선언되지 않은 함수면 에러를 출력하고 NULL을 반환합니다.
+ */
+static BucketList lookupCallee (Analyzer a, char *name, int lineno, ScopeList scope) {
+  BucketList symbol = lookupScopeRecursive(scope, name, ONLY_FUNC_SYMBOL);
 
   if (symbol == NULL) {
-    printUndeclaredFunctionError(node->attr.name, node->lineno);
-    node->type = Unknown;
-    return ;
+    report(a, UndeclaredFunctionDiag, lineno, name);
+  } else {
+    recordReference(a, symbol, lineno);
   }
+  return symbol;
+}
 
-  ParameterList p = symbol->type.funType.params;
-  TreeNode* arg = NULL;
+/* MAXLOCALARGS = arguments whose types fit in the
+   buffer on the stack when a call is checked */
+#define MAXLOCALARGS 16
 
-  if (node->child[0] != NULL) {
-    arg = node->child[0]->child[0];
-  }
+/**
+ * @brief 인자 타입 types[0..count-1]을 callee의 파라미터 타입과 비교합니다.
+ * 호출마다 시그니처를 intern하지 않으므로 lock을 잡지 않고, 틀린 호출의 시그니처도 남지 않습니다.
+ *
+ * @return int 맞는 호출이면 callee의 시그니처 id, 아니면 NO_SIGNATURE (ArgListK 노드에 저장)
+ */
+static int checkArguments (Analyzer a, BucketList symbol, ExpType *types, int count, char *name, int lineno) {
+  struct FunctionType *f = &symbol->type.funType;
 
-  // 파라미터가 아예 없으면 void 타입 -> NULL
-  // 리스트가 아예 없으면 void 타입 -> NULL
-  while (p != NULL && arg != NULL) {
-    if (p->type != arg->type) {
-      break;
-    }
+  if (count != f->paramCount || (count > 0 && memcmp(types, f->params, count * sizeof(ExpType)) != 0)) {
+    report(a, InvalidCallDiag, lineno, name);
+    return NO_SIGNATURE;
+  }
+  return f->signature;
+}
 
-    p = p->next;
-    arg = arg->sibling;
+static ExpType typeCheckCall (Analyzer a, TreeNode *node, BucketList symbol) {
+  if (symbol == NULL) {
+    return Unknown;
   }
 
-  if (p != NULL || arg != NULL) {
-    printInvalidFunctionCall(node->attr.name, node->lineno);
+  // 인자가 없으면 child[0]이 NULL (void 호출)
+  TreeNode *args = node->child[0];
+  TreeNode *arg;
+  ExpType local[MAXLOCALARGS];
+  ExpType *types = local;
+  int capacity = MAXLOCALARGS;
+  int count = 0;
+
+  for (arg = args ? args->child[0] : NULL; arg != NULL; arg = arg->sibling) {
+    if (count == capacity) {
+      ExpType *grown = realloc(types == local ? NULL : types, capacity * 2 * sizeof(ExpType));
+      assert(grown != NULL);
+      if (types == local) {
+        memcpy(grown, local, sizeof(local));
+      }
+      types = grown;
+      capacity *= 2;
+    }
+    types[count++] = arg->type;
   }
 
-  node->type = symbol->type.funType.returnType;
-}
+  int signature = checkArguments(a, symbol, types, count, node->attr.name, node->lineno);
+  if (args != NULL) {
+    args->signature = signature;
+  }
 
-static void typeCheckSelectStmt (TreeNode* node, ScopeList scope) {
-  if (node->child[0]->type != Integer) {
-    printInvalidCondition(node->child[0]->lineno);
+  if (types != local) {
+    free(types);
   }
+
+  return symbol->type.funType.returnType;
 }
 
-static void typeCheckIterStmt (TreeNode *node, ScopeList scope) {
-  if (node->child[0]->type != Integer) {
-    printInvalidCondition(node->child[0]->lineno);
+static void typeCheckCondition (Analyzer a, ExpType type, int lineno) {
+  if (type != Integer) {
+    report(a, InvalidConditionDiag, lineno, NULL);
   }
 }
 
-static void typeCheckRetStmt (TreeNode *node, ScopeList scope) {
-  BucketList symbol = lookupFunctionOnGlobalWithLocation(scope, scope->name, scope->funcSymbolLocOnGlobal);
+static void typeCheckRetStmt (Analyzer a, int hasValue, ExpType valueType, int lineno, ScopeList scope) {
+  BucketList symbol = scope->function;
   assert(symbol != NULL && symbol->kind == FuncSymbol);
 
-  if (node->child[0] == NULL) {
+  if (!hasValue) {
     if (symbol->type.funType.returnType != Void) {
-      printInvalidReturn(node->lineno);
+      report(a, InvalidReturnDiag, lineno, NULL);
     }
-  } else if (node->child[0]->type != symbol->type.funType.returnType) {
-    printInvalidReturn(node->lineno);
+  } else if (valueType != symbol->type.funType.returnType) {
+    report(a, InvalidReturnDiag, lineno, NULL);
   }
 }
 
 /* Procedure checkNode performs
  * type checking at a single tree node
  */
-static void checkNode(TreeNode * t, ScopeList scope) {
+static void checkNode(TreeNode * t, ScopeList scope, void * context) {
+  Analyzer a = context;
 
   switch (t->nodekind) {
     case ExpK:
       switch (t->kind.exp) {
         case IdK:
+          t->symbol = lookupVariable(a, t->attr.name, t->lineno, scope);
           if (t->child[0] == NULL) {
-            typeCheckSingleIdExpr(t, scope);
+            t->type = typeCheckSingleIdExpr(t->symbol);
           } else {
-            typeCheckArrayRefIdExpr(t, scope);
+            t->type = typeCheckArrayRefIdExpr(a, t->symbol, t->attr.name, t->lineno, t->child[0]->type);
           }
           break;
         case AssignK:
-          typeCheckAssignment(t, scope);
+          t->type = typeCheckAssignment(a, t->child[0]->type, t->child[1]->type, t->lineno);
           break;
         case ConstK:
           t->type = Integer;
           break;
         case BinaryOpK:
-          typeCheckBinaryOp(t, scope);
+          t->type = typeCheckBinaryOp(a, t->child[0]->type, t->child[1]->type, t->lineno);
           break;
         case CallK:
-          typeCheckCall(t, scope);
+          t->symbol = lookupCallee(a, t->attr.name, t->lineno, scope);
+          t->type = typeCheckCall(a, t, t->symbol);
           break;
       }
       break;
     case StmtK:
       switch (t->kind.stmt) {
         case SelectK:
-          typeCheckSelectStmt(t, scope);
-          break;
         case IterK:
-          typeCheckIterStmt(t, scope);
+          typeCheckCondition(a, t->child[0]->type, t->child[0]->lineno);
           break;
         case RetK:
-          typeCheckRetStmt(t, scope);
+          typeCheckRetStmt(a, t->child[0] != NULL,
+            (t->child[0] != NULL) ? t->child[0]->type : Unknown, t->lineno, scope);
           break;
       }
       break;
@@ -370,16 +424,416 @@ void typeCheck(TreeNode * syntaxTree)
   // traverse(syntaxTree,nullProc,checkNode);
 }
 
+static const Visitor analyzer = { insertNode, checkNode, enterScope, leaveScope, NULL, NULL };
+
+/* MINPARALLEL = function declarations needed before
+   their bodies are checked by the thread pool */
+#define MINPARALLEL 2
+
+/**
+ * @brief 함수 선언 decl의 함수 심볼과 파라미터만 global scope에 등록하고, 본문은 건너뜁니다.
+ */
+static void declareFunction (Analyzer a, TreeNode *decl) {
+  insertNode(decl, a->global, a);
+  enterScope(decl->scope);
+  visitNode(decl->child[0], decl->scope, &analyzer, a);
+  leaveScope(decl->scope);
+  functionSignature(decl->scope->function);
+  a->isNextCompoundFunctionBody = FALSE;
+}
+
+/* checkFunctionBody is the pool job that checks the
+   body of jobs[index] */
+static void checkFunctionBody (int index, void *arg) {
+  FunctionJob *job = (FunctionJob *)arg + index;
+  TreeNode *decl = job->decl;
+  Analyzer a = &job->context;
+
+  // global scope에서는 이 함수까지 선언된 심볼만 보임 (serial 분석과 같음)
+  freezeScope(a->global, decl->scope->function->memloc);
+
+  enterScope(decl->scope);
+  a->isNextCompoundFunctionBody = TRUE;
+  visitNode(decl->child[1], decl->scope, &analyzer, a);
+  leaveScope(decl->scope);
+
+  freezeScope(NULL, 0);
+}
+
+/**
+ * @brief 두 단계로 분석합니다. 먼저 global 변수와 함수 심볼, 파라미터를 선언 순서대로 등록하고,
+ * 그다음 함수 본문들을 thread pool에서 검사합니다. 진단은 최상위 선언마다 따로 모았다가
+ * 소스 순서대로 합치므로, 결과는 serial 분석과 같습니다.
+ *
+ * @return int 함수가 MINPARALLEL개보다 적어 아무것도 하지 않았으면 FALSE
+ */
+static int analyzeParallel (Analyzer a, TreeNode *root, int threads) {
+  ScopeList global = a->global;
+  TreeNode *decl;
+  int declCount = 0, jobCount = 0;
+  int k, j;
+
+  for (decl = root->child[0]; decl != NULL; decl = decl->sibling) {
+    declCount++;
+    if (decl->nodekind == DeclK && decl->kind.decl == FunK) {
+      jobCount++;
+    }
+  }
+  if (jobCount < MINPARALLEL) {
+    return FALSE;
+  }
+
+  DiagBuffer *segments = calloc(declCount, sizeof(DiagBuffer));
+  FunctionJob *jobs = calloc(jobCount, sizeof(FunctionJob));
+  assert(segments != NULL && jobs != NULL);
+
+  enterScope(global);
+  for (decl = root->child[0], k = 0, j = 0; decl != NULL; decl = decl->sibling, k++) {
+    a->diagnostics = &segments[k];
+
+    if (decl->nodekind == DeclK && decl->kind.decl == FunK) {
+      // 본문은 건너뛰고 함수 심볼과 파라미터만 등록
+      declareFunction(a, decl);
+
+      jobs[j].decl = decl;
+      jobs[j].context.global = global;
+      jobs[j].context.diagnostics = &segments[k];
+      jobs[j].context.job = &jobs[j];
+      j++;
+    } else {
+      visitNode(decl, global, &analyzer, a);
+    }
+  }
+  a->diagnostics = &a->own;
+  leaveScope(global);
+
+  // parser는 재진입할 수 없으므로 --lazy로 남겨 둔 본문은 여기서 차례로 파싱
+  for (j = 0; j < jobCount; j++) {
+    parseBody(jobs[j].decl->child[1]);
+  }
+
+  runJobs(jobCount, threads, checkFunctionBody, jobs);
+
+  for (j = 0; j < jobCount; j++) {
+    for (k = 0; k < jobs[j].refCount; k++) {
+      addReference(jobs[j].refs[k].symbol, jobs[j].refs[k].lineno);
+    }
+    free(jobs[j].refs);
+  }
+
+  for (k = 0; k < declCount; k++) {
+    moveDiagnostics(&a->own, &segments[k]);
+    freeDiagnostics(&segments[k]);
+  }
+
+  free(jobs);
+  free(segments);
+  return TRUE;
+}
+
+Analyzer createAnalyzer(void) {
+  Analyzer a = calloc(1, sizeof(struct AnalyzerRec));
+  assert(a != NULL);
+  a->diagnostics = &a->own;
+  return a;
+}
+
+DiagBuffer * analyzerDiagnostics(Analyzer a) {
+  return &a->own;
+}
+
+void freeAnalyzer(Analyzer a) {
+  freeDiagnostics(&a->own);
+  free(a);
+}
+
+/* Procedure analyzeTree builds the symbol table of
+ * syntaxTree and checks its types; with more than
+ * one thread, function bodies are checked in
+ * parallel (analyzeParallel)
+ */
+void analyzeTree(Analyzer a, TreeNode * syntaxTree) {
+  int threads = AnalyzeJobs > 0 ? AnalyzeJobs : onlineThreads();
+
+  a->global = syntaxTree->scope = createGlobalScope();
+
+  if (threads <= 1 || !analyzeParallel(a, syntaxTree, threads)) {
+    visitTree(syntaxTree, NULL, &analyzer, a);
+  }
+}
+
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
+ * and lists the errors found, in source order;
+ * any error sets Error
  */
 void buildSymtab(TreeNode * syntaxTree) {
-  syntaxTree->scope = createGlobalScope();
+  Analyzer a = createAnalyzer();
+  Visitor printer = { printScopeOfNode, NULL, NULL, NULL, NULL, NULL };
+  Visitor xref = { printXrefOfNode, NULL, NULL, NULL, NULL, NULL };
+
+  analyzeTree(a, syntaxTree);
+  if (diagnosticCount(analyzerDiagnostics(a)) > 0) {
+    Error = TRUE;
+  }
+  flushDiagnostics(analyzerDiagnostics(a), listing);
+  freeAnalyzer(a);
+
+  if (TraceAnalyze) {
+    fprintf(listing,"\nSymbol table:\n\n");
+    visitTree(syntaxTree, NULL, &printer, NULL);
+  }
+
+  if (ListXref) {
+    fprintf(listing,"\nCross reference:\n\n");
+    visitTree(syntaxTree, NULL, &xref, NULL);
+    printXrefStats(listing);
+  }
+}
+
+/* Procedure buildGlobalSymtab constructs only the
+ * global scope: global variables and function
+ * signatures, leaving function bodies alone (and
+ * unparsed, with --lazy), and lists it with the
+ * errors found
+ */
+void buildGlobalSymtab(TreeNode * syntaxTree) {
+  Analyzer a = createAnalyzer();
+  TreeNode *decl;
+
+  a->global = syntaxTree->scope = createGlobalScope();
+  enterScope(a->global);
+  for (decl = syntaxTree->child[0]; decl != NULL; decl = decl->sibling) {
+    if (decl->nodekind == DeclK && decl->kind.decl == FunK) {
+      declareFunction(a, decl);
+    } else {
+      visitNode(decl, a->global, &analyzer, a);
+    }
+  }
+  leaveScope(a->global);
+
+  flushDiagnostics(analyzerDiagnostics(a), listing);
+  freeAnalyzer(a);
+
+  fprintf(listing,"\nGlobal symbols:\n\n");
+  printScope(listing, syntaxTree->scope);
+}
+
+/* Procedure streamSymtab adds the top-level
+ * declaration decl to the symbol table and checks
+ * it, and lists the errors found before the line
+ * the parser has reached and the local scopes of
+ * decl; the caller releases those scopes once it
+ * is done with decl (releaseLocalScopes)
+ */
+void streamSymtab(Analyzer a, TreeNode * decl) {
+  Visitor printer = { printScopeOfNode, NULL, NULL, NULL, NULL, NULL };
+  Visitor xref = { printXrefOfNode, NULL, NULL, NULL, NULL, NULL };
+
+  if (a->global == NULL) {
+    // global 스코프는 파일 끝까지 들어가 있는 채로 둠 (finishStreamSymtab에서 나옴)
+    a->global = createGlobalScope();
+    enterScope(a->global);
+  }
+
+  visitNode(decl, a->global, &analyzer, a);
+  // decl 다음 토큰의 줄보다 앞선 진단은 뒤의 선언에서 다시 나올 수 없음
+  flushDiagnosticsBefore(analyzerDiagnostics(a), listing, lineno);
+
+  if (TraceAnalyze) {
+    visitNode(decl, a->global, &printer, NULL);
+  }
+  if (ListXref) {
+    visitNode(decl, a->global, &xref, NULL);
+  }
+}
+
+/* Procedure finishStreamSymtab lists the errors
+ * left after the last streamSymtab and, unless
+ * there was a syntax error, the global scope
+ */
+void finishStreamSymtab(Analyzer a) {
+  flushDiagnostics(analyzerDiagnostics(a), listing);
+  if (a->global == NULL) {
+    return;
+  }
+  leaveScope(a->global);
+
+  if (TraceAnalyze && !Error) {
+    fprintf(listing,"\nSymbol table:\n\n");
+    printScope(listing, a->global);
+  }
+
+  if (ListXref && !Error) {
+    fprintf(listing,"\nCross reference:\n\n");
+    printXref(listing, a->global);
+    printXrefStats(listing);
+  }
+}
+
+/****************************************************/
+/* Analysis of the compact tree (compact.h): the    */
+/* same rules as above, reading node fields from    */
+/* the per-field arrays instead of TreeNode         */
+/****************************************************/
+
+static void insertCompactNode (CompactTree * ct, NodeIndex n, ScopeList scope, void * context) {
+  Analyzer a = context;
+  int named = hasAttr(ct->nodekind[n], ct->kind[n]);
+  BucketList declared = NULL;
+  ScopeList newScope = enterNode(a, ct->nodekind[n], ct->kind[n],
+    named ? nodeName(ct, n) : NULL, ct->type[n], ct->lineno[n], scope, &declared);
+
+  if (named && declared != NULL) {
+    nodeSymbol(ct, n) = declared;
+  }
+
+  if (newScope != NULL) {
+    nodeScope(ct, n) = newScope;
+  }
+}
+
+static void printScopeOfCompactNode (CompactTree * ct, NodeIndex n, ScopeList scope, void * context) {
+  (void) scope;
+  (void) context;
+  if (hasAttr(ct->nodekind[n], ct->kind[n]) && nodeScope(ct, n) != NULL) {
+    printScope(listing, nodeScope(ct, n));
+  }
+}
+
+static void printXrefOfCompactNode (CompactTree * ct, NodeIndex n, ScopeList scope, void * context) {
+  (void) scope;
+  (void) context;
+  if (hasAttr(ct->nodekind[n], ct->kind[n]) && nodeScope(ct, n) != NULL) {
+    printXref(listing, nodeScope(ct, n));
+  }
+}
+
+static ExpType typeCheckCompactCall (Analyzer a, CompactTree * ct, NodeIndex n, BucketList symbol) {
+  if (symbol == NULL) {
+    return Unknown;
+  }
+
+  // ArgListK 노드의 payload에 호출 시그니처 id를 저장
+  NodeIndex argList = firstChild(ct, n, 0);
+  NodeRange args = childList(ct, argList, 0);
+  ExpType local[MAXLOCALARGS];
+  ExpType *types = local;
+  unsigned int i;
+
+  if (args.count > MAXLOCALARGS) {
+    types = malloc(args.count * sizeof(ExpType));
+    assert(types != NULL);
+  }
+
+  for (i = 0; i < args.count; i++) {
+    types[i] = ct->type[args.first + i];
+  }
+
+  int signature = checkArguments(a, symbol, types, args.count, nodeName(ct, n), ct->lineno[n]);
+  if (argList != NULL_NODE) {
+    ct->payload[argList] = signature;
+  }
 
-  traverse(syntaxTree, NULL, insertNode, checkNode);
+  if (types != local) {
+    free(types);
+  }
+
+  return symbol->type.funType.returnType;
+}
+
+/* Procedure checkCompactNode performs type
+ * checking at a single node of the compact tree
+ */
+static void checkCompactNode (CompactTree * ct, NodeIndex n, ScopeList scope, void * context) {
+  Analyzer a = context;
+  NodeIndex c0 = firstChild(ct, n, 0);
+  NodeIndex c1 = firstChild(ct, n, 1);
+
+  switch (ct->nodekind[n]) {
+    case ExpK:
+      switch (ct->kind[n]) {
+        case IdK:
+          nodeSymbol(ct, n) = lookupVariable(a, nodeName(ct, n), ct->lineno[n], scope);
+          if (c0 == NULL_NODE) {
+            ct->type[n] = typeCheckSingleIdExpr(nodeSymbol(ct, n));
+          } else {
+            ct->type[n] = typeCheckArrayRefIdExpr(a, nodeSymbol(ct, n), nodeName(ct, n), ct->lineno[n], ct->type[c0]);
+          }
+          break;
+        case AssignK:
+          ct->type[n] = typeCheckAssignment(a, ct->type[c0], ct->type[c1], ct->lineno[n]);
+          break;
+        case ConstK:
+          ct->type[n] = Integer;
+          break;
+        case BinaryOpK:
+          ct->type[n] = typeCheckBinaryOp(a, ct->type[c0], ct->type[c1], ct->lineno[n]);
+          break;
+        case CallK:
+          nodeSymbol(ct, n) = lookupCallee(a, nodeName(ct, n), ct->lineno[n], scope);
+          ct->type[n] = typeCheckCompactCall(a, ct, n, nodeSymbol(ct, n));
+          break;
+      }
+      break;
+    case StmtK:
+      switch (ct->kind[n]) {
+        case SelectK:
+        case IterK:
+          typeCheckCondition(a, ct->type[c0], ct->lineno[c0]);
+          break;
+        case RetK:
+          typeCheckRetStmt(a, c0 != NULL_NODE, ct->type[c0], ct->lineno[n], scope);
+          break;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/* Procedure analyzeCompactTree builds the symbol
+ * table of ct and checks its types like analyzeTree
+ */
+void analyzeCompactTree(Analyzer a, CompactTree * ct) {
+  // 최상위 ListK 노드는 side table 항목이 없으므로 global 스코프를 직접 넘김
+  CompactVisitor analyzer = { insertCompactNode, checkCompactNode, enterScope, leaveScope, NULL, NULL };
+
+  a->global = createGlobalScope();
+
+  enterScope(a->global);
+  visitCompact(ct, ct->root, a->global, &analyzer, a);
+  leaveScope(a->global);
+}
+
+/* Function buildCompactSymtab constructs the
+ * symbol table and checks types like buildSymtab,
+ * working on the compact tree ct
+ */
+void buildCompactSymtab(CompactTree * ct) {
+  CompactVisitor printer = { printScopeOfCompactNode, NULL, NULL, NULL, NULL, NULL };
+  CompactVisitor xref = { printXrefOfCompactNode, NULL, NULL, NULL, NULL, NULL };
+  Analyzer a = createAnalyzer();
+  ScopeList global;
+
+  analyzeCompactTree(a, ct);
+  if (diagnosticCount(analyzerDiagnostics(a)) > 0) {
+    Error = TRUE;
+  }
+  flushDiagnostics(analyzerDiagnostics(a), listing);
+  global = a->global;
+  freeAnalyzer(a);
 
   if (TraceAnalyze) {
     fprintf(listing,"\nSymbol table:\n\n");
-    traverse(syntaxTree, NULL, printScopeOfNode, nullProc);
+    printScope(listing, global);
+    visitCompact(ct, ct->root, global, &printer, NULL);
   }
-}
\ No newline at end of file
+
+  if (ListXref) {
+    fprintf(listing,"\nCross reference:\n\n");
+    printXref(listing, global);
+    visitCompact(ct, ct->root, global, &xref, NULL);
+    printXrefStats(listing);
+  }
+}
@@ -8,11 +8,81 @@
 #ifndef _ANALYZE_H_
 #define _ANALYZE_H_
 
+/* Analyzer is the state of one analysis: its global
+ * scope and the diagnostics found so far. The name
+ * table of entered scopes and the arenas of the
+ * symbol table belong to the thread, so a thread
+ * runs one analysis at a time: two Analyzers may
+ * not be used alternately on one thread. Separate
+ * trees can be analyzed at once on different
+ * threads (see bench/parcheck.c)
+ */
+typedef struct AnalyzerRec * Analyzer;
+
+/* Function createAnalyzer returns a new analyzer
+ * with no diagnostics
+ */
+Analyzer createAnalyzer(void);
+
+/* Procedure analyzeTree builds the symbol table of
+ * the tree and checks its types, recording errors
+ * in the analyzer; function bodies are checked on
+ * AnalyzeJobs threads with the same result as a
+ * serial run
+ */
+void analyzeTree(Analyzer, TreeNode *);
+
+/* Procedure analyzeCompactTree does the same as
+ * analyzeTree on the compact tree (see compact.h)
+ */
+void analyzeCompactTree(Analyzer, CompactTree *);
+
+/* Function analyzerDiagnostics returns the errors
+ * recorded so far, in source order (see diag.h)
+ */
+DiagBuffer * analyzerDiagnostics(Analyzer);
+
+/* Procedure freeAnalyzer releases the analyzer and
+ * its diagnostics; the symbol table stays
+ */
+void freeAnalyzer(Analyzer);
+
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
+ * and lists the errors found; any error sets
+ * Error, so that no code is generated
  */
 void buildSymtab(TreeNode *);
 
+/* Procedure buildGlobalSymtab constructs and
+ * lists only the global scope of the tree: global
+ * variables and function signatures. Function
+ * bodies are not visited, so with LazyBodies they
+ * are never parsed
+ */
+void buildGlobalSymtab(TreeNode *);
+
+/* Procedure streamSymtab adds one top-level
+ * declaration to the symbol table of a streamed
+ * compilation (see parseStream) and checks it,
+ * and lists its errors and local scopes. Call
+ * releaseLocalScopes (symtab.h) once done with
+ * the declaration: only the global scope stays
+ */
+void streamSymtab(Analyzer, TreeNode *);
+
+/* Procedure finishStreamSymtab ends a streamed
+ * compilation: it lists the remaining errors and
+ * the global scope
+ */
+void finishStreamSymtab(Analyzer);
+
+/* Function buildCompactSymtab constructs the
+ * symbol table and checks types like buildSymtab,
+ * working on the compact tree (see compact.h)
+ */
+void buildCompactSymtab(CompactTree *);
+
 /* Procedure typeCheck performs type checking 
  * by a postorder syntax tree traversal
  */
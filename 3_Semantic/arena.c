@@ -0,0 +1,87 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Bump allocator for data that lives and dies with */
+/* one compilation unit (syntax tree nodes)         */
+/* Chunks double in size up to MAX_CHUNK, so a unit */
+/* of n bytes needs O(log n + n / MAX_CHUNK) chunks */
+/****************************************************/
+
+#include "globals.h"
+#include "arena.h"
+
+/* chunk sizes, in bytes */
+#define MIN_CHUNK 65536
+#define MAX_CHUNK (4 * 1024 * 1024)
+
+/* alignment of every allocation */
+#define ARENA_ALIGN 8
+
+struct ArenaChunk
+{ struct ArenaChunk * next;
+  size_t size; /* usable bytes in data */
+  size_t used; /* bytes handed out from data */
+  char data[];
+};
+
+/* Function arenaAlloc returns size bytes from arena,
+ * aligned for any tree node field; NULL when out of memory
+ */
+void * arenaAlloc(Arena * arena, size_t size)
+{ struct ArenaChunk * c = arena->chunks;
+  void * p;
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  if (c == NULL || c->size - c->used < size)
+  { size_t chunkSize = (c == NULL) ? MIN_CHUNK : c->size * 2;
+    if (chunkSize > MAX_CHUNK) chunkSize = MAX_CHUNK;
+    if (chunkSize < size) chunkSize = size;
+    c = malloc(sizeof(struct ArenaChunk) + chunkSize);
+    if (c == NULL) return NULL;
+    c->next = arena->chunks;
+    c->size = chunkSize;
+    c->used = 0;
+    arena->chunks = c;
+    arena->reserved += chunkSize;
+    arena->chunkCount++;
+  }
+  p = c->data + c->used;
+  c->used += size;
+  arena->bytes += size;
+  return p;
+}
+
+/* Procedure arenaRelease frees every chunk of arena
+ * and leaves it empty and ready for reuse
+ */
+void arenaRelease(Arena * arena)
+{ struct ArenaChunk * c = arena->chunks;
+  while (c != NULL)
+  { struct ArenaChunk * next = c->next;
+    free(c);
+    c = next;
+  }
+  arena->chunks = NULL;
+  arena->bytes = 0;
+  arena->reserved = 0;
+  arena->chunkCount = 0;
+}
+
+/* Procedure arenaReset empties arena for reuse,
+ * keeping only its newest (largest) chunk
+ */
+void arenaReset(Arena * arena)
+{ struct ArenaChunk * keep = arena->chunks;
+  struct ArenaChunk * c;
+  if (keep == NULL) return;
+  c = keep->next;
+  while (c != NULL)
+  { struct ArenaChunk * next = c->next;
+    free(c);
+    c = next;
+  }
+  keep->next = NULL;
+  keep->used = 0;
+  arena->chunks = keep;
+  arena->bytes = 0;
+  arena->reserved = keep->size;
+  arena->chunkCount = 1;
+}
@@ -0,0 +1,37 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Bump allocator for data that lives and dies with */
+/* one compilation unit (syntax tree nodes)         */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+typedef struct ArenaChunk * ArenaChunkList;
+
+/* Arena hands out memory from a list of large chunks;
+ * everything allocated from it is released at once
+ */
+typedef struct
+{ ArenaChunkList chunks; /* most recent chunk first */
+  size_t bytes;          /* bytes handed out */
+  size_t reserved;       /* bytes held in chunks */
+  int chunkCount;        /* number of chunks */
+} Arena;
+
+/* Function arenaAlloc returns size bytes from arena,
+ * aligned for any tree node field; NULL when out of memory
+ */
+void * arenaAlloc(Arena * arena, size_t size);
+
+/* Procedure arenaRelease frees every chunk of arena
+ * and leaves it empty and ready for reuse
+ */
+void arenaRelease(Arena * arena);
+
+/* Procedure arenaReset empties arena for reuse,
+ * keeping only its newest (largest) chunk
+ */
+void arenaReset(Arena * arena);
+
+#endif
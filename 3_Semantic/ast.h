@@ -3,7 +3,13 @@
 
 typedef int TokenType; 
 
+/* Lexeme is a slice of the source text (not
+ * NUL-terminated) handed from the scanner to the parser
+ */
+typedef struct { const char * text; int len; } Lexeme;
+
 typedef struct ScopeListRec* ScopeList;
+typedef struct BucketListRec* BucketList;
 
 /**************************************************/
 /***********   Syntax tree for parsing ************/
@@ -20,6 +26,17 @@ typedef enum {Void,Integer,VoidArray,IntegerArray,Unknown} ExpType;
 
 #define MAXCHILDREN 3
 
+/* LazyBody is the source text of a function body
+ * recorded by the parser in lazy mode instead of
+ * its syntax tree (see parseBody): the characters
+ * [offset, end), starting on line lineno
+ */
+typedef struct
+   { unsigned int offset;
+     unsigned int end;
+     int lineno;
+   } LazyBody;
+
 typedef struct treeNode
    { struct treeNode * child[MAXCHILDREN];
      struct treeNode * sibling;
@@ -28,12 +45,15 @@ typedef struct treeNode
      union { StmtKind stmt; ExpKind exp; DeclKind decl; ListKind list; } kind;
      union { TokenType op;
              int val;
-             char * name;
+             char * name; /* interned, see intern.h */
              int has_else;
              struct treeNode* lastChildOfList;
+             LazyBody * lazy; /* CompoundK: body not parsed yet */
              } attr;
      ExpType type; /* for type checking of exps */
+     int signature; /* ArgListK: the callee's signature if the arguments match it, see sigtab.h */
      ScopeList scope;
+     BucketList symbol; /* IdK, CallK: declaration the name resolves to; DeclK: symbol declared */
    } TreeNode;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+/****************************************************/
+/* File: astbench.c                                 */
+/* Syntax tree benchmark (make bench): parses a     */
+/* program and compares the pointer tree with the   */
+/* compact tree (compact.h) in memory, preorder     */
+/* walk time and analysis time                      */
+/* usage: astbench <file>                           */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "util.h"
+#include "parse.h"
+#include "visit.h"
+#include "compact.h"
+#include "diag.h"
+#include "analyze.h"
+
+/* RUNS = times each tree is walked */
+#define RUNS 10
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int ListXref = FALSE;
+int AnalyzeJobs = 1;
+int MaxErrors = 0;
+int Streaming = FALSE;
+int LazyBodies = FALSE;
+int GlobalsOnly = FALSE;
+int UseIR = FALSE;
+int DumpIR = FALSE;
+int FoldConstants = FALSE;
+
+int Error = FALSE;
+
+/* seconds returns a monotonic time in seconds */
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* the walks count the nodes and sum a field of each,
+   so that every node is read */
+static long nodes, checksum;
+
+static void countNode(TreeNode *t, ScopeList scope, void *context)
+{
+  (void)scope;
+  (void)context;
+  nodes++;
+  checksum += t->lineno + t->type;
+}
+
+static void countCompactNode(CompactTree *ct, NodeIndex n, ScopeList scope, void *context)
+{
+  (void)scope;
+  (void)context;
+  nodes++;
+  checksum += ct->lineno[n] + ct->type[n];
+}
+
+int main(int argc, char *argv[])
+{
+  static const Visitor walk = { countNode, NULL, NULL, NULL, NULL, NULL };
+  static const CompactVisitor compactWalk = { countCompactNode, NULL, NULL, NULL, NULL, NULL };
+  TreeNode *tree;
+  CompactTree *ct;
+  Analyzer analyzer;
+  double t, convert, ptrWalk = 0, compactWalkTime = 0, ptrAnalyze, compactAnalyze;
+  long ptrSum, compactSum;
+  int i;
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <file>\n", argv[0]);
+    return 1;
+  }
+  source = fopen(argv[1], "r");
+  if (source == NULL)
+  {
+    fprintf(stderr, "File %s not found\n", argv[1]);
+    return 1;
+  }
+  listing = stdout;
+  tree = parse();
+  if (Error)
+  {
+    fprintf(stderr, "Syntax errors in %s\n", argv[1]);
+    return 1;
+  }
+
+  t = seconds();
+  ct = compactTree(tree);
+  convert = seconds() - t;
+
+  printTreeStats();
+  printCompactTreeStats(ct);
+
+  for (i = 0; i < RUNS; i++)
+  {
+    nodes = checksum = 0;
+    t = seconds();
+    visitTree(tree, NULL, &walk, NULL);
+    t = seconds() - t;
+    if (i == 0 || t < ptrWalk)
+      ptrWalk = t;
+    ptrSum = checksum;
+
+    nodes = checksum = 0;
+    t = seconds();
+    visitCompact(ct, ct->root, NULL, &compactWalk, NULL);
+    t = seconds() - t;
+    if (i == 0 || t < compactWalkTime)
+      compactWalkTime = t;
+    compactSum = checksum;
+  }
+  if (ptrSum != compactSum)
+  {
+    fprintf(stderr, "The trees differ\n");
+    return 1;
+  }
+
+  analyzer = createAnalyzer();
+  t = seconds();
+  analyzeTree(analyzer, tree);
+  ptrAnalyze = seconds() - t;
+  freeAnalyzer(analyzer);
+
+  analyzer = createAnalyzer();
+  t = seconds();
+  analyzeCompactTree(analyzer, ct);
+  compactAnalyze = seconds() - t;
+  freeAnalyzer(analyzer);
+
+  printf("\n  %ld nodes, conversion %.1f ms\n", nodes, convert * 1e3);
+  printf("  preorder walk:  pointer %.1f ms, compact %.1f ms\n",
+         ptrWalk * 1e3, compactWalkTime * 1e3);
+  printf("  analysis:       pointer %.1f ms, compact %.1f ms\n",
+         ptrAnalyze * 1e3, compactAnalyze * 1e3);
+  freeCompactTree(ct);
+  freeTrees();
+  fclose(source);
+  return 0;
+}
@@ -0,0 +1,271 @@
+/****************************************************/
+/* File: gensrc.c                                   */
+/* Generates C-Minus programs for the compiler      */
+/* benchmarks (make bench)                          */
+/* usage: gensrc <kind> <n> [seed]                  */
+/*   funcs: a valid program of about n lines in     */
+/*   functions that call the ones before them       */
+/*   stmts: one function of n statements            */
+/*   decls: n top-level declarations                */
+/*   parens, sums, nest, ifs: an expression, a sum, */
+/*   a block or an else-if chain nested n deep      */
+/*   blocks: n blocks of 0 to 3 locals, a hundred   */
+/*   to a function                                  */
+/*   random: n declarations full of semantic        */
+/*   errors, different for each seed                */
+/*   codegen: a program of n functions with loops,  */
+/*   arrays, calls and constant subexpressions that */
+/*   runs on tm without input, for bench-codegen    */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long seed = 12345;
+
+/* nextRandom returns a pseudo-random number below n,
+   the same sequence on every run */
+static int nextRandom(int n)
+{
+  seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+  return (int)((seed >> 33) % (unsigned long)n);
+}
+
+/* function writes function number n, which calls
+   function n - 1; returns the lines written */
+static int function(int n)
+{
+  int lines = 16;
+  printf("int f%d(int a, int b[])\n{\n", n);
+  printf("    int x;\n    int y;\n    int t[4];\n");
+  printf("    x = a * %d + b[%d];\n", 1 + nextRandom(9), nextRandom(4));
+  printf("    y = 0;\n");
+  printf("    while (y < x)\n    {\n");
+  if (n > 0)
+    printf("        if (x > y + %d)\n            x = x - f%d(y, t);\n", nextRandom(10), n - 1);
+  else
+    printf("        if (x > y + %d)\n            x = x - y;\n", nextRandom(10));
+  printf("        else\n            t[y / %d] = (x + y) * (a - %d);\n", 1 + nextRandom(4), nextRandom(100));
+  printf("        y = y + 1;\n    }\n");
+  if (nextRandom(2) == 0)
+  {
+    printf("    output(x);\n");
+    lines++;
+  }
+  printf("    return x + t[%d];\n}\n\n", nextRandom(4));
+  return lines;
+}
+
+/* functions writes functions of about n lines */
+static void functions(long n)
+{
+  long lines = 0;
+  int k = 0;
+  while (lines < n)
+    lines += function(k++);
+  printf("void main(void)\n{\n    int b[4];\n    output(f%d(input(), b));\n}\n", k - 1);
+}
+
+/* statements writes a main of n statements */
+static void statements(long n)
+{
+  long i;
+  printf("void main(void)\n{\n    int x;\n    x = 0;\n");
+  for (i = 1; i < n; i++)
+    printf("    x = x + %ld;\n", i % 100);
+  printf("}\n");
+}
+
+/* declarations writes n top-level declarations,
+   every fourth one a function */
+static void declarations(long n)
+{
+  long i;
+  for (i = 0; i < n - 1; i++)
+    if (i % 4 == 3)
+      printf("int f%ld(int a) { return a + g%ld; }\n", i, i - 1);
+    else
+      printf("int g%ld;\n", i);
+  printf("void main(void) { }\n");
+}
+
+/* blocks writes n blocks in functions of BLOCKS
+   blocks, each block declaring 0 to 3 locals */
+#define BLOCKS 100
+
+static void blocks(long n)
+{
+  long i;
+  int f, j, locals;
+  for (f = 0; (long)f * BLOCKS < n; f++)
+  {
+    printf("int f%d(int a)\n{\n    int x;\n    x = a;\n", f);
+    for (i = 0; i < BLOCKS && (long)f * BLOCKS + i < n; i++)
+    {
+      locals = nextRandom(4);
+      printf("    {\n");
+      for (j = 0; j < locals; j++)
+        printf("        int v%d;\n", j);
+      for (j = 0; j < locals; j++)
+        printf("        v%d = x + %d;\n", j, j);
+      printf("        x = x + %ld;\n    }\n", i);
+    }
+    printf("    return x;\n}\n\n");
+  }
+  printf("void main(void)\n{\n    output(f0(input()));\n}\n");
+}
+
+/* randomDeclarations writes n globals and functions
+   with random names, so that many are redefined,
+   used before they are declared or not at all, and
+   called with the wrong arguments */
+static void randomDeclarations(long n)
+{
+  static const char *params[] = { "void", "int a", "int a, int b[]", "int a, int a" };
+  int globals = (int)(n / 3 + 1), functions = (int)n;
+  long i;
+  int k, count, g, f, isInt;
+  const char *param;
+  for (i = 0; i < n; i++)
+  {
+    if (nextRandom(10) < 3)
+    {
+      printf(nextRandom(5) < 4 ? "int g%d;\n" : "int g%d[4];\n", nextRandom(globals));
+      continue;
+    }
+    isInt = nextRandom(2);
+    f = nextRandom(functions);
+    param = params[nextRandom(4)];
+    printf("%s f%d(%s) {\n  int x; int y[3];\n", isInt ? "int" : "void", f, param);
+    count = 1 + nextRandom(6);
+    for (k = 0; k < count; k++)
+    {
+      g = nextRandom(globals);
+      f = nextRandom(functions);
+      switch (nextRandom(8))
+      {
+      case 0: printf("  x = g%d;\n", g); break;
+      case 1: printf("  x = f%d(x);\n", f); break;
+      case 2: printf("  g%d = f%d(x, y);\n", g, f); break;
+      case 3: printf("  { int g%d; g%d = x + g%d; x = f%d(); }\n", g, g, g, f); break;
+      case 4: printf("  if (g%d) x = y; else return g%d;\n", g, g); break;
+      case 5: printf("  while (x < 3) { x = g%d[x]; output(x); }\n", g); break;
+      case 6: printf("  return;\n"); break;
+      default: printf("  x = input();\n"); break;
+      }
+    }
+    printf("}\n");
+  }
+  printf("void main(void) { }\n");
+}
+
+/* codegen writes n functions, each looping over an
+   array, folding constant subexpressions and calling
+   the one before it, and a main that prints what
+   they return; sums are kept below 1000 so that
+   nothing overflows */
+static void codegen(long n)
+{
+  int k, c1, c2, c3, c4;
+  for (k = 0; k < n; k++)
+  {
+    c1 = nextRandom(100);
+    c2 = 2 + nextRandom(8);
+    c3 = 1 + nextRandom(9);
+    c4 = 3 + nextRandom(20);
+    printf("int f%d(int a, int b[])\n{\n    int i;\n    int s;\n", k);
+    printf("    s = %d;\n    i = 0;\n", c1);
+    printf("    while (i < %d * 2 + a)\n    {\n", c4);
+    printf("        s = s + b[i - i / 4 * 4] * %d - (a + %d) / (%d - 1);\n", c2, c3, c2);
+    printf("        if (s > 500 + %d * 10) s = s - %d * (2 + 3);\n", c3, c4);
+    printf("        s = s - s / 1000 * 1000;\n");
+    printf("        i = i + 1;\n    }\n");
+    if (k > 0)
+      printf("    return s + f%d(a - 1, b) / 2;\n}\n\n", k - 1);
+    else
+      printf("    return s;\n}\n\n");
+  }
+  printf("void main(void)\n{\n    int b[4];\n    int j;\n    j = 0;\n");
+  printf("    while (j < 4)\n    {\n        b[j] = j * %d + 1;\n        j = j + 1;\n    }\n", 1 + nextRandom(5));
+  for (k = 0; k < n; k++)
+    printf("    output(f%d(%d, b));\n", k, k + 1 + nextRandom(4));
+  printf("}\n");
+}
+
+/* nested writes a main whose body nests n deep */
+static void nested(const char *kind, long n)
+{
+  long i;
+  printf("void main(void)\n{\n    int x;\n");
+  if (strcmp(kind, "parens") == 0)
+  {
+    printf("    x = ");
+    for (i = 0; i < n; i++)
+      putchar('(');
+    putchar('1');
+    for (i = 0; i < n; i++)
+      putchar(')');
+    printf(";\n");
+  }
+  else if (strcmp(kind, "sums") == 0)
+  {
+    printf("    x = ");
+    for (i = 0; i < n; i++)
+      printf("1+(");
+    putchar('1');
+    for (i = 0; i < n; i++)
+      putchar(')');
+    printf(";\n");
+  }
+  else if (strcmp(kind, "nest") == 0)
+  {
+    for (i = 0; i < n; i++)
+      putchar('{');
+    printf("x = 1;");
+    for (i = 0; i < n; i++)
+      putchar('}');
+    printf("\n");
+  }
+  else
+  {
+    printf("    x = input();\n");
+    for (i = 0; i < n; i++)
+      printf("    if (x == %ld) x = %ld; else\n", i, i + 1);
+    printf("    x = 0;\n");
+  }
+  printf("    output(x);\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+  static const char *kinds[] = { "funcs", "stmts", "decls", "blocks", "random", "codegen", "parens", "sums", "nest", "ifs" };
+  long n;
+  int k;
+  for (k = 0; (argc == 3 || argc == 4) && k < (int)(sizeof(kinds) / sizeof(kinds[0])); k++)
+    if (strcmp(argv[1], kinds[k]) == 0)
+      break;
+  if ((argc != 3 && argc != 4) || k == (int)(sizeof(kinds) / sizeof(kinds[0])))
+  {
+    fprintf(stderr, "usage: %s funcs|stmts|decls|blocks|random|codegen|parens|sums|nest|ifs <n> [seed]\n", argv[0]);
+    return 1;
+  }
+  n = atol(argv[2]);
+  if (argc == 4)
+    seed = strtoul(argv[3], NULL, 10);
+  if (k == 0)
+    functions(n);
+  else if (k == 1)
+    statements(n);
+  else if (k == 2)
+    declarations(n);
+  else if (k == 3)
+    blocks(n);
+  else if (k == 4)
+    randomDeclarations(n);
+  else if (k == 5)
+    codegen(n);
+  else
+    nested(argv[1], n);
+  return 0;
+}
@@ -0,0 +1,149 @@
+/****************************************************/
+/* File: parcheck.c                                 */
+/* Thread check (make check-threads): parses each   */
+/* program twice, analyzes the first trees one      */
+/* after the other on this thread and the second    */
+/* ones at once, each on a thread of its own, and   */
+/* compares each listing with its serial one        */
+/* usage: parcheck <file>...                        */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "parse.h"
+#include "visit.h"
+#include "compact.h"
+#include "diag.h"
+#include "symtab.h"
+#include "analyze.h"
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int ListXref = FALSE;
+int AnalyzeJobs = 1;
+int MaxErrors = 0;
+int Streaming = FALSE;
+int LazyBodies = FALSE;
+int GlobalsOnly = FALSE;
+int UseIR = FALSE;
+int DumpIR = FALSE;
+int FoldConstants = FALSE;
+
+int Error = FALSE;
+
+/* Check is one analysis of a tree and its listing */
+typedef struct
+{
+  TreeNode *tree;
+  char *text;
+  size_t size;
+} Check;
+
+static void printScopes(TreeNode *t, ScopeList scope, void *context)
+{
+  (void)scope;
+  if (t->scope != NULL)
+  {
+    printScope(context, t->scope);
+    printXref(context, t->scope);
+  }
+}
+
+/* analyze analyzes the tree of a Check and lists
+   its errors, scopes and references in memory */
+static void *analyze(void *arg)
+{
+  static const Visitor printer = { printScopes, NULL, NULL, NULL, NULL, NULL };
+  Check *check = arg;
+  Analyzer analyzer = createAnalyzer();
+  FILE *out = open_memstream(&check->text, &check->size);
+  if (out == NULL)
+  {
+    fprintf(stderr, "Out of memory error while listing\n");
+    exit(1);
+  }
+  analyzeTree(analyzer, check->tree);
+  flushDiagnostics(analyzerDiagnostics(analyzer), out);
+  freeAnalyzer(analyzer);
+  visitTree(check->tree, NULL, &printer, out);
+  fclose(out);
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  int n = argc - 1, failed = 0, i;
+  Check *serial, *parallel;
+  pthread_t *threads;
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s <file>...\n", argv[0]);
+    return 1;
+  }
+  listing = stdout;
+  serial = calloc(n, sizeof(Check));
+  parallel = calloc(n, sizeof(Check));
+  threads = malloc(n * sizeof(pthread_t));
+  assert(serial != NULL && parallel != NULL && threads != NULL);
+
+  /* the parser is not reentrant, so every tree is
+     parsed here first */
+  for (i = 0; i < 2 * n; i++)
+  {
+    source = fopen(argv[1 + i % n], "r");
+    if (source == NULL)
+    {
+      fprintf(stderr, "File %s not found\n", argv[1 + i % n]);
+      return 1;
+    }
+    restartScan();
+    (i < n ? serial : parallel)[i % n].tree = parse();
+    fclose(source);
+    if (Error)
+    {
+      fprintf(stderr, "Syntax errors in %s\n", argv[1 + i % n]);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < n; i++)
+    analyze(&serial[i]);
+  for (i = 0; i < n; i++)
+    if (pthread_create(&threads[i], NULL, analyze, &parallel[i]) != 0)
+    {
+      fprintf(stderr, "Unable to start a thread\n");
+      return 1;
+    }
+  for (i = 0; i < n; i++)
+    pthread_join(threads[i], NULL);
+
+  for (i = 0; i < n; i++)
+  {
+    if (serial[i].size != parallel[i].size ||
+        memcmp(serial[i].text, parallel[i].text, serial[i].size) != 0)
+    {
+      printf("  %s: the listing on its own thread differs\n", argv[1 + i]);
+      failed = 1;
+    }
+    free(serial[i].text);
+    free(parallel[i].text);
+  }
+  if (!failed)
+    printf("  %d programs analyzed on %d threads list as when analyzed serially\n", n, n);
+  free(serial);
+  free(parallel);
+  free(threads);
+  freeTrees();
+  return failed;
+}
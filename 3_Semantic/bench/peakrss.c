@@ -0,0 +1,53 @@
+/****************************************************/
+/* File: peakrss.c                                  */
+/* Runs a command with its output discarded and     */
+/* prints its peak resident set size (make bench)   */
+/* usage: peakrss <label> <command> [args]          */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+int main(int argc, char *argv[])
+{
+  struct rusage usage;
+  pid_t pid;
+  int status;
+  if (argc < 3)
+  {
+    fprintf(stderr, "usage: %s <label> <command> [args]\n", argv[0]);
+    return 1;
+  }
+  pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    return 1;
+  }
+  if (pid == 0)
+  {
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0)
+      dup2(null, STDOUT_FILENO);
+    execv(argv[2], argv + 2);
+    perror(argv[2]);
+    _exit(127);
+  }
+  if (wait4(pid, &status, 0, &usage) < 0)
+  {
+    perror("wait4");
+    return 1;
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    fprintf(stderr, "%s failed\n", argv[2]);
+    return 1;
+  }
+  /* ru_maxrss is in kilobytes */
+  printf("  %s: %.1f MB\n", argv[1], usage.ru_maxrss / 1024.0);
+  return 0;
+}
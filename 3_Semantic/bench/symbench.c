@@ -0,0 +1,214 @@
+/****************************************************/
+/* File: symbench.c                                 */
+/* Symbol table benchmark (make bench): inserts N   */
+/* function names into one scope, then looks up     */
+/* names that are there and names that are not,     */
+/* with the open-addressing scopes of symtab.c and  */
+/* with the chained 211-bucket table they replaced  */
+/* usage: symbench                                  */
+/****************************************************/
+
+#include <time.h>
+#include "globals.h"
+#include "symtab.h"
+#include "intern.h"
+
+/* INSERTS = symbols inserted for each scope size,
+   over as many scopes as it takes */
+#define INSERTS 200000
+
+/* each scope is probed LOOKUPS times with PROBES
+   names of each kind, or as many as it holds; the
+   old table takes microseconds per lookup once its
+   chains grow long */
+#define LOOKUPS 4
+#define PROBES 2500
+
+/* STRIDE walks the names in an order unrelated to
+   their insertion; it is prime, so it reaches all */
+#define STRIDE 7919
+
+/* the globals of main.c, tracing off */
+int lineno = 0;
+FILE *source;
+FILE *listing;
+FILE *code;
+
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = FALSE;
+int TraceCode = FALSE;
+int ListXref = FALSE;
+int AnalyzeJobs = 1;
+int MaxErrors = 0;
+int Streaming = FALSE;
+int LazyBodies = FALSE;
+int GlobalsOnly = FALSE;
+int UseIR = FALSE;
+int DumpIR = FALSE;
+int FoldConstants = FALSE;
+
+int Error = FALSE;
+
+/* the scope table before open addressing: 211
+   chained buckets, each symbol and its first line
+   malloc'ed on insertion. Neither table is freed
+   between rounds, so both write fresh memory as in
+   a compilation */
+#define OLD_TABLE_SIZE 211
+
+typedef struct OldLineRec
+{
+  int lineno;
+  struct OldLineRec *next;
+} *OldLine;
+
+typedef struct OldBucketRec
+{
+  char *name;
+  OldLine lines;
+  int memloc;
+  SymbolKind kind;
+  union { ExpType varType; struct { ExpType returnType; void *params; } funType; } type;
+  struct OldBucketRec *next;
+} *OldBucket;
+
+typedef struct
+{
+  OldBucket bucket[OLD_TABLE_SIZE][2]; /* head and tail of each chain */
+  int locationCount;
+} OldScope;
+
+static void oldInsert(OldScope *scope, char *name, SymbolKind kind, ExpType type, int lineno)
+{
+  int h = (int)(nameHash(name) % OLD_TABLE_SIZE);
+  OldBucket b = malloc(sizeof(struct OldBucketRec));
+  b->name = name;
+  b->lines = malloc(sizeof(struct OldLineRec));
+  b->lines->lineno = lineno;
+  b->lines->next = NULL;
+  b->memloc = scope->locationCount++;
+  b->kind = kind;
+  b->type.funType.returnType = type;
+  b->type.funType.params = NULL;
+  b->next = NULL;
+  if (scope->bucket[h][1] == NULL)
+    scope->bucket[h][0] = scope->bucket[h][1] = b;
+  else
+  {
+    scope->bucket[h][1]->next = b;
+    scope->bucket[h][1] = b;
+  }
+}
+
+static OldBucket oldLookup(OldScope *scope, char *name, int kindFlag)
+{
+  OldBucket b = scope->bucket[nameHash(name) % OLD_TABLE_SIZE][0];
+  while (b != NULL && (name != b->name || (b->kind & kindFlag) == 0))
+    b = b->next;
+  return b;
+}
+
+/* seconds returns a monotonic time in seconds */
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Times holds the seconds spent on each operation */
+typedef struct
+{
+  double insert, hit, miss;
+} Times;
+
+/* benchOld and benchNew insert the n names into a
+   fresh global scope and look up names and misses;
+   they return the symbols found, which must agree */
+static long benchOld(char **names, char **misses, int n, int probes, Times *times)
+{
+  OldScope *scope = calloc(1, sizeof(OldScope));
+  long found = 0;
+  double t;
+  int i, k;
+  t = seconds();
+  for (i = 0; i < n; i++)
+    oldInsert(scope, names[i], FuncSymbol, Integer, i);
+  times->insert += seconds() - t;
+  t = seconds();
+  for (k = 0; k < LOOKUPS; k++)
+    for (i = 0; i < probes; i++)
+      found += oldLookup(scope, names[(long)i * STRIDE % n], ALL_SYMBOL) != NULL;
+  times->hit += seconds() - t;
+  t = seconds();
+  for (k = 0; k < LOOKUPS; k++)
+    for (i = 0; i < probes; i++)
+      found += oldLookup(scope, misses[i], ALL_SYMBOL) != NULL;
+  times->miss += seconds() - t;
+  return found;
+}
+
+static long benchNew(char **names, char **misses, int n, int probes, Times *times)
+{
+  ScopeList scope = createGlobalScope();
+  long found = 0;
+  double t;
+  int i, k;
+  t = seconds();
+  for (i = 0; i < n; i++)
+    insertSymbol(scope, names[i], FuncSymbol, Integer, i);
+  times->insert += seconds() - t;
+  t = seconds();
+  for (k = 0; k < LOOKUPS; k++)
+    for (i = 0; i < probes; i++)
+      found += lookupScope(scope, names[(long)i * STRIDE % n], ALL_SYMBOL) != NULL;
+  times->hit += seconds() - t;
+  t = seconds();
+  for (k = 0; k < LOOKUPS; k++)
+    for (i = 0; i < probes; i++)
+      found += lookupScope(scope, misses[i], ALL_SYMBOL) != NULL;
+  times->miss += seconds() - t;
+  return found;
+}
+
+int main(void)
+{
+  static const int sizes[] = { 1000, 10000, 100000 };
+  int s;
+  listing = stdout;
+  printf("  N       insert old/new   hit old/new    miss old/new  (ns/op)\n");
+  for (s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+  {
+    int n = sizes[s], rounds = INSERTS / n, probes = n < PROBES ? n : PROBES, i, r;
+    char **names = malloc(n * sizeof(char *));
+    char **misses = malloc(n * sizeof(char *));
+    Times old = { 0, 0, 0 }, new = { 0, 0, 0 };
+    long oldFound = 0, newFound = 0;
+    double inserts = (double)rounds * n, lookups = (double)rounds * probes * LOOKUPS;
+    char buf[32];
+    for (i = 0; i < n; i++)
+    {
+      names[i] = internName(buf, sprintf(buf, "f%d", i));
+      misses[i] = internName(buf, sprintf(buf, "m%d", i));
+    }
+    for (r = 0; r < rounds; r++)
+    {
+      oldFound += benchOld(names, misses, n, probes, &old);
+      newFound += benchNew(names, misses, n, probes, &new);
+    }
+    if (oldFound != newFound)
+    {
+      fprintf(stderr, "The tables disagree\n");
+      return 1;
+    }
+    printf("  %-7d %5.0f / %-5.0f    %6.0f / %-5.0f   %6.0f / %.0f\n", n,
+           old.insert * 1e9 / inserts, new.insert * 1e9 / inserts,
+           old.hit * 1e9 / lookups, new.hit * 1e9 / lookups,
+           old.miss * 1e9 / lookups, new.miss * 1e9 / lookups);
+    free(names);
+    free(misses);
+  }
+  return 0;
+}
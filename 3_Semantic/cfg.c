@@ -0,0 +1,301 @@
+/****************************************************/
+/* File: cfg.c                                      */
+/* Control flow graph of an IR function: block      */
+/* order, critical edges, dominator tree, dominance */
+/* frontiers and loops                              */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "cfg.h"
+
+/* freeBlock frees the arrays of a dropped block */
+static void freeBlock(IrBlock * b)
+{ free(b->code);
+  free(b->preds);
+  free(b->df);
+}
+
+/* dropPhiOperand removes operand j of every phi
+   of block b, whose predecessor j is gone */
+static void dropPhiOperand(IrFunction * fn, IrBlock * b, int j)
+{ int i, k;
+  for (i = 0; i < b->ncode && b->code[i].op == IrPhi; i++)
+  { IrInstr * phi = &b->code[i];
+    for (k = j; k + 1 < phi->nargs; k++)
+      fn->args[phi->imm + k] = fn->args[phi->imm + k + 1];
+    phi->nargs--;
+  }
+}
+
+void orderBlocks(IrFunction * fn)
+{ int n = fn->nblocks;
+  int * map = malloc(n * sizeof(int));   /* old index -> new, -1 if dropped */
+  int * stack = malloc(n * sizeof(int)); /* depth-first search */
+  int * next = malloc(n * sizeof(int));  /* next successor to visit */
+  int * order = malloc(n * sizeof(int)); /* postorder */
+  IrBlock * blocks;
+  int top = 0, count = 0, b, i, j;
+  if (map == NULL || stack == NULL || next == NULL || order == NULL)
+    irOutOfMemory();
+  for (b = 0; b < n; b++)
+  { map[b] = -1;
+    next[b] = 0;
+  }
+  /* map[b] = -2 while b is on the stack */
+  stack[top++] = 0;
+  map[0] = -2;
+  while (top > 0)
+  { IrBlock * blk;
+    b = stack[top - 1];
+    blk = &fn->blocks[b];
+    if (next[b] < blk->nsucc)
+    { /* the last successor first, so that the first
+         one comes right after b if it can */
+      int s = blk->succ[blk->nsucc - 1 - next[b]++];
+      if (map[s] == -1)
+      { map[s] = -2;
+        stack[top++] = s;
+      }
+      continue;
+    }
+    order[count++] = b;
+    top--;
+  }
+  for (i = 0; i < count; i++)
+    map[order[i]] = count - 1 - i;
+
+  blocks = malloc((count > 0 ? count : 1) * sizeof(IrBlock));
+  if (blocks == NULL)
+    irOutOfMemory();
+  for (b = 0; b < n; b++)
+    if (map[b] < 0)
+      freeBlock(&fn->blocks[b]);
+    else
+      blocks[map[b]] = fn->blocks[b];
+  for (b = 0; b < count; b++)
+  { IrBlock * blk = &blocks[b];
+    for (i = 0; i < blk->nsucc; i++)
+      blk->succ[i] = map[blk->succ[i]];
+    for (i = j = 0; i < blk->npreds; i++)
+      if (map[blk->preds[i]] < 0)
+        dropPhiOperand(fn, blk, j);
+      else
+        blk->preds[j++] = map[blk->preds[i]];
+    blk->npreds = j;
+  }
+  free(fn->blocks);
+  fn->blocks = blocks;
+  fn->nblocks = fn->blockCapacity = count;
+  free(map);
+  free(stack);
+  free(next);
+  free(order);
+}
+
+void removeEdge(IrFunction * fn, int from, int to)
+{ IrBlock * src = &fn->blocks[from], * dst = &fn->blocks[to];
+  int i, j;
+  for (i = 0; i < src->nsucc && src->succ[i] != to; i++)
+    ;
+  if (i == src->nsucc) return;
+  for (; i + 1 < src->nsucc; i++)
+    src->succ[i] = src->succ[i + 1];
+  src->nsucc--;
+  for (j = 0; j < dst->npreds && dst->preds[j] != from; j++)
+    ;
+  if (j == dst->npreds) return;
+  dropPhiOperand(fn, dst, j);
+  for (; j + 1 < dst->npreds; j++)
+    dst->preds[j] = dst->preds[j + 1];
+  dst->npreds--;
+}
+
+void splitCriticalEdges(IrFunction * fn)
+{ int n = fn->nblocks, b, k, i;
+  for (b = 0; b < n; b++)
+  { if (fn->blocks[b].nsucc < 2) continue;
+    for (k = 0; k < fn->blocks[b].nsucc; k++)
+    { int s = fn->blocks[b].succ[k];
+      IrInstr jump;
+      int mid;
+      if (fn->blocks[s].npreds < 2) continue;
+      mid = newBlock(fn);
+      memset(&jump, 0, sizeof(jump));
+      jump.op = IrJump;
+      jump.dst = jump.a = jump.b = -1;
+      appendInstr(fn, mid, &jump);
+      fn->blocks[mid].succ[0] = s;
+      fn->blocks[mid].nsucc = 1;
+      addPred(fn, mid, b);
+      fn->blocks[b].succ[k] = mid;
+      /* mid takes the place of b among the predecessors
+         of s, so the phi operands stay in order */
+      for (i = 0; i < fn->blocks[s].npreds; i++)
+        if (fn->blocks[s].preds[i] == b)
+        { fn->blocks[s].preds[i] = mid;
+          break;
+        }
+    }
+  }
+}
+
+/* intersect returns the nearest common dominator of
+   blocks a and b, walking up from whichever comes
+   later in reverse postorder */
+static int intersect(const IrBlock * blocks, int a, int b)
+{ while (a != b)
+  { while (a > b) a = blocks[a].idom;
+    while (b > a) b = blocks[b].idom;
+  }
+  return a;
+}
+
+/* addFrontier adds f to the dominance frontier of
+   block b, unless it was just added */
+static void addFrontier(IrBlock * b, int f)
+{ if (b->ndf > 0 && b->df[b->ndf - 1] == f)
+    return;
+  /* the frontier grows by doubling: its capacity is
+     the power of two at or above ndf */
+  if ((b->ndf & (b->ndf - 1)) == 0)
+  { b->df = realloc(b->df, (b->ndf == 0 ? 1 : 2 * b->ndf) * sizeof(int));
+    if (b->df == NULL)
+      irOutOfMemory();
+  }
+  b->df[b->ndf++] = f;
+}
+
+void computeDominators(IrFunction * fn)
+{ IrBlock * blocks = fn->blocks;
+  int n = fn->nblocks, b, i, changed = TRUE;
+  int * stack, * cursor;
+  int top = 0, clock = 0;
+
+  for (b = 0; b < n; b++)
+  { blocks[b].idom = -1;
+    blocks[b].domChild = blocks[b].domSibling = -1;
+    free(blocks[b].df);
+    blocks[b].df = NULL;
+    blocks[b].ndf = 0;
+  }
+  if (n == 0) return;
+  blocks[0].idom = 0;
+  while (changed)
+  { changed = FALSE;
+    for (b = 1; b < n; b++)
+    { int idom = -1;
+      for (i = 0; i < blocks[b].npreds; i++)
+      { int p = blocks[b].preds[i];
+        if (blocks[p].idom < 0) continue; /* not processed yet */
+        idom = (idom < 0) ? p : intersect(blocks, p, idom);
+      }
+      if (blocks[b].idom != idom)
+      { blocks[b].idom = idom;
+        changed = TRUE;
+      }
+    }
+  }
+
+  for (b = 1; b < n; b++)
+    if (blocks[b].npreds >= 2)
+      for (i = 0; i < blocks[b].npreds; i++)
+      { int runner = blocks[b].preds[i];
+        while (runner != blocks[b].idom)
+        { addFrontier(&blocks[runner], b);
+          runner = blocks[runner].idom;
+        }
+      }
+  blocks[0].idom = -1;
+
+  /* children in increasing order */
+  for (b = n - 1; b > 0; b--)
+  { int p = blocks[b].idom;
+    blocks[b].domSibling = blocks[p].domChild;
+    blocks[p].domChild = b;
+  }
+  /* number the tree in one depth-first walk;
+     cursor[b] is the next child of b to visit */
+  stack = malloc(n * sizeof(int));
+  cursor = malloc(n * sizeof(int));
+  if (stack == NULL || cursor == NULL)
+    irOutOfMemory();
+  stack[top++] = 0;
+  blocks[0].pre = clock++;
+  cursor[0] = blocks[0].domChild;
+  while (top > 0)
+  { int c;
+    b = stack[top - 1];
+    c = cursor[b];
+    if (c >= 0)
+    { cursor[b] = blocks[c].domSibling;
+      blocks[c].pre = clock++;
+      cursor[c] = blocks[c].domChild;
+      stack[top++] = c;
+      continue;
+    }
+    blocks[b].post = clock++;
+    top--;
+  }
+  free(cursor);
+  free(stack);
+}
+
+/* outermost returns the header of the outermost
+   loop found so far that holds block b, or b if
+   none does */
+static int outermost(const IrBlock * blocks, int b)
+{ if (blocks[b].loopHeader < 0) return b;
+  b = blocks[b].loopHeader;
+  while (blocks[b].loopParent >= 0)
+    b = blocks[b].loopParent;
+  return b;
+}
+
+void findLoops(IrFunction * fn)
+{ IrBlock * blocks = fn->blocks;
+  int n = fn->nblocks, h, b, i;
+  int * stack = malloc((2 * n + 1) * sizeof(int)); /* one push per edge */
+  if (stack == NULL)
+    irOutOfMemory();
+  for (b = 0; b < n; b++)
+  { blocks[b].loopHeader = blocks[b].loopParent = -1;
+    blocks[b].loopDepth = 0;
+  }
+  /* inner loops first: a header comes after the
+     headers of the loops around it. The body of the
+     loop at h is what reaches its back edges without
+     going through h; inner loops found in it join
+     it whole, through their outermost header */
+  for (h = n - 1; h >= 0; h--)
+  { int top = 0;
+    for (i = 0; i < blocks[h].npreds; i++)
+      if (dominates(fn, h, blocks[h].preds[i]))
+        stack[top++] = blocks[h].preds[i];
+    if (top == 0) continue;
+    blocks[h].loopHeader = h;
+    while (top > 0)
+    { b = outermost(blocks, stack[--top]);
+      if (b == h) continue;
+      if (blocks[b].loopHeader == b)
+        blocks[b].loopParent = h;
+      else
+        blocks[b].loopHeader = h;
+      for (i = 0; i < blocks[b].npreds; i++)
+        stack[top++] = blocks[b].preds[i];
+    }
+  }
+  for (b = 0; b < n; b++)
+    if (blocks[b].loopHeader == b)
+      blocks[b].loopDepth = 1 + (blocks[b].loopParent >= 0 ?
+                                 blocks[blocks[b].loopParent].loopDepth : 0);
+    else if (blocks[b].loopHeader >= 0)
+      blocks[b].loopDepth = blocks[blocks[b].loopHeader].loopDepth;
+  free(stack);
+}
+
+int dominates(const IrFunction * fn, int a, int b)
+{ return fn->blocks[a].pre <= fn->blocks[b].pre &&
+         fn->blocks[b].post <= fn->blocks[a].post;
+}
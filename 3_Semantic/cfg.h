@@ -0,0 +1,56 @@
+/****************************************************/
+/* File: cfg.h                                      */
+/* Control flow graph of an IR function: block      */
+/* order, critical edges, dominator tree, dominance */
+/* frontiers and loops                              */
+/****************************************************/
+
+#ifndef _CFG_H_
+#define _CFG_H_
+
+/* Procedure orderBlocks drops the blocks of fn that
+ * cannot be reached from the entry, with their
+ * edges and the phi operands coming from them, and
+ * renumbers the others in reverse postorder
+ */
+void orderBlocks(IrFunction * fn);
+
+/* Procedure removeEdge removes the edge from block
+ * from to block to: to is no longer a successor of
+ * from, which loses its predecessor entry in to
+ * with the phi operands coming along it. The caller
+ * fixes the terminator of from
+ */
+void removeEdge(IrFunction * fn, int from, int to);
+
+/* Procedure splitCriticalEdges puts an empty block
+ * on every edge from a block with two successors to
+ * a block with two or more predecessors, so that the
+ * copies of phi operands have a block of their own.
+ * The new blocks are appended: call orderBlocks
+ * after it
+ */
+void splitCriticalEdges(IrFunction * fn);
+
+/* Procedure computeDominators fills in the
+ * immediate dominators, the dominator tree and the
+ * dominance frontiers of the blocks of fn, which
+ * must be in reverse postorder (Cooper, Harvey and
+ * Kennedy, "A Simple, Fast Dominance Algorithm")
+ */
+void computeDominators(IrFunction * fn);
+
+/* Procedure findLoops finds the natural loops of
+ * fn, after computeDominators: each block gets the
+ * header of the innermost loop holding it and its
+ * loop depth, and each header the header of the
+ * loop around it
+ */
+void findLoops(IrFunction * fn);
+
+/* Function dominates is TRUE if block a dominates
+ * block b, after computeDominators
+ */
+int dominates(const IrFunction * fn, int a, int b);
+
+#endif
@@ -0,0 +1,523 @@
+/****************************************************/
+/* File: cgen.c                                     */
+/* The code generator implementation                */
+/* for the C-MINUS compiler                         */
+/* (generates code for the TM machine)              */
+/* Compiler Construction: Principles and Practice   */
+/* Kenneth C. Louden                                */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "code.h"
+#include "ir.h"
+#include "irgen.h"
+#include "fold.h"
+#include "opt.h"
+#include "cgen.h"
+
+/* Run-time memory: global variables from address 0
+ * up (relative to gp, which stays 0), and a stack of
+ * activation records growing down from the top of
+ * memory. A call to a function of n parameters
+ * builds its record at mp:
+ *
+ *     0(fp)       caller's fp
+ *    -1(fp)       return address
+ *    -2(fp) ...   arguments 1..n (array arguments
+ *                 are addresses)
+ *    below        local variables of every block,
+ *                 then temporaries from mp down
+ *
+ * The result of a function is returned in ac. With
+ * option --ir the body is generated from its SSA
+ * form, once optimized (opt.c), by irgen.c, which
+ * keeps values in registers or in words of the
+ * record instead of pushing temporaries
+ */
+
+/* INITFRAMES = initial depth of the generator's
+   explicit stack; it doubles as needed */
+#define INITFRAMES 256
+
+/* tmpOffset is the memory offset for temps
+   It is decremented each time a temp is
+   stored, and incremeted when loaded again
+*/
+static int tmpOffset = 0;
+
+/* frameDepth = words of the current activation
+   record in use; frameSize = the most so far,
+   which the prologue allocates */
+static int frameDepth, frameSize;
+
+/* globalSize = words of global variables */
+static int globalSize = 0;
+
+/* foldedNodes = nodes simplified by foldConstants
+   (option --fold) */
+static int foldedNodes = 0;
+
+/* labels of the end of the current function and
+   of main, which the prelude calls */
+static int returnLabel;
+static int mainLabel;
+
+/* Frame is one node being generated by genTree,
+   with the state of its code so far */
+typedef struct
+{ TreeNode * t;
+  int state;    /* resume point in genStmt or genExp */
+  int a, b;     /* labels or saved values, by node kind */
+  TreeNode * cursor; /* next statement or argument */
+} Frame;
+
+/* isArrayParam is TRUE if b is an array parameter,
+   whose word holds the address of the array */
+static int isArrayParam(BucketList b)
+{ return !isGlobal(b) && b->type.varType == IntegerArray &&
+         b->address >= -(1 + b->scope->function->type.funType.paramCount);
+}
+
+/* declareVar gives the variable declared by decl its
+   address: the next words of global memory, or of
+   the current activation record */
+static void declareVar(TreeNode * decl)
+{ BucketList b = decl->symbol;
+  int size = (decl->type == IntegerArray) ? decl->child[0]->attr.val : 1;
+  if (b == NULL) return;
+  if (isGlobal(b))
+  { b->address = globalSize;
+    globalSize += size;
+  }
+  else
+  { /* element 0 of an array lies lowest */
+    frameDepth += size;
+    b->address = -(frameDepth - 1);
+    if (frameSize < frameDepth) frameSize = frameDepth;
+  }
+}
+
+/* emitAddress loads into register r the address of
+   the storage of variable b */
+static void emitAddress(BucketList b, int r)
+{ if (isArrayParam(b))
+    emitRM(opLD,r,b->address,fp,"load array address");
+  else
+    emitRM(opLDA,r,b->address,isGlobal(b) ? gp : fp,"load address");
+}
+
+/* emitCallStart begins a call: it saves fp in the
+   first word of the new activation record and
+   leaves mp below its return address word, where
+   the arguments are pushed */
+static void emitCallStart(void)
+{ emitRM(opST,fp,0,mp,"call: save frame pointer");
+  emitRM(opLDA,mp,-2,mp,"call: skip return address");
+}
+
+/* emitCallJump ends a call of args arguments to the
+   function at label: it sets fp to the new record,
+   stores the return address and jumps */
+static void emitCallJump(int label, int args)
+{ emitRM(opLDA,fp,args + 2,mp,"call: new frame");
+  emitRM(opLDA,ac,2,pc,"call: return address");
+  emitRM(opST,ac,-1,fp,"call: store return address");
+  emitRM_Label(opLDA,pc,label,"call: jump to function");
+}
+
+/* emitReturn pops the current activation record
+   and returns to the caller */
+static void emitReturn(void)
+{ emitRM(opLD,ac1,-1,fp,"load return address");
+  emitRM(opLDA,mp,0,fp,"pop frame");
+  emitRM(opLD,fp,0,fp,"restore frame pointer");
+  emitRM(opLDA,pc,0,ac1,"return to caller");
+}
+
+/* emitBinaryOp computes ac1 op ac into ac */
+static void emitBinaryOp(TokenType op)
+{ switch (op)
+  { case PLUS :
+      emitRO(opADD,ac,ac1,ac,"op +");
+      break;
+    case MINUS :
+      emitRO(opSUB,ac,ac1,ac,"op -");
+      break;
+    case TIMES :
+      emitRO(opMUL,ac,ac1,ac,"op *");
+      break;
+    case OVER :
+      emitRO(opDIV,ac,ac1,ac,"op /");
+      break;
+    default :
+    { TmOpcode jump;
+      switch (op)
+      { case LT : jump = opJLT; break;
+        case LE : jump = opJLE; break;
+        case GT : jump = opJGT; break;
+        case GE : jump = opJGE; break;
+        case EQ : jump = opJEQ; break;
+        default : jump = opJNE; break;
+      }
+      emitRO(opSUB,ac,ac1,ac,"op: compare");
+      emitRM(jump,ac,2,pc,"br if true");
+      emitRM(opLDC,ac,0,ac,"false case");
+      emitRM(opLDA,pc,1,pc,"unconditional jmp");
+      emitRM(opLDC,ac,1,ac,"true case");
+      break;
+    }
+  }
+}
+
+/* genStmt generates the code of statement f->t
+ * from resume point f->state on, and returns the
+ * child to generate next, or NULL once f->t is done
+ */
+static TreeNode * genStmt(Frame * f)
+{ TreeNode * t = f->t;
+  TreeNode * decl;
+  switch (t->kind.stmt) {
+
+    case CompoundK :
+      if (f->state == 0)
+      { f->a = frameDepth;
+        if (t->child[0] != NULL)
+          for (decl = t->child[0]->child[0]; decl != NULL; decl = decl->sibling)
+            declareVar(decl);
+        f->cursor = (t->child[1] != NULL) ? t->child[1]->child[0] : NULL;
+        f->state = 1;
+      }
+      if (f->cursor != NULL)
+      { TreeNode * next = f->cursor;
+        f->cursor = next->sibling;
+        return next;
+      }
+      /* the words of the block are free again */
+      frameDepth = f->a;
+      return NULL;
+
+    case SelectK :
+      switch (f->state++)
+      { case 0 :
+          emitComment("-> if");
+          return t->child[0];
+        case 1 :
+          f->a = newLabel();
+          emitRM_Label(opJEQ,ac,f->a,"if: jmp to else");
+          return t->child[1];
+        case 2 :
+          if (t->child[2] != NULL)
+          { f->b = newLabel();
+            emitRM_Label(opLDA,pc,f->b,"jmp to end");
+            placeLabel(f->a);
+            return t->child[2];
+          }
+          placeLabel(f->a);
+          emitComment("<- if");
+          return NULL;
+        default :
+          placeLabel(f->b);
+          emitComment("<- if");
+          return NULL;
+      }
+
+    case IterK :
+      switch (f->state++)
+      { case 0 :
+          emitComment("-> while");
+          f->a = newLabel();
+          f->b = newLabel();
+          placeLabel(f->a);
+          return t->child[0];
+        case 1 :
+          emitRM_Label(opJEQ,ac,f->b,"while: jmp to end");
+          return t->child[1];
+        default :
+          emitRM_Label(opLDA,pc,f->a,"while: jmp back to test");
+          placeLabel(f->b);
+          emitComment("<- while");
+          return NULL;
+      }
+
+    case RetK :
+      if (f->state++ == 0 && t->child[0] != NULL)
+        return t->child[0];
+      emitRM_Label(opLDA,pc,returnLabel,"return");
+      return NULL;
+
+    default :
+      return NULL;
+  }
+} /* genStmt */
+
+/* genExp generates the code of expression f->t
+ * from resume point f->state on, leaving its value
+ * in ac, and returns the child to generate next,
+ * or NULL once f->t is done
+ */
+static TreeNode * genExp(Frame * f)
+{ TreeNode * t = f->t;
+  BucketList b = t->symbol;
+  switch (t->kind.exp) {
+
+    case ConstK :
+      emitRM(opLDC,ac,t->attr.val,0,"load const");
+      return NULL;
+
+    case IdK :
+      if (t->child[0] == NULL)
+      { if (b->type.varType == IntegerArray)
+          emitAddress(b,ac); /* an array stands for its address */
+        else
+          emitRM(opLD,ac,b->address,isGlobal(b) ? gp : fp,"load id value");
+        return NULL;
+      }
+      if (f->state++ == 0)
+        return t->child[0];
+      emitAddress(b,ac1);
+      emitRO(opADD,ac,ac1,ac,"index: element address");
+      emitRM(opLD,ac,0,ac,"index: load element");
+      return NULL;
+
+    case AssignK :
+    { TreeNode * var = t->child[0];
+      b = var->symbol;
+      if (var->child[0] == NULL)
+      { if (f->state++ == 0)
+          return t->child[1];
+        emitRM(opST,ac,b->address,isGlobal(b) ? gp : fp,"assign: store value");
+        return NULL;
+      }
+      switch (f->state++)
+      { case 0 :
+          return var->child[0];
+        case 1 :
+          emitAddress(b,ac1);
+          emitRO(opADD,ac,ac1,ac,"assign: element address");
+          emitRM(opST,ac,tmpOffset--,mp,"assign: push address");
+          return t->child[1];
+        default :
+          emitRM(opLD,ac1,++tmpOffset,mp,"assign: load address");
+          emitRM(opST,ac,0,ac1,"assign: store value");
+          return NULL;
+      }
+    }
+
+    case BinaryOpK :
+      switch (f->state++)
+      { case 0 :
+          return t->child[0];
+        case 1 :
+          emitRM(opST,ac,tmpOffset--,mp,"op: push left");
+          return t->child[1];
+        default :
+          emitRM(opLD,ac1,++tmpOffset,mp,"op: load left");
+          emitBinaryOp(t->attr.op);
+          return NULL;
+      }
+
+    case CallK :
+      if (isBuiltin(b,"input"))
+      { emitRO(opIN,ac,0,0,"read integer value");
+        return NULL;
+      }
+      if (isBuiltin(b,"output"))
+      { if (f->state++ == 0)
+          return t->child[0]->child[0];
+        emitRO(opOUT,ac,0,0,"write ac");
+        return NULL;
+      }
+      switch (f->state)
+      { case 0 :
+          emitNameComment("-> call ",t->attr.name);
+          /* the record goes below the live temps */
+          f->a = tmpOffset;
+          if (tmpOffset != 0)
+            emitRM(opLDA,mp,tmpOffset,mp,"call: skip temps");
+          tmpOffset = 0;
+          emitCallStart();
+          f->b = 0;
+          f->cursor = (t->child[0] != NULL) ? t->child[0]->child[0] : NULL;
+          f->state = 1;
+          /* fall through */
+        case 1 :
+          if (f->cursor != NULL)
+          { TreeNode * next = f->cursor;
+            f->cursor = next->sibling;
+            f->state = 2;
+            return next;
+          }
+          emitCallJump(b->address,f->b);
+          if (f->a != 0)
+            emitRM(opLDA,mp,-f->a,mp,"call: restore temps");
+          tmpOffset = f->a;
+          emitNameComment("<- call ",t->attr.name);
+          return NULL;
+        default :
+          emitRM(opST,ac,0,mp,"call: push argument");
+          emitRM(opLDA,mp,-1,mp,"");
+          f->b++;
+          f->state = 1;
+          return genExp(f);
+      }
+
+    default :
+      return NULL;
+  }
+} /* genExp */
+
+/* Procedure genTree generates the code of the
+ * statement or expression t. Like the tree walks
+ * of visit.c it keeps an explicit stack, so that
+ * deeply nested code does not overflow the C stack
+ */
+static void genTree(TreeNode * t)
+{ int capacity = INITFRAMES, top = 0;
+  Frame * stack = malloc(capacity * sizeof(Frame));
+  if (stack == NULL)
+  { fprintf(stderr, "Out of memory error while generating code\n");
+    exit(1);
+  }
+  stack[top].t = t;
+  stack[top].state = 0;
+  top++;
+  while (top > 0)
+  { Frame * f = &stack[top - 1];
+    TreeNode * next = (f->t->nodekind == StmtK) ? genStmt(f) : genExp(f);
+    if (next == NULL)
+    { top--;
+      continue;
+    }
+    if (top == capacity)
+    { capacity *= 2;
+      stack = realloc(stack, capacity * sizeof(Frame));
+      if (stack == NULL)
+      { fprintf(stderr, "Out of memory error while generating code\n");
+        exit(1);
+      }
+    }
+    stack[top].t = next;
+    stack[top].state = 0;
+    top++;
+  }
+  free(stack);
+}
+
+/* genFunction generates the code of the function
+   declared by decl: its prologue, its body and one
+   epilogue where every return goes */
+static void genFunction(TreeNode * decl)
+{ TreeNode * param;
+  int allocLoc;
+
+  frameDepth = 2;
+  if (decl->child[0] != NULL)
+    for (param = decl->child[0]->child[0]; param != NULL; param = param->sibling)
+      if (param->symbol != NULL)
+        param->symbol->address = -(frameDepth++);
+  frameSize = frameDepth;
+  returnLabel = newLabel();
+  /* the frame size is known at the end of the body */
+  allocLoc = emitRM(opLDA,mp,0,fp,"allocate frame");
+
+  genTree(decl->child[1]);
+
+  patchRM(allocLoc,-frameSize);
+  placeLabel(returnLabel);
+  emitReturn();
+}
+
+/* genFunctionIr generates the code of the function
+   declared by decl through its optimized SSA form
+   (option --ir), printing the IR with option
+   --dump-ir */
+static void genFunctionIr(TreeNode * decl)
+{ IrFunction * fn = buildIr(decl);
+  optimizeIr(fn);
+  if (DumpIR)
+    printIr(listing, fn);
+  if (verifyIr(stderr, fn) > 0)
+  { fprintf(stderr, "Invalid IR for function %s\n", decl->attr.name);
+    exit(1);
+  }
+  genIrFunction(fn);
+  freeIr(fn);
+}
+
+/* Procedure startCode begins the code of a
+ * program with the standard prelude, which calls
+ * main and then halts
+ */
+void startCode(char * codefile)
+{ tmpOffset = 0;
+  globalSize = 0;
+  foldedNodes = 0;
+  emitComment("C-MINUS Compilation to TM Code");
+  emitNameComment("File: ",codefile);
+  /* generate standard prelude */
+  emitComment("Standard prelude:");
+  emitRM(opLD,mp,0,ac,"load maxaddress from location 0");
+  emitRM(opST,ac,0,ac,"clear location 0");
+  emitComment("End of standard prelude.");
+  mainLabel = newLabel();
+  emitCallStart();
+  emitCallJump(mainLabel,0);
+  emitRO(opHALT,0,0,0,"");
+}
+
+/* Procedure genDecl generates the code of one
+ * top-level declaration of the program begun by
+ * startCode, after it has been analyzed
+ */
+void genDecl(TreeNode * decl)
+{ if (decl->nodekind != DeclK) return;
+  if (decl->kind.decl == FunK)
+  { BucketList f = decl->symbol;
+    emitNameComment("-> function ",decl->attr.name);
+    f->address = newLabel();
+    placeLabel(f->address);
+    if (strcmp(decl->attr.name,"main") == 0)
+      placeLabel(mainLabel);
+    if (FoldConstants)
+      foldedNodes += foldConstants(decl);
+    if (UseIR)
+      genFunctionIr(decl);
+    else
+      genFunction(decl);
+    emitNameComment("<- function ",decl->attr.name);
+  }
+  else
+    declareVar(decl);
+}
+
+/* Procedure finishCode writes the code of the
+ * program to the code file
+ */
+void finishCode(void)
+{ if (!labelPlaced(mainLabel))
+  { /* no main: the call returns at once */
+    placeLabel(mainLabel);
+    emitReturn();
+  }
+  if (FoldConstants)
+    fprintf(listing,"\nConstant folding: %d nodes folded\n",foldedNodes);
+  writeCode(code);
+}
+
+/**********************************************/
+/* the primary function of the code generator */
+/**********************************************/
+/* Procedure codeGen generates code to a code
+ * file by traversal of the syntax tree. The
+ * second parameter (codefile) is the file name
+ * of the code file, and is used to print the
+ * file name as a comment in the code file
+ */
+void codeGen(TreeNode * syntaxTree, char * codefile)
+{ TreeNode * decl;
+  startCode(codefile);
+  for (decl = syntaxTree->child[0]; decl != NULL; decl = decl->sibling)
+    genDecl(decl);
+  finishCode();
+}
@@ -0,0 +1,31 @@
+/****************************************************/
+/* File: cgen.h                                     */
+/* The code generator interface to the C-MINUS      */
+/* compiler                                         */
+/* Compiler Construction: Principles and Practice   */
+/* Kenneth C. Louden                                */
+/****************************************************/
+
+#ifndef _CGEN_H_
+#define _CGEN_H_
+
+/* Procedure codeGen generates code to a code
+ * file by traversal of the syntax tree. The
+ * second parameter (codefile) is the file name
+ * of the code file, and is used to print the
+ * file name as a comment in the code file
+ */
+void codeGen(TreeNode * syntaxTree, char * codefile);
+
+/* Procedures startCode, genDecl and finishCode
+ * do what codeGen does one top-level declaration
+ * at a time, for a streamed compilation: genDecl
+ * must be called on each declaration after it is
+ * analyzed and before its local scopes are
+ * released, and finishCode writes the code file
+ */
+void startCode(char * codefile);
+void genDecl(TreeNode * decl);
+void finishCode(void);
+
+#endif
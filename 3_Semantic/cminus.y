@@ -7,15 +7,29 @@
 %{
 #define YYPARSER /* distinguishes Yacc output from other code files */
 
+/* the parser stack starts small and doubles as needed;
+   raise its limit (10000 by default) so that deeply
+   nested expressions and statements still parse */
+#define YYMAXDEPTH 10000000
+
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
 #include "parse.h"
+#include "intern.h"
+#include "diag.h"
 
 static char * savedName; /* for use in assignments */
 static int savedLineNo;  /* ditto */
 static TreeNode * savedTree; /* stores syntax tree for later return */
 static int yylex(void); // added 11/2/11 to ensure no conflict with lex
+static void streamDecl(TreeNode * decl);
+static DiagBuffer syntaxErrors; /* listed when parsing is done */
+static DeclFun declHandler = NULL; /* parseStream: called on each decl */
+static void * declContext;
+static int parsingBody = FALSE; /* parseBody: "{" starts no lazy body */
+static int bodyStart = FALSE;   /* parseBody: BODY_START comes first */
+static int bodyUnclosed = FALSE; /* yylex ended the parse at an unclosed body */
 
 %}
 
@@ -37,24 +51,36 @@ static int yylex(void); // added 11/2/11 to ensure no conflict with lex
 %token LPAREN RPAREN LBRACE RBRACE LCURLY RCURLY SEMI COMMA
 %token IF ELSE WHILE RETURN INT VOID
 %token ERROR
+%token<node> LAZY_BODY
+%token BODY_START
 
 %type<type_spec> type_spec
-%type<node> decl_list decl var_decl var fun_decl params param_list param cmpnd_stmt local_decls stmt_list stmt expr_stmt compl_stmt incompl_stmt ret_stmt expr simple_expr addtv_expr term factor call args arg_list
+%type<node> decl_list decl var_decl var fun_decl params param_list param fun_body cmpnd_stmt local_decls stmt_list stmt expr_stmt compl_stmt incompl_stmt ret_stmt expr simple_expr addtv_expr term factor call args arg_list
 %type<op_type> relop addop mulop
 
 %% /* Grammar for C-Minus */
 
 program     : decl_list { savedTree = $1; }
+            | BODY_START cmpnd_stmt { savedTree = $2; }
             ;
 decl_list   : decl_list decl {
               $$ = $1;
-              $$->attr.lastChildOfList->sibling = $2;
-              $$->attr.lastChildOfList = $2;
+              if (declHandler != NULL) {
+                streamDecl($2);
+              } else {
+                $$->attr.lastChildOfList->sibling = $2;
+                $$->attr.lastChildOfList = $2;
+              }
             }
             | decl {
-              $$ = newListNode(DeclListK); 
-              $$->child[0] = $1;
-              $$->attr.lastChildOfList = $1;
+              if (declHandler != NULL) {
+                $$ = NULL;
+                streamDecl($1);
+              } else {
+                $$ = newListNode(DeclListK); 
+                $$->child[0] = $1;
+                $$->attr.lastChildOfList = $1;
+              }
             }
             ;
 decl        : var_decl { $$ = $1; }
@@ -74,7 +100,7 @@ var_decl    : type_spec ID LBRACE NUM RBRACE SEMI {
                   yyerror("token type_spec has invalid semantic value.");
                   // YYABORT;
               }
-              $$->attr.name = copyString($2);
+              $$->attr.name = $2;
 
               $$->child[0] = newExpNode(ConstK);
               $$->child[0]->attr.val = $4;
@@ -82,13 +108,13 @@ var_decl    : type_spec ID LBRACE NUM RBRACE SEMI {
             | type_spec ID SEMI {
               $$ = newDeclNode(VarK);
               $$->type = $1;
-              $$->attr.name = copyString($2);
+              $$->attr.name = $2;
             }
             ;
 type_spec   : INT { $$ = Integer; }
             | VOID { $$ = Void; }
             ;
-fun_decl    : type_spec ID LPAREN params RPAREN cmpnd_stmt {
+fun_decl    : type_spec ID LPAREN params RPAREN fun_body {
               $$ = newDeclNode(FunK);
               $$->type = $1;
               $$->attr.name = $2;
@@ -96,11 +122,15 @@ fun_decl    : type_spec ID LPAREN params RPAREN cmpnd_stmt {
               $$->child[1] = $6;
             }
             ;
+fun_body    : cmpnd_stmt { $$ = $1; }
+            | LAZY_BODY { $$ = $1; }
+            ;
 params      : param_list { $$ = $1; }
             | VOID {
               $$ = newListNode(ParamListK);
-              $$->child[0] = $$->child[1] = newDeclNode(ParamK);
-              $$->attr.name = NULL;
+              $$->child[0] = newDeclNode(ParamK);
+              $$->child[0]->attr.name = NULL;
+              $$->attr.lastChildOfList = $$->child[0];
             }
             ;
 param_list  : param_list COMMA param { 
@@ -129,12 +159,12 @@ param       : type_spec ID LBRACE RBRACE {
                   // YYABORT;
               }
 
-              $$->attr.name = copyString($2);
+              $$->attr.name = $2;
             }
             | type_spec ID {
               $$ = newDeclNode(ParamK);
               $$->type = $1;
-              $$->attr.name = copyString($2);
+              $$->attr.name = $2;
             }
             ;
 cmpnd_stmt  : LCURLY local_decls stmt_list RCURLY {
@@ -225,12 +255,12 @@ expr        : var ASSIGN expr {
             ;
 var         : ID LBRACE expr RBRACE {
               $$ = newExpNode(IdK);
-              $$->attr.name = copyString($1);
+              $$->attr.name = $1;
               $$->child[0] = $3;
             }
             | ID { 
               $$ = newExpNode(IdK);
-              $$->attr.name = copyString($1);
+              $$->attr.name = $1;
             }
             ;
 simple_expr : addtv_expr relop addtv_expr {
@@ -280,7 +310,7 @@ factor      : LPAREN expr RPAREN { $$ = $2; }
             ;
 call        : ID LPAREN args RPAREN {
               $$ = newExpNode(CallK);
-              $$->attr.name = copyString($1);
+              $$->attr.name = $1;
               $$->child[0] = $3;
             }
             ;
@@ -301,21 +331,110 @@ arg_list    : arg_list COMMA expr {
 %%
 
 int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
-  fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString);
+{ char * lexeme;
+  if (bodyUnclosed) /* already reported where the body opens */
+    return 0;
+  lexeme = currentTokenString();
+  addSyntaxError(&syntaxErrors,lineno,message,yychar,
+                 internName(lexeme,strlen(lexeme)));
   Error = TRUE;
   return 0;
 }
 
 /* yylex calls getToken to make Yacc/Bison output
- * compatible with ealier versions of the TINY scanner
+ * compatible with ealier versions of the TINY scanner.
+ * Semantic values are taken straight from the
+ * token's slice of the source text; identifiers
+ * are interned once here and shared from then on.
+ * With LazyBodies, a "{" outside of parseBody can
+ * only open a function body: the whole block is
+ * skipped and returned as one LAZY_BODY token. A
+ * body that is never closed is a syntax error on
+ * its first line, and ends the parse
  */
 static int yylex(void)
-{ return getToken(); }
+{ TokenType token;
+  if (bodyStart)
+  { bodyStart = FALSE;
+    return BODY_START;
+  }
+  token = getToken();
+  if (token == LCURLY && LazyBodies && !parsingBody)
+  { LazyBody body;
+    if (!skipBlock(&body))
+    { addSyntaxError(&syntaxErrors,body.lineno,"function body is not closed",
+                     LCURLY,internName("{",1));
+      Error = bodyUnclosed = TRUE;
+      return 0; /* end of input */
+    }
+    yylval.node = newLazyBodyNode(&body);
+    return LAZY_BODY;
+  }
+  if (token == ID)
+  { Lexeme l = currentLexeme();
+    yylval.id_name = internName(l.text, l.len);
+  }
+  else if (token == NUM)
+  { Lexeme l = currentLexeme();
+    int i;
+    yylval.num_value = 0;
+    for (i = 0; i < l.len; i++)
+      yylval.num_value = yylval.num_value * 10 + (l.text[i] - '0');
+  }
+  return token;
+}
 
 TreeNode * parse(void)
-{ yyparse();
+{ bodyUnclosed = FALSE;
+  yyparse();
+  flushDiagnostics(&syntaxErrors,listing);
+  freeDiagnostics(&syntaxErrors);
   return savedTree;
 }
 
+/* streamDecl hands one complete declaration to the
+ * parseStream handler and then releases its nodes.
+ * When decl_list reduces, the parser holds no other
+ * node (at most a lookahead token), so every node
+ * allocated so far belongs to decl
+ */
+static void streamDecl(TreeNode * decl)
+{ if (!Error)
+    declHandler(decl, declContext);
+  resetTrees();
+}
+
+void parseBody(TreeNode * body)
+{ TreeNode * sibling = body->sibling;
+  if (body->attr.lazy == NULL)
+    return;
+  scanBody(body->attr.lazy);
+  parsingBody = bodyStart = TRUE;
+  savedTree = NULL;
+  yyparse();
+  flushDiagnostics(&syntaxErrors,listing);
+  if (savedTree != NULL)
+    *body = *savedTree;
+  else /* a syntax error: leave an empty block */
+    body->attr.lazy = NULL;
+  body->sibling = sibling;
+}
+
+void parseBodies(TreeNode * tree)
+{ TreeNode * decl;
+  if (tree == NULL)
+    return;
+  for (decl = tree->child[0]; decl != NULL; decl = decl->sibling)
+    if (decl->nodekind == DeclK && decl->kind.decl == FunK)
+      parseBody(decl->child[1]);
+}
+
+void parseStream(DeclFun handler, void * context)
+{ declHandler = handler;
+  declContext = context;
+  yyparse();
+  declHandler = NULL;
+  flushDiagnostics(&syntaxErrors,listing);
+  freeDiagnostics(&syntaxErrors);
+}
+
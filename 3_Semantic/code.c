@@ -0,0 +1,222 @@
+/****************************************************/
+/* File: code.c                                     */
+/* TM Code emitting utilities                       */
+/* implementation for the C-MINUS compiler: the     */
+/* code is built in memory, jumps to labels are     */
+/* backpatched, and the file is written at the end  */
+/* Compiler Construction: Principles and Practice   */
+/* Kenneth C. Louden                                */
+/****************************************************/
+
+#include "globals.h"
+#include "code.h"
+
+/* INITCODE = initial capacity of each code array */
+#define INITCODE 1024
+
+/* OUTBUF = bytes of listing formatted before each
+   write of writeCode */
+#define OUTBUF 65536
+
+/* Instruction is one emitted TM instruction; for
+   register-only instructions d is the t operand */
+typedef struct
+{ unsigned char op; /* a TmOpcode */
+  signed char r;
+  signed char s;
+  int d;
+} Instruction;
+
+/* CodeComment is a comment line printed before the
+   instruction at loc, or after it on the same line
+   if trailing */
+typedef struct
+{ int loc;
+  int trailing;
+  const char * text;
+  const char * name; /* printed after text, or NULL */
+} CodeComment;
+
+/* Label is a code location known once placed; the
+   jumps emitted to it before that are chained
+   through their d fields, starting at pending */
+typedef struct
+{ int loc;     /* -1 until placed */
+  int pending; /* last unpatched jump, -1 if none */
+} Label;
+
+static const char * opName[] =
+{ "HALT", "IN", "OUT", "ADD", "SUB", "MUL", "DIV",
+  "LD", "ST",
+  "LDA", "LDC", "JLT", "JLE", "JGT", "JGE", "JEQ", "JNE"
+};
+
+static Instruction * instr = NULL; /* instr[i] is at TM location i */
+static int emitLoc = 0, instrCapacity = 0;
+static CodeComment * comments = NULL;
+static int commentCount = 0, commentCapacity = 0;
+static Label * labels = NULL;
+static int labelCount = 0, labelCapacity = 0;
+
+/* grow doubles the capacity of one of the code
+   arrays when it is full */
+static void * grow(void * array, int count, int * capacity, size_t elemSize)
+{ if (count == *capacity)
+  { *capacity = *capacity == 0 ? INITCODE : *capacity * 2;
+    array = realloc(array, *capacity * elemSize);
+    if (array == NULL)
+    { fprintf(stderr, "Out of memory error while generating code\n");
+      exit(1);
+    }
+  }
+  return array;
+}
+
+static void addComment(int trailing, const char * text, const char * name)
+{ comments = grow(comments, commentCount, &commentCapacity, sizeof(CodeComment));
+  comments[commentCount].loc = emitLoc;
+  comments[commentCount].trailing = trailing;
+  comments[commentCount].text = text;
+  comments[commentCount].name = name;
+  commentCount++;
+}
+
+/* emit appends one instruction at emitLoc */
+static int emit(TmOpcode op, int r, int s, int d, const char * c)
+{ instr = grow(instr, emitLoc, &instrCapacity, sizeof(Instruction));
+  instr[emitLoc].op = (unsigned char) op;
+  instr[emitLoc].r = (signed char) r;
+  instr[emitLoc].s = (signed char) s;
+  instr[emitLoc].d = d;
+  if (TraceCode && c != NULL) addComment(TRUE, c, NULL);
+  return emitLoc++;
+}
+
+/* Procedure emitComment records a comment line
+ * with comment c, if TraceCode is TRUE
+ */
+void emitComment( const char * c )
+{ if (TraceCode) addComment(FALSE, c, NULL); }
+
+/* Procedure emitNameComment records a comment
+ * line with comment c followed by name, if
+ * TraceCode is TRUE
+ */
+void emitNameComment( const char * c, const char * name )
+{ if (TraceCode) addComment(FALSE, c, name); }
+
+/* Procedure emitRO emits a register-only
+ * TM instruction
+ * op = the opcode
+ * r = target register
+ * s = 1st source register
+ * t = 2nd source register
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+void emitRO( TmOpcode op, int r, int s, int t, const char *c)
+{ emit(op, r, s, t, c); }
+
+/* Function emitRM emits a register-to-memory
+ * TM instruction and returns its location
+ * op = the opcode
+ * r = target register
+ * d = the offset
+ * s = the base register
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+int emitRM( TmOpcode op, int r, int d, int s, const char *c)
+{ return emit(op, r, s, d, c); }
+
+/* Procedure patchRM sets the offset of the
+ * register-to-memory instruction at loc to d
+ */
+void patchRM( int loc, int d)
+{ instr[loc].d = d; }
+
+/* Function newLabel returns a label for a code
+ * location that is placed later
+ */
+int newLabel(void)
+{ labels = grow(labels, labelCount, &labelCapacity, sizeof(Label));
+  labels[labelCount].loc = -1;
+  labels[labelCount].pending = -1;
+  return labelCount++;
+}
+
+/* Procedure placeLabel makes the next emitted
+ * instruction the location of label, and
+ * backpatches the jumps already emitted to it
+ */
+void placeLabel( int label)
+{ int loc = labels[label].pending;
+  labels[label].loc = emitLoc;
+  while (loc >= 0)
+  { int next = instr[loc].d;
+    instr[loc].d = emitLoc - (loc + 1);
+    loc = next;
+  }
+  labels[label].pending = -1;
+}
+
+/* Function labelPlaced is TRUE once placeLabel
+ * has been called on label
+ */
+int labelPlaced( int label)
+{ return labels[label].loc >= 0; }
+
+/* Procedure emitRM_Label emits a pc-relative
+ * register-to-memory TM instruction whose target
+ * is label, typically a jump
+ * op = the opcode
+ * r = target register
+ * label = a label from newLabel
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+void emitRM_Label( TmOpcode op, int r, int label, const char *c)
+{ if (labels[label].loc >= 0)
+    emit(op, r, pc, labels[label].loc - (emitLoc + 1), c);
+  else /* chain it until the label is placed */
+    labels[label].pending = emit(op, r, pc, labels[label].pending, c);
+}
+
+/* Procedure writeCode prints every instruction
+ * emitted so far to out in TM format, in one pass,
+ * and empties the code buffer
+ */
+void writeCode( FILE * out)
+{ char * buf = malloc(OUTBUF);
+  int used = 0, loc, k = 0;
+  if (buf == NULL)
+  { fprintf(stderr, "Out of memory error while writing code\n");
+    exit(1);
+  }
+  for (loc = 0; loc <= emitLoc; loc++)
+  { /* a line is at most a few words and a comment */
+    for (; k < commentCount && comments[k].loc == loc && !comments[k].trailing; k++)
+    { if (used > OUTBUF - 256)
+      { fwrite(buf, 1, used, out);
+        used = 0;
+      }
+      used += snprintf(buf + used, OUTBUF - used, "* %.200s%.40s\n", comments[k].text,
+                       comments[k].name != NULL ? comments[k].name : "");
+    }
+    if (loc == emitLoc)
+      break;
+    if (used > OUTBUF - 256)
+    { fwrite(buf, 1, used, out);
+      used = 0;
+    }
+    if (instr[loc].op <= opDIV)
+      used += snprintf(buf + used, OUTBUF - used, "%3d:  %5s  %d,%d,%d ",
+                       loc, opName[instr[loc].op], instr[loc].r, instr[loc].s, instr[loc].d);
+    else
+      used += snprintf(buf + used, OUTBUF - used, "%3d:  %5s  %d,%d(%d) ",
+                       loc, opName[instr[loc].op], instr[loc].r, instr[loc].d, instr[loc].s);
+    if (k < commentCount && comments[k].loc == loc && comments[k].trailing)
+      used += snprintf(buf + used, OUTBUF - used, "\t%.200s", comments[k++].text);
+    buf[used++] = '\n';
+  }
+  fwrite(buf, 1, used, out);
+  free(buf);
+  emitLoc = commentCount = labelCount = 0;
+}
@@ -0,0 +1,122 @@
+/****************************************************/
+/* File: code.h                                     */
+/* Code emitting utilities for the C-MINUS compiler */
+/* and interface to the TM machine                  */
+/* Compiler Construction: Principles and Practice   */
+/* Kenneth C. Louden                                */
+/****************************************************/
+
+#ifndef _CODE_H_
+#define _CODE_H_
+
+/* pc = program counter  */
+#define  pc 7
+
+/* mp = "memory pointer" points
+ * to the first free word of the
+ * stack, which grows downwards
+ */
+#define  mp 6
+
+/* gp = "global pointer" points
+ * to bottom of memory for (global)
+ * variable storage
+ */
+#define gp 5
+
+/* fp = "frame pointer" points to the
+ * activation record of the current
+ * function
+ */
+#define fp 4
+
+/* accumulator */
+#define  ac 0
+
+/* 2nd accumulator */
+#define  ac1 1
+
+/* TmOpcode is a TM instruction, numbered as
+ * in tm.c
+ */
+typedef enum
+{ opHALT, opIN, opOUT, opADD, opSUB, opMUL, opDIV,
+  opLD, opST,
+  opLDA, opLDC, opJLT, opJLE, opJGT, opJGE, opJEQ, opJNE
+} TmOpcode;
+
+/* code emitting utilities: instructions are kept
+ * in memory until writeCode, so jumps to code not
+ * emitted yet go to a label that is backpatched
+ * when placeLabel gives it a location
+ */
+
+/* Procedure emitComment records a comment line
+ * with comment c, if TraceCode is TRUE
+ */
+void emitComment( const char * c );
+
+/* Procedure emitNameComment records a comment
+ * line with comment c followed by name, if
+ * TraceCode is TRUE
+ */
+void emitNameComment( const char * c, const char * name );
+
+/* Procedure emitRO emits a register-only
+ * TM instruction
+ * op = the opcode
+ * r = target register
+ * s = 1st source register
+ * t = 2nd source register
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+void emitRO( TmOpcode op, int r, int s, int t, const char *c);
+
+/* Function emitRM emits a register-to-memory
+ * TM instruction and returns its location
+ * op = the opcode
+ * r = target register
+ * d = the offset
+ * s = the base register
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+int emitRM( TmOpcode op, int r, int d, int s, const char *c);
+
+/* Procedure patchRM sets the offset of the
+ * register-to-memory instruction at loc to d
+ */
+void patchRM( int loc, int d);
+
+/* Function newLabel returns a label for a code
+ * location that is placed later
+ */
+int newLabel(void);
+
+/* Procedure placeLabel makes the next emitted
+ * instruction the location of label, and
+ * backpatches the jumps already emitted to it
+ */
+void placeLabel( int label);
+
+/* Function labelPlaced is TRUE once placeLabel
+ * has been called on label
+ */
+int labelPlaced( int label);
+
+/* Procedure emitRM_Label emits a pc-relative
+ * register-to-memory TM instruction whose target
+ * is label, typically a jump
+ * op = the opcode
+ * r = target register
+ * label = a label from newLabel
+ * c = a comment to be printed if TraceCode is TRUE
+ */
+void emitRM_Label( TmOpcode op, int r, int label, const char *c);
+
+/* Procedure writeCode prints every instruction
+ * emitted so far to out in TM format, in one pass,
+ * and empties the code buffer
+ */
+void writeCode( FILE * out);
+
+#endif
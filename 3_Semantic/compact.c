@@ -0,0 +1,400 @@
+/****************************************************/
+/* File: compact.c                                  */
+/* Index-based compact syntax tree for C-Minus:     */
+/* conversion from the parser's pointer tree,       */
+/* listing and footprint statistics                 */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "compact.h"
+
+/* INITNODES = initial capacity of the node arrays */
+#define INITNODES 1024
+
+/* Pending is an entry of the work stack of compactTree:
+   a sibling list still to be laid out and
+   the child slot (-1 for the root) that receives it */
+typedef struct
+{ TreeNode * head;
+  int slot;
+} Pending;
+
+/* growArray reallocates one of the tree arrays */
+static void * growArray(void * array, int capacity, size_t elemSize)
+{
+  void * grown = realloc(array, capacity * elemSize);
+  if (grown == NULL)
+  {
+    fprintf(listing, "Out of memory error while compacting the syntax tree\n");
+    exit(1);
+  }
+  return grown;
+}
+
+/* reserveNodes appends n nodes to ct and returns
+   the index of the first one */
+static NodeIndex reserveNodes(CompactTree * ct, int n)
+{
+  NodeIndex first = ct->count;
+  if (ct->count + n > ct->capacity)
+  {
+    while (ct->count + n > ct->capacity)
+      ct->capacity *= 2;
+    ct->nodekind = growArray(ct->nodekind, ct->capacity, sizeof(unsigned char));
+    ct->kind = growArray(ct->kind, ct->capacity, sizeof(unsigned char));
+    ct->type = growArray(ct->type, ct->capacity, sizeof(unsigned char));
+    ct->childCount = growArray(ct->childCount, ct->capacity, sizeof(unsigned char));
+    ct->lineno = growArray(ct->lineno, ct->capacity, sizeof(int));
+    ct->payload = growArray(ct->payload, ct->capacity, sizeof(int));
+    ct->childBase = growArray(ct->childBase, ct->capacity, sizeof(unsigned int));
+  }
+  ct->count += n;
+  return first;
+}
+
+/* reserveSlots appends n empty child slots to ct
+   and returns the index of the first one */
+static int reserveSlots(CompactTree * ct, int n)
+{
+  int first = ct->slotCount;
+  int i;
+  if (ct->slotCount + n > ct->slotCapacity)
+  {
+    while (ct->slotCount + n > ct->slotCapacity)
+      ct->slotCapacity *= 2;
+    ct->children = growArray(ct->children, ct->slotCapacity, sizeof(NodeRange));
+  }
+  for (i = 0; i < n; i++)
+  {
+    ct->children[first + i].first = NULL_NODE;
+    ct->children[first + i].count = 0;
+  }
+  ct->slotCount += n;
+  return first;
+}
+
+/* addAttr appends a side table entry to ct
+   and returns its index */
+static int addAttr(CompactTree * ct, char * name, ScopeList scope,
+                   BucketList symbol)
+{
+  if (ct->attrCount == ct->attrCapacity)
+  {
+    ct->attrCapacity *= 2;
+    ct->name = growArray(ct->name, ct->attrCapacity, sizeof(char *));
+    ct->scope = growArray(ct->scope, ct->attrCapacity, sizeof(ScopeList));
+    ct->symbol = growArray(ct->symbol, ct->attrCapacity, sizeof(BucketList));
+  }
+  ct->name[ct->attrCount] = name;
+  ct->scope[ct->attrCount] = scope;
+  ct->symbol[ct->attrCount] = symbol;
+  return ct->attrCount++;
+}
+
+/* copyNode fills node n of ct from t, except for
+   its child slots */
+static void copyNode(CompactTree * ct, NodeIndex n, TreeNode * t)
+{
+  int kind = t->kind.stmt;
+  ct->nodekind[n] = t->nodekind;
+  ct->kind[n] = kind;
+  ct->type[n] = t->type;
+  ct->lineno[n] = t->lineno;
+  if (hasAttr(t->nodekind, kind))
+    ct->payload[n] = addAttr(ct,
+      (t->nodekind == StmtK) ? NULL : t->attr.name, t->scope, t->symbol);
+  else if (t->nodekind == ListK)
+    ct->payload[n] = (kind == ArgListK) ? t->signature : 0;
+  else
+    ct->payload[n] = t->attr.val;
+}
+
+/* Function compactTree converts the pointer-based
+ * syntax tree built by the parser into a CompactTree
+ */
+CompactTree * compactTree(TreeNode * tree)
+{
+  CompactTree * ct = calloc(1, sizeof(CompactTree));
+  Pending * stack;
+  int top = 0, stackCapacity = 64;
+
+  if (ct == NULL)
+  {
+    fprintf(listing, "Out of memory error while compacting the syntax tree\n");
+    exit(1);
+  }
+  ct->capacity = ct->slotCapacity = ct->attrCapacity = INITNODES;
+  ct->nodekind = growArray(NULL, INITNODES, sizeof(unsigned char));
+  ct->kind = growArray(NULL, INITNODES, sizeof(unsigned char));
+  ct->type = growArray(NULL, INITNODES, sizeof(unsigned char));
+  ct->childCount = growArray(NULL, INITNODES, sizeof(unsigned char));
+  ct->lineno = growArray(NULL, INITNODES, sizeof(int));
+  ct->payload = growArray(NULL, INITNODES, sizeof(int));
+  ct->childBase = growArray(NULL, INITNODES, sizeof(unsigned int));
+  ct->children = growArray(NULL, INITNODES, sizeof(NodeRange));
+  ct->name = growArray(NULL, INITNODES, sizeof(char *));
+  ct->scope = growArray(NULL, INITNODES, sizeof(ScopeList));
+  ct->symbol = growArray(NULL, INITNODES, sizeof(BucketList));
+
+  /* the null node: no children, unknown type */
+  reserveNodes(ct, 1);
+  ct->nodekind[NULL_NODE] = ListK;
+  ct->kind[NULL_NODE] = 0;
+  ct->type[NULL_NODE] = Unknown;
+  ct->childCount[NULL_NODE] = 0;
+  ct->lineno[NULL_NODE] = 0;
+  ct->payload[NULL_NODE] = 0;
+  ct->childBase[NULL_NODE] = 0;
+  ct->root.first = NULL_NODE;
+  ct->root.count = 0;
+
+  stack = growArray(NULL, stackCapacity, sizeof(Pending));
+  if (tree != NULL)
+  {
+    stack[top].head = tree;
+    stack[top].slot = -1;
+    top++;
+  }
+
+  /* lay out one whole sibling list at a time so that
+     its members get consecutive indices */
+  while (top > 0)
+  {
+    Pending p = stack[--top];
+    NodeRange list;
+    TreeNode * t;
+    NodeIndex n;
+
+    list.count = 0;
+    for (t = p.head; t != NULL; t = t->sibling)
+      list.count++;
+    list.first = reserveNodes(ct, list.count);
+    if (p.slot < 0)
+      ct->root = list;
+    else
+      ct->children[p.slot] = list;
+
+    for (t = p.head, n = list.first; t != NULL; t = t->sibling, n++)
+    {
+      int slots = MAXCHILDREN;
+      int base, i;
+      copyNode(ct, n, t);
+      while (slots > 0 && t->child[slots - 1] == NULL)
+        slots--;
+      base = (slots > 0) ? reserveSlots(ct, slots) : 0;
+      ct->childBase[n] = base;
+      ct->childCount[n] = slots;
+      for (i = 0; i < slots; i++)
+      {
+        if (t->child[i] == NULL)
+          continue;
+        if (top == stackCapacity)
+        {
+          stackCapacity *= 2;
+          stack = growArray(stack, stackCapacity, sizeof(Pending));
+        }
+        stack[top].head = t->child[i];
+        stack[top].slot = base + i;
+        top++;
+      }
+    }
+  }
+  free(stack);
+  return ct;
+}
+
+/* Procedure freeCompactTree releases ct and its arrays */
+void freeCompactTree(CompactTree * ct)
+{
+  if (ct == NULL)
+    return;
+  free(ct->nodekind);
+  free(ct->kind);
+  free(ct->type);
+  free(ct->childCount);
+  free(ct->lineno);
+  free(ct->payload);
+  free(ct->childBase);
+  free(ct->children);
+  free(ct->name);
+  free(ct->scope);
+  free(ct->symbol);
+  free(ct);
+}
+
+/* INITFRAMES = initial depth of the visitCompact stack */
+#define INITFRAMES 256
+
+/* Frame is one level of the visitCompact stack: the
+   sibling list being walked, the node reached in it,
+   the scope the list appears in, the scope the
+   node's children see and the next child slot to
+   descend into (-1 before preProc has run) */
+typedef struct
+{ NodeRange list;
+  NodeIndex n;
+  ScopeList scope;
+  ScopeList inner;
+  int next;
+} Frame;
+
+/* nodeOpensScope returns the scope opened by node n, or NULL */
+static ScopeList nodeOpensScope(CompactTree * ct, NodeIndex n)
+{
+  return hasAttr(ct->nodekind[n], ct->kind[n]) ? nodeScope(ct, n) : NULL;
+}
+
+/* Procedure visitCompact walks the sibling list
+ * nodes of ct and everything below it like visitTree
+ * (visit.h), using its own stack instead of recursion
+ */
+void visitCompact(CompactTree * ct, NodeRange nodes, ScopeList scope,
+                  const CompactVisitor * v, void * context)
+{
+  int capacity = INITFRAMES, top = 0;
+  Frame * stack;
+
+  if (nodes.count == 0)
+    return;
+  stack = growArray(NULL, capacity, sizeof(Frame));
+  if (v->enterList != NULL)
+    v->enterList(ct, nodes, context);
+  stack[0].list = nodes;
+  stack[0].n = nodes.first;
+  stack[0].scope = stack[0].inner = scope;
+  stack[0].next = -1;
+  top = 1;
+
+  while (top > 0)
+  {
+    Frame * f = &stack[top - 1];
+    NodeIndex n = f->n;
+
+    if (f->next < 0)
+    { /* first time on this node */
+      if (v->preProc != NULL)
+        v->preProc(ct, n, f->scope, context);
+      if (nodeOpensScope(ct, n) != NULL)
+      {
+        f->inner = nodeOpensScope(ct, n);
+        if (v->pushScope != NULL)
+          v->pushScope(f->inner);
+      }
+      f->next = 0;
+    }
+
+    if (f->next < ct->childCount[n])
+    { /* descend into the next non-empty child slot */
+      NodeRange list = ct->children[ct->childBase[n] + f->next++];
+      ScopeList inner = f->inner;
+      if (list.count > 0)
+      {
+        if (top == capacity)
+        {
+          capacity *= 2;
+          stack = growArray(stack, capacity, sizeof(Frame));
+        }
+        if (v->enterList != NULL)
+          v->enterList(ct, list, context);
+        stack[top].list = list;
+        stack[top].n = list.first;
+        stack[top].scope = stack[top].inner = inner;
+        stack[top].next = -1;
+        top++;
+      }
+      continue;
+    }
+
+    /* all children done: finish the node and
+       move on to the next one of the list */
+    if (nodeOpensScope(ct, n) != NULL && v->popScope != NULL)
+      v->popScope(f->inner);
+    if (v->postProc != NULL)
+      v->postProc(ct, n, f->scope, context);
+    if (n + 1 < f->list.first + f->list.count)
+    {
+      f->n = n + 1;
+      f->inner = f->scope;
+      f->next = -1;
+    }
+    else
+    {
+      if (v->leaveList != NULL)
+        v->leaveList(ct, f->list, context);
+      top--;
+    }
+  }
+  free(stack);
+}
+
+/* Variable indentno is used by the printing hooks
+ * to store current number of spaces to indent
+ */
+static int indentno = 0;
+
+/* lists headed by a ListK node are not indented */
+static void indentList(CompactTree * ct, NodeRange list, void * context)
+{
+  (void) context;
+  if (ct->nodekind[list.first] != ListK)
+    indentno += 2;
+}
+
+static void unindentList(CompactTree * ct, NodeRange list, void * context)
+{
+  (void) context;
+  if (ct->nodekind[list.first] != ListK)
+    indentno -= 2;
+}
+
+/* printNode prints one node of ct, like printTree */
+static void printNode(CompactTree * ct, NodeIndex n, ScopeList scope,
+                      void * context)
+{
+  NodeKind nodekind = ct->nodekind[n];
+  int kind = ct->kind[n];
+  int attr = hasAttr(nodekind, kind);
+  int i;
+
+  (void) scope;
+  (void) context;
+  if (nodekind != ListK && !(nodekind == StmtK && kind == NopK))
+    for (i = 0; i < indentno; i++)
+      fprintf(listing, " ");
+
+  printNodeLabel(nodekind, kind, attr ? 0 : ct->payload[n],
+                 attr ? nodeName(ct, n) : NULL, ct->type[n],
+                 firstChild(ct, n, 0) != NULL_NODE);
+}
+
+/* Procedure printCompactTree prints ct to the listing
+ * file in the same format as printTree
+ */
+void printCompactTree(CompactTree * ct)
+{
+  CompactVisitor printer = { printNode, NULL, NULL, NULL,
+                             indentList, unindentList };
+  visitCompact(ct, ct->root, NULL, &printer, NULL);
+}
+
+/* Procedure printCompactTreeStats prints the node
+ * count and memory footprint of ct to the listing file
+ */
+void printCompactTreeStats(CompactTree * ct)
+{
+  size_t perNode = 4 * sizeof(unsigned char) + 2 * sizeof(int)
+                 + sizeof(unsigned int);
+  size_t perAttr = sizeof(char *) + sizeof(ScopeList) + sizeof(BucketList);
+  size_t used = ct->count * perNode + ct->slotCount * sizeof(NodeRange)
+              + ct->attrCount * perAttr;
+  size_t reserved = ct->capacity * perNode
+                  + ct->slotCapacity * sizeof(NodeRange)
+                  + ct->attrCapacity * perAttr;
+
+  fprintf(listing, "\nCompact syntax tree:\n");
+  fprintf(listing, "  %d nodes, %d child slots, %d side table entries\n",
+          ct->count - 1, ct->slotCount, ct->attrCount);
+  fprintf(listing, "  %lu bytes used, %lu bytes reserved\n",
+          (unsigned long)used, (unsigned long)reserved);
+}
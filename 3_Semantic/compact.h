@@ -0,0 +1,124 @@
+/****************************************************/
+/* File: compact.h                                  */
+/* Index-based compact syntax tree for C-Minus:     */
+/* nodes are 32-bit indices into per-field arrays   */
+/****************************************************/
+
+#ifndef _COMPACT_H_
+#define _COMPACT_H_
+
+/* NodeIndex names a node of a CompactTree;
+ * index 0 is reserved for the null node
+ */
+typedef unsigned int NodeIndex;
+
+#define NULL_NODE 0
+
+/* NodeRange is a sibling list: the count
+ * consecutive nodes starting at first
+ */
+typedef struct
+{ NodeIndex first;
+  unsigned int count;
+} NodeRange;
+
+/* CompactTree stores one field of every node per
+ * array. The members of a sibling list get
+ * consecutive indices, so each child slot of a node
+ * is a single NodeRange. Names and scopes live in a
+ * side table indexed by the payload of the nodes
+ * that have them (declarations, IdK, CallK and
+ * CompoundK)
+ */
+typedef struct
+{ int count;                  /* nodes, the null node included */
+  int capacity;               /* allocated length of the node arrays */
+  unsigned char * nodekind;   /* NodeKind */
+  unsigned char * kind;       /* StmtKind, ExpKind, DeclKind or ListKind */
+  unsigned char * type;       /* ExpType */
+  unsigned char * childCount; /* number of child slots in use */
+  int * lineno;
+  int * payload;              /* op, val, has_else, side table index,
+                                 or the signature of an ArgListK */
+  unsigned int * childBase;   /* first child slot in children */
+  int slotCount;              /* child slots in use */
+  int slotCapacity;
+  NodeRange * children;       /* child slots of all nodes */
+  int attrCount;              /* side table entries in use */
+  int attrCapacity;
+  char ** name;               /* interned name, NULL for CompoundK */
+  ScopeList * scope;          /* scope opened by the node, or NULL */
+  BucketList * symbol;        /* IdK, CallK: resolved declaration; DeclK: symbol declared */
+  NodeRange root;             /* top-level sibling list */
+} CompactTree;
+
+/* childList returns the sibling list held in
+ * child slot i of node n (empty if there is none)
+ */
+static inline NodeRange childList(const CompactTree * ct, NodeIndex n, int i)
+{ NodeRange none = { NULL_NODE, 0 };
+  return i < ct->childCount[n] ? ct->children[ct->childBase[n] + i] : none;
+}
+
+/* firstChild returns the first node in child
+ * slot i of node n, or NULL_NODE
+ */
+static inline NodeIndex firstChild(const CompactTree * ct, NodeIndex n, int i)
+{ NodeRange list = childList(ct, n, i);
+  return list.count > 0 ? list.first : NULL_NODE;
+}
+
+/* hasAttr is TRUE for the nodes whose payload
+ * indexes the name/scope side table
+ */
+#define hasAttr(nk, k) \
+  ((nk) == DeclK || ((nk) == ExpK && ((k) == IdK || (k) == CallK)) || \
+   ((nk) == StmtK && (k) == CompoundK))
+
+#define nodeName(ct, n) ((ct)->name[(ct)->payload[n]])
+#define nodeScope(ct, n) ((ct)->scope[(ct)->payload[n]])
+#define nodeSymbol(ct, n) ((ct)->symbol[(ct)->payload[n]])
+
+typedef void (* CompactVisitFun) (CompactTree *, NodeIndex, ScopeList, void *);
+typedef void (* CompactListFun) (CompactTree *, NodeRange, void *);
+
+/* CompactVisitor bundles the hooks called by
+ * visitCompact; any of them may be NULL. The node
+ * and list hooks also get the context passed to
+ * visitCompact
+ */
+typedef struct
+{ CompactVisitFun preProc;  /* node, before its children; may set its scope */
+  CompactVisitFun postProc; /* node, after its children */
+  void (* pushScope) (ScopeList); /* entering the scope opened by a node */
+  void (* popScope) (ScopeList);  /* leaving that scope again */
+  CompactListFun enterList; /* sibling list, before its first node */
+  CompactListFun leaveList; /* sibling list, after its last node */
+} CompactVisitor;
+
+/* Procedure visitCompact walks the sibling list
+ * nodes of ct and everything below it like visitTree
+ * (visit.h), using its own stack instead of recursion
+ */
+void visitCompact(CompactTree * ct, NodeRange nodes, ScopeList scope,
+                  const CompactVisitor * v, void * context);
+
+/* Function compactTree converts the pointer-based
+ * syntax tree built by the parser into a CompactTree
+ */
+CompactTree * compactTree(TreeNode * tree);
+
+/* Procedure freeCompactTree releases ct and its arrays */
+void freeCompactTree(CompactTree * ct);
+
+/* Procedure printCompactTree prints ct to the listing
+ * file in the same format as printTree
+ */
+void printCompactTree(CompactTree * ct);
+
+/* Procedure printCompactTreeStats prints the node
+ * count and memory footprint of ct to the listing file
+ */
+void printCompactTreeStats(CompactTree * ct);
+
+#endif
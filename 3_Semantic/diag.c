@@ -0,0 +1,260 @@
+/****************************************************/
+/* File: diag.c                                     */
+/* Diagnostics recorded as (line, kind, name)       */
+/* records: duplicates are collapsed, at most       */
+/* MaxErrors are kept, and they are printed sorted  */
+/* by line when flushed                             */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "diag.h"
+
+/* INITDIAGS = initial capacity of a DiagBuffer */
+#define INITDIAGS 16
+
+static void outOfMemory(void)
+{ fprintf(stderr, "Out of memory error while recording diagnostics\n");
+  exit(1);
+}
+
+/* sameDiagnostic is TRUE if a and b print the same;
+   names and lexemes are interned, so == compares them */
+static int sameDiagnostic(const Diagnostic * a, const Diagnostic * b)
+{ return a->lineno == b->lineno && a->kind == b->kind &&
+         a->token == b->token && a->name == b->name &&
+         a->message == b->message;
+}
+
+static unsigned int hashDiagnostic(const Diagnostic * d)
+{ unsigned long long h = (unsigned long long) d->lineno * 0x9E3779B97F4A7C15ULL;
+  h ^= ((unsigned long long) d->kind << 16 | (unsigned short) d->token) * 0xC2B2AE3D27D4EB4FULL;
+  h ^= (unsigned long long)(size_t) d->name * 0x165667B19E3779F9ULL;
+  h ^= (unsigned long long)(size_t) d->message;
+  return (unsigned int)(h ^ (h >> 32));
+}
+
+/* findSlot returns the index slot holding a record
+   equal to d, or the empty slot where d belongs */
+static int * findSlot(DiagBuffer * buf, const Diagnostic * d)
+{ unsigned int mask = buf->indexSize - 1;
+  unsigned int i = hashDiagnostic(d) & mask;
+  while (buf->index[i] != 0 &&
+         !sameDiagnostic(&buf->records[buf->index[i] - 1], d))
+    i = (i + 1) & mask;
+  return &buf->index[i];
+}
+
+/* buildIndex replaces the index of buf by one of
+   size slots holding every record of buf */
+static void buildIndex(DiagBuffer * buf, unsigned int size)
+{ int i;
+  free(buf->index);
+  buf->index = calloc(size, sizeof(int));
+  if (buf->index == NULL)
+    outOfMemory();
+  buf->indexSize = size;
+  for (i = 0; i < buf->count; i++)
+    *findSlot(buf, &buf->records[i]) = i + 1;
+}
+
+/* reserve makes room for n more records in buf */
+static void reserve(DiagBuffer * buf, int n)
+{ if (buf->count + n > buf->capacity)
+  { int capacity = buf->capacity == 0 ? INITDIAGS : buf->capacity;
+    Diagnostic * grown;
+    while (capacity < buf->count + n)
+      capacity *= 2;
+    grown = realloc(buf->records, capacity * sizeof(Diagnostic));
+    if (grown == NULL)
+      outOfMemory();
+    buf->records = grown;
+    buf->capacity = capacity;
+  }
+}
+
+/* record adds d to buf unless it is a duplicate or
+   buf already holds MaxErrors records */
+static void record(DiagBuffer * buf, const Diagnostic * d)
+{ int * slot;
+  /* keep the index at most half full */
+  if (2 * (buf->count + 1) > (int) buf->indexSize)
+    buildIndex(buf, buf->indexSize == 0 ? 2 * INITDIAGS : 2 * buf->indexSize);
+  slot = findSlot(buf, d);
+  if (*slot != 0)
+    buf->duplicates++;
+  else if (MaxErrors > 0 && buf->listed + buf->count >= MaxErrors)
+    buf->dropped++;
+  else
+  { reserve(buf, 1);
+    buf->records[buf->count++] = *d;
+    *slot = buf->count;
+  }
+}
+
+void addDiagnostic(DiagBuffer * buf, DiagKind kind, int lineno, char * name)
+{ Diagnostic d;
+  d.lineno = lineno;
+  d.kind = kind;
+  d.token = 0;
+  d.name = name;
+  d.message = NULL;
+  record(buf, &d);
+}
+
+void addSyntaxError(DiagBuffer * buf, int lineno, const char * message,
+                    int token, char * lexeme)
+{ Diagnostic d;
+  d.lineno = lineno;
+  d.kind = SyntaxErrorDiag;
+  d.token = token;
+  d.name = lexeme;
+  d.message = message;
+  record(buf, &d);
+}
+
+void moveDiagnostics(DiagBuffer * buf, DiagBuffer * from)
+{ int i;
+  for (i = 0; i < from->count; i++)
+    record(buf, &from->records[i]);
+  buf->duplicates += from->duplicates;
+  buf->dropped += from->dropped;
+  from->count = 0;
+  from->duplicates = from->dropped = 0;
+  if (from->index != NULL)
+    memset(from->index, 0, from->indexSize * sizeof(int));
+}
+
+long diagnosticCount(const DiagBuffer * buf)
+{ return buf->listed + buf->count + buf->dropped;
+}
+
+void printDiagnostic(FILE * out, const Diagnostic * d)
+{ int line = d->lineno;
+  char * name = d->name;
+  switch ((DiagKind) d->kind)
+  { case SyntaxErrorDiag:
+      fprintf(out, "Syntax error at line %d: %s\n", line, d->message);
+      fprintf(out, "Current token: ");
+      fprintToken(out, d->token, name);
+      break;
+    case UndeclaredFunctionDiag:
+      fprintf(out, "Error: Undeclared function \"%s\" is called at line %d\n", name, line);
+      break;
+    case UndeclaredVariableDiag:
+      fprintf(out, "Error: Undeclared variable \"%s\" is used at line %d\n", name, line);
+      break;
+    case RedefinedSymbolDiag:
+      fprintf(out, "Error: Symbol \"%s\" is redefined at line %d\n", name, line);
+      break;
+    case NonIntegerIndexDiag:
+      fprintf(out, "Error: Invalid array indexing at line %d (name : \"%s\"). Indicies should be integer\n", line, name);
+      break;
+    case NonArrayIndexDiag:
+      fprintf(out, "Error: Invalid array indexing at line %d (name : \"%s\"). Indexing can only be allowed for int[] variables\n", line, name);
+      break;
+    case InvalidCallDiag:
+      fprintf(out, "Error: Invalid function call at line %d (name : \"%s\")\n", line, name);
+      break;
+    case VoidVariableDiag:
+      fprintf(out, "Error: The void-type variable is declared at line %d (name : \"%s\")\n", line, name);
+      break;
+    case InvalidOperationDiag:
+      fprintf(out, "Error: Invalid operation at line %d\n", line);
+      break;
+    case InvalidAssignmentDiag:
+      fprintf(out, "Error: Invalid assignment at line %d\n", line);
+      break;
+    case InvalidConditionDiag:
+      fprintf(out, "Error: Invalid condition at line %d\n", line);
+      break;
+    case InvalidReturnDiag:
+      fprintf(out, "Error: Invalid return at line %d\n", line);
+      break;
+  }
+}
+
+/* sortByLine is a stable bottom-up merge sort of
+   the records of buf by line number; records come
+   nearly sorted, so runs already in order are
+   copied without comparing */
+static void sortByLine(DiagBuffer * buf)
+{ int n = buf->count;
+  Diagnostic * from = buf->records;
+  Diagnostic * to;
+  int width, i;
+
+  if (n < 2)
+    return;
+  to = malloc(n * sizeof(Diagnostic));
+  if (to == NULL)
+    outOfMemory();
+  for (width = 1; width < n; width *= 2)
+  { for (i = 0; i < n; i += 2 * width)
+    { int mid = i + width < n ? i + width : n;
+      int end = i + 2 * width < n ? i + 2 * width : n;
+      int a = i, b = mid, k = i;
+      if (mid == end || from[mid - 1].lineno <= from[mid].lineno)
+      { memcpy(to + i, from + i, (end - i) * sizeof(Diagnostic));
+        continue;
+      }
+      while (a < mid && b < end)
+        to[k++] = from[b].lineno < from[a].lineno ? from[b++] : from[a++];
+      while (a < mid)
+        to[k++] = from[a++];
+      while (b < end)
+        to[k++] = from[b++];
+    }
+    { Diagnostic * t = from; from = to; to = t; }
+  }
+  if (from != buf->records)
+  { memcpy(buf->records, from, n * sizeof(Diagnostic));
+    free(from);
+  }
+  else
+    free(to);
+}
+
+void flushDiagnosticsBefore(DiagBuffer * buf, FILE * out, int lineno)
+{ int i;
+  sortByLine(buf);
+  for (i = 0; i < buf->count && buf->records[i].lineno < lineno; i++)
+    printDiagnostic(out, &buf->records[i]);
+  buf->listed += i;
+  buf->count -= i;
+  memmove(buf->records, buf->records + i, buf->count * sizeof(Diagnostic));
+  /* the sort moved the records: start over with an
+     index sized for what is left */
+  free(buf->index);
+  buf->index = NULL;
+  buf->indexSize = 0;
+  if (buf->count > 0)
+  { unsigned int size = 2 * INITDIAGS;
+    while ((int) size < 2 * buf->count)
+      size *= 2;
+    buildIndex(buf, size);
+  }
+}
+
+void flushDiagnostics(DiagBuffer * buf, FILE * out)
+{ int i;
+  sortByLine(buf);
+  for (i = 0; i < buf->count; i++)
+    printDiagnostic(out, &buf->records[i]);
+  if (buf->dropped > 0)
+    fprintf(out, "Too many errors: only the first %d are listed\n", MaxErrors);
+  buf->count = buf->listed = 0;
+  buf->duplicates = buf->dropped = 0;
+  if (buf->index != NULL)
+    memset(buf->index, 0, buf->indexSize * sizeof(int));
+}
+
+void freeDiagnostics(DiagBuffer * buf)
+{ free(buf->records);
+  free(buf->index);
+  buf->records = NULL;
+  buf->index = NULL;
+  buf->count = buf->capacity = buf->listed = 0;
+  buf->indexSize = 0;
+  buf->duplicates = buf->dropped = 0;
+}
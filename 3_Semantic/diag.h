@@ -0,0 +1,101 @@
+/****************************************************/
+/* File: diag.h                                     */
+/* Diagnostics recorded as (line, kind, name)       */
+/* records: duplicates are collapsed, at most       */
+/* MaxErrors are kept, and they are printed sorted  */
+/* by line when flushed                             */
+/****************************************************/
+
+#ifndef _DIAG_H_
+#define _DIAG_H_
+
+/* DiagKind is the kind of an error; its listing
+ * text is produced by printDiagnostic
+ */
+typedef enum
+{ SyntaxErrorDiag,
+  UndeclaredFunctionDiag, UndeclaredVariableDiag, RedefinedSymbolDiag,
+  NonIntegerIndexDiag, NonArrayIndexDiag, InvalidCallDiag,
+  VoidVariableDiag, InvalidOperationDiag, InvalidAssignmentDiag,
+  InvalidConditionDiag, InvalidReturnDiag
+} DiagKind;
+
+/* Diagnostic is one error: where, what, and the
+ * interned name it is about (NULL if none). A
+ * SyntaxErrorDiag names the current token instead,
+ * and keeps the parser's message
+ */
+typedef struct
+{ int lineno;
+  short kind;  /* a DiagKind */
+  short token; /* SyntaxErrorDiag: the current token */
+  char * name;
+  const char * message; /* SyntaxErrorDiag: static text from the parser */
+} Diagnostic;
+
+/* DiagBuffer holds distinct diagnostics in the
+ * order they were found; a zeroed DiagBuffer is
+ * empty and ready for use
+ */
+typedef struct
+{ Diagnostic * records;
+  int count;
+  int capacity;
+  int listed;             /* records already printed by flushDiagnosticsBefore */
+  int * index;            /* open addressing over records: position + 1, 0 if empty */
+  unsigned int indexSize; /* a power of two, or 0 */
+  long duplicates;        /* records collapsed into an equal one */
+  long dropped;           /* records past MaxErrors */
+} DiagBuffer;
+
+/* Procedure addDiagnostic appends one record to
+ * buf, unless buf already holds an equal one or
+ * is full (MaxErrors)
+ */
+void addDiagnostic(DiagBuffer * buf, DiagKind kind, int lineno, char * name);
+
+/* Procedure addSyntaxError appends a syntax error
+ * found at token with the given lexeme
+ */
+void addSyntaxError(DiagBuffer * buf, int lineno, const char * message,
+                    int token, char * lexeme);
+
+/* Procedure moveDiagnostics appends the records of
+ * from to buf as addDiagnostic does, and leaves
+ * from empty
+ */
+void moveDiagnostics(DiagBuffer * buf, DiagBuffer * from);
+
+/* Function diagnosticCount returns the number of
+ * distinct records added to buf since it was last
+ * emptied, counting those already printed by
+ * flushDiagnosticsBefore and those cut by MaxErrors
+ */
+long diagnosticCount(const DiagBuffer * buf);
+
+/* Procedure printDiagnostic prints d to out as
+ * listing lines
+ */
+void printDiagnostic(FILE * out, const Diagnostic * d);
+
+/* Procedure flushDiagnostics prints the records of
+ * buf to out sorted by line (records of one line
+ * in the order found), notes how many were cut by
+ * MaxErrors, and leaves buf empty
+ */
+void flushDiagnostics(DiagBuffer * buf, FILE * out);
+
+/* Procedure flushDiagnosticsBefore prints, sorted,
+ * the records of buf on lines before lineno and
+ * removes them, keeping the rest; they still count
+ * towards MaxErrors. A streamed compilation calls it
+ * after each declaration
+ */
+void flushDiagnosticsBefore(DiagBuffer * buf, FILE * out, int lineno);
+
+/* Procedure freeDiagnostics releases the records
+ * of buf
+ */
+void freeDiagnostics(DiagBuffer * buf);
+
+#endif
@@ -0,0 +1,33 @@
+/****************************************************/
+/* File: evalop.c                                   */
+/* Compile-time evaluation of the binary operators  */
+/* as the TM code computes them, shared by the tree */
+/* folding (fold.c) and the SSA optimizer (opt.c)   */
+/****************************************************/
+
+#include <limits.h>
+#include "globals.h"
+#include "evalop.h"
+
+int evalOperator(TokenType op, int a, int b, int * value)
+{ unsigned int x = (unsigned int) a, y = (unsigned int) b;
+  /* the difference a comparison jumps on */
+  int d = (int) (x - y);
+  switch (op)
+  { case PLUS :  *value = (int) (x + y); break;
+    case MINUS : *value = d; break;
+    case TIMES : *value = (int) (x * y); break;
+    case OVER :
+      if (b == 0 || (a == INT_MIN && b == -1)) return FALSE;
+      *value = a / b;
+      break;
+    case LT : *value = d < 0; break;
+    case LE : *value = d <= 0; break;
+    case GT : *value = d > 0; break;
+    case GE : *value = d >= 0; break;
+    case EQ : *value = d == 0; break;
+    case NE : *value = d != 0; break;
+    default : return FALSE;
+  }
+  return TRUE;
+}
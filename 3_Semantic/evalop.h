@@ -0,0 +1,19 @@
+/****************************************************/
+/* File: evalop.h                                   */
+/* Compile-time evaluation of the binary operators  */
+/* as the TM code computes them                     */
+/****************************************************/
+
+#ifndef _EVALOP_H_
+#define _EVALOP_H_
+
+/* Function evalOperator computes a op b into *value
+ * as the generated code does: +, - and * wrap
+ * around, and a comparison tests the wrapped
+ * difference a - b against zero, like the SUB and
+ * conditional jump it becomes. It returns FALSE for
+ * the divisions that trap, which are left to run
+ */
+int evalOperator(TokenType op, int a, int b, int * value);
+
+#endif
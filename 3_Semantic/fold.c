@@ -0,0 +1,144 @@
+/****************************************************/
+/* File: fold.c                                     */
+/* Constant folding and algebraic simplification   */
+/* of the analyzed syntax tree. Nodes are rewritten */
+/* in place, after their children, so that lists   */
+/* and their lastChildOfList stay valid             */
+/****************************************************/
+
+#include "globals.h"
+#include "visit.h"
+#include "evalop.h"
+#include "fold.h"
+
+/* isConst is TRUE if t is the constant value */
+static int isConst(const TreeNode * t, int value)
+{ return t->nodekind == ExpK && t->kind.exp == ConstK && t->attr.val == value; }
+
+static int isConstant(const TreeNode * t)
+{ return t->nodekind == ExpK && t->kind.exp == ConstK; }
+
+/* isScalar is TRUE if t reads a scalar variable,
+   which cannot trap */
+static int isScalar(const TreeNode * t)
+{ return t->nodekind == ExpK && t->kind.exp == IdK &&
+         t->child[0] == NULL && t->symbol != NULL &&
+         t->type == Integer;
+}
+
+/* isSimple is TRUE if t can be dropped: it has no
+   side effect and cannot trap */
+static int isSimple(const TreeNode * t)
+{ return isConstant(t) || isScalar(t); }
+
+/* makeConstant turns t into the constant value */
+static void makeConstant(TreeNode * t, int value)
+{ t->nodekind = ExpK;
+  t->kind.exp = ConstK;
+  t->attr.val = value;
+  t->child[0] = t->child[1] = t->child[2] = NULL;
+  t->type = Integer;
+  t->symbol = NULL;
+}
+
+/* replaceBy puts node c in the place of t, which
+   keeps its siblings */
+static void replaceBy(TreeNode * t, const TreeNode * c)
+{ TreeNode * sibling = t->sibling;
+  *t = *c;
+  t->sibling = sibling;
+}
+
+/* makeNop turns statement t into an empty one */
+static void makeNop(TreeNode * t)
+{ t->nodekind = StmtK;
+  t->kind.stmt = NopK;
+  t->child[0] = t->child[1] = t->child[2] = NULL;
+  t->scope = NULL;
+  t->symbol = NULL;
+}
+
+/* foldOp simplifies the operation t and returns
+   TRUE if it did */
+static int foldOp(TreeNode * t)
+{ TreeNode * l = t->child[0], * r = t->child[1];
+  int value, same;
+  if (l == NULL || r == NULL) return FALSE;
+  if (isConstant(l) && isConstant(r))
+  { if (!evalOperator(t->attr.op, l->attr.val, r->attr.val, &value))
+      return FALSE;
+    makeConstant(t, value);
+    return TRUE;
+  }
+  same = isScalar(l) && isScalar(r) && l->symbol == r->symbol;
+  switch (t->attr.op)
+  { case PLUS :
+      if (isConst(r, 0)) { replaceBy(t, l); return TRUE; }
+      if (isConst(l, 0)) { replaceBy(t, r); return TRUE; }
+      break;
+    case MINUS :
+      if (isConst(r, 0)) { replaceBy(t, l); return TRUE; }
+      if (same) { makeConstant(t, 0); return TRUE; }
+      break;
+    case TIMES :
+      if (isConst(r, 1)) { replaceBy(t, l); return TRUE; }
+      if (isConst(l, 1)) { replaceBy(t, r); return TRUE; }
+      if ((isConst(r, 0) && isSimple(l)) || (isConst(l, 0) && isSimple(r)))
+      { makeConstant(t, 0); return TRUE; }
+      break;
+    case OVER :
+      if (isConst(r, 1)) { replaceBy(t, l); return TRUE; }
+      break;
+    case EQ : case LE : case GE :
+      if (same) { makeConstant(t, 1); return TRUE; }
+      break;
+    case NE : case LT : case GT :
+      if (same) { makeConstant(t, 0); return TRUE; }
+      break;
+    default :
+      break;
+  }
+  return FALSE;
+}
+
+/* foldStmt prunes the if or while t if its
+   condition is known, and returns TRUE if it did */
+static int foldStmt(TreeNode * t)
+{ TreeNode * cond = t->child[0];
+  if (cond == NULL || !isConstant(cond)) return FALSE;
+  if (t->kind.stmt == SelectK)
+  { TreeNode * taken = (cond->attr.val != 0) ? t->child[1] : t->child[2];
+    if (taken != NULL)
+      replaceBy(t, taken);
+    else
+      makeNop(t);
+    return TRUE;
+  }
+  if (t->kind.stmt == IterK && cond->attr.val == 0)
+  { makeNop(t);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* foldNode is the postorder hook of the walk; the
+   context counts the nodes folded */
+static void foldNode(TreeNode * t, ScopeList scope, void * context)
+{ int * folded = (int *) context;
+  (void) scope;
+  if (t->nodekind == ExpK && t->kind.exp == BinaryOpK)
+  { if (foldOp(t)) (*folded)++;
+  }
+  else if (t->nodekind == StmtK &&
+           (t->kind.stmt == SelectK || t->kind.stmt == IterK))
+  { if (foldStmt(t)) (*folded)++;
+  }
+}
+
+int foldConstants(TreeNode * decl)
+{ static const Visitor folder = { NULL, foldNode, NULL, NULL, NULL, NULL };
+  int folded = 0;
+  if (decl->child[1] != NULL)
+    visitNode(decl->child[1], decl->scope, &folder, &folded);
+  return folded;
+}
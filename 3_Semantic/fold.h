@@ -0,0 +1,24 @@
+/****************************************************/
+/* File: fold.h                                     */
+/* Constant folding and algebraic simplification   */
+/* of the analyzed syntax tree                      */
+/****************************************************/
+
+#ifndef _FOLD_H_
+#define _FOLD_H_
+
+/* Function foldConstants simplifies the body of the
+ * function declared by decl, after it has been
+ * analyzed and before its code is generated:
+ * operations on constants are computed, x+0, x-0,
+ * x*1 and x/1 become x, x*0, x-x and comparisons of
+ * a variable with itself become constants, an if
+ * whose condition is known becomes the branch
+ * taken, and a while whose condition is 0 goes
+ * away. Operations that could trap at run time
+ * (a division by zero, an element outside memory)
+ * are kept. It returns the number of nodes folded
+ */
+int foldConstants(TreeNode * decl);
+
+#endif
@@ -93,6 +93,60 @@ extern int TraceAnalyze;
  */
 extern int TraceCode;
 
+/* ListXref = TRUE (option --xref) causes a cross-
+ * reference listing of every symbol to be printed
+ * to the listing file after analysis
+ */
+extern int ListXref;
+
+/* AnalyzeJobs = number of threads that check
+ * function bodies (option --jobs=N); 0 uses one
+ * per processor, 1 analyzes serially
+ */
+extern int AnalyzeJobs;
+
+/* Streaming = TRUE (option --stream) parses and
+ * analyzes one top-level declaration at a time,
+ * releasing each before the next is parsed
+ */
+extern int Streaming;
+
+/* LazyBodies = TRUE (option --lazy) makes the
+ * parser skip function bodies by matching braces
+ * and parse each one only when a later pass asks
+ * for it (see parseBody); ignored with Streaming
+ */
+extern int LazyBodies;
+
+/* GlobalsOnly = TRUE (option --globals) builds and
+ * lists only the global scope, never parsing the
+ * function bodies (implies LazyBodies)
+ */
+extern int GlobalsOnly;
+
+/* UseIR = TRUE (option --ir) generates the code of
+ * each function from its SSA intermediate
+ * representation (ir.h) instead of the syntax tree
+ */
+extern int UseIR;
+
+/* DumpIR = TRUE (option --dump-ir) prints the IR of
+ * each function to the listing file (implies UseIR)
+ */
+extern int DumpIR;
+
+/* FoldConstants = TRUE (option --fold) simplifies
+ * constant expressions and prunes branches whose
+ * conditions are known before generating code, and
+ * lists how many nodes were folded (see fold.h)
+ */
+extern int FoldConstants;
+
+/* MaxErrors = most errors listed for one file
+ * (option --max-errors=N); 0 lists them all
+ */
+extern int MaxErrors;
+
 /* Error = TRUE prevents further passes if an error occurs */
 extern int Error; 
 #endif
@@ -0,0 +1,129 @@
+/****************************************************/
+/* File: intern.c                                   */
+/* Process-wide identifier intern table shared by   */
+/* the scanner, the parser and the symbol table     */
+/* Names live in large chunks, each one stored once */
+/* with its hash; the table is open-addressed with  */
+/* linear probing and doubles at 50% load           */
+/****************************************************/
+
+#include <stddef.h>
+#include "globals.h"
+#include "intern.h"
+
+/* initial number of slots, a power of two */
+#define INIT_SLOTS 1024
+
+/* size of one chunk of name storage */
+#define CHUNK_SIZE 65536
+
+typedef struct NameRec {
+  unsigned long long hash;
+  int len;
+  char str[]; /* NUL-terminated text */
+} NameRec;
+
+#define RECORD_OF(name) ((const NameRec *)((name) - offsetof(NameRec, str)))
+
+static NameRec **slots = NULL;
+static unsigned int slotCount = 0;
+static unsigned int nameCount = 0;
+
+static char *chunk = NULL;     /* storage for new records */
+static size_t chunkLeft = 0;   /* bytes left in chunk */
+
+/* FNV-1a, 64-bit */
+static unsigned long long hashString (const char *s, int len) {
+  unsigned long long h = 14695981039346656037ull;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+  }
+
+  return h;
+}
+
+static void *allocNameStorage (size_t size) {
+  void *p;
+
+  size = (size + sizeof(unsigned long long) - 1) & ~(sizeof(unsigned long long) - 1);
+
+  if (size > chunkLeft) {
+    size_t chunkSize = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+    chunk = malloc(chunkSize);
+
+    if (chunk == NULL) {
+      fprintf(listing, "Out of memory error at line %d\n", lineno);
+      exit(1);
+    }
+
+    chunkLeft = chunkSize;
+  }
+
+  p = chunk;
+  chunk += size;
+  chunkLeft -= size;
+
+  return p;
+}
+
+static void growTable (void) {
+  unsigned int newCount = slotCount == 0 ? INIT_SLOTS : slotCount * 2;
+  NameRec **newSlots = calloc(newCount, sizeof(NameRec *));
+  unsigned int i;
+
+  if (newSlots == NULL) {
+    fprintf(listing, "Out of memory error at line %d\n", lineno);
+    exit(1);
+  }
+
+  for (i = 0; i < slotCount; i++) {
+    if (slots[i] != NULL) {
+      unsigned int j = slots[i]->hash & (newCount - 1);
+
+      while (newSlots[j] != NULL) {
+        j = (j + 1) & (newCount - 1);
+      }
+
+      newSlots[j] = slots[i];
+    }
+  }
+
+  free(slots);
+  slots = newSlots;
+  slotCount = newCount;
+}
+
+char * internName (const char *s, int len) {
+  unsigned long long h = hashString(s, len);
+  unsigned int i;
+  NameRec *rec;
+
+  if ((nameCount + 1) * 2 > slotCount) {
+    growTable();
+  }
+
+  for (i = h & (slotCount - 1); slots[i] != NULL; i = (i + 1) & (slotCount - 1)) {
+    rec = slots[i];
+
+    if (rec->hash == h && rec->len == len && memcmp(rec->str, s, len) == 0) {
+      return rec->str;
+    }
+  }
+
+  rec = allocNameStorage(sizeof(NameRec) + len + 1);
+  rec->hash = h;
+  rec->len = len;
+  memcpy(rec->str, s, len);
+  rec->str[len] = '\0';
+
+  slots[i] = rec;
+  nameCount++;
+
+  return rec->str;
+}
+
+unsigned long long nameHash (const char *name) {
+  return RECORD_OF(name)->hash;
+}
@@ -0,0 +1,29 @@
+/****************************************************/
+/* File: intern.h                                   */
+/* Process-wide identifier intern table shared by   */
+/* the scanner, the parser and the symbol table     */
+/****************************************************/
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+/**
+ * @brief 길이 len인 문자열 s의 interned 사본을 반환합니다.
+ * 같은 문자열은 항상 같은 포인터를 반환하므로 이름 비교는 == 로 충분합니다.
+ * 반환된 문자열은 NUL로 끝나며 프로세스가 끝날 때까지 유효합니다.
+ *
+ * @param s
+ * @param len
+ * @return char*
+ */
+char * internName (const char *s, int len);
+
+/**
+ * @brief internName으로 얻은 이름의, intern 시점에 계산된 64비트 hash 값을 반환합니다.
+ *
+ * @param name interned 이름
+ * @return unsigned long long
+ */
+unsigned long long nameHash (const char *name);
+
+#endif
@@ -0,0 +1,390 @@
+/****************************************************/
+/* File: ir.c                                       */
+/* Three-address SSA intermediate representation:   */
+/* storage, textual dump and verifier               */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "cfg.h"
+
+/* INITIR = initial capacity of the arrays of a
+   function or block */
+#define INITIR 8
+
+static const char * opName[] =
+{ "const", "param", "undef", "add", "sub", "mul", "div",
+  "lt", "le", "gt", "ge", "eq", "ne",
+  "addr", "elem", "load", "store", "load", "store",
+  "input", "output", "call", "phi", "get", "set",
+  "jump", "br", "ret"
+};
+
+static const char * typeName[] = { "void", "int", "addr" };
+
+void irOutOfMemory(void)
+{ fprintf(stderr, "Out of memory error while building IR\n");
+  exit(1);
+}
+
+/* reserve makes room for one more element in an
+   array of count elements with room for *capacity */
+static void * reserve(void * array, int count, int * capacity, size_t elemSize)
+{ if (count == *capacity)
+  { *capacity = *capacity == 0 ? INITIR : *capacity * 2;
+    array = realloc(array, *capacity * elemSize);
+    if (array == NULL)
+      irOutOfMemory();
+  }
+  return array;
+}
+
+int newBlock(IrFunction * fn)
+{ IrBlock * b;
+  fn->blocks = reserve(fn->blocks, fn->nblocks, &fn->blockCapacity, sizeof(IrBlock));
+  b = &fn->blocks[fn->nblocks];
+  memset(b, 0, sizeof(IrBlock));
+  b->idom = b->domChild = b->domSibling = -1;
+  b->loopHeader = b->loopParent = -1;
+  return fn->nblocks++;
+}
+
+int appendInstr(IrFunction * fn, int b, const IrInstr * in)
+{ IrBlock * blk = &fn->blocks[b];
+  blk->code = reserve(blk->code, blk->ncode, &blk->capacity, sizeof(IrInstr));
+  blk->code[blk->ncode] = *in;
+  return blk->ncode++;
+}
+
+int newArgs(IrFunction * fn, int n)
+{ int first = fn->nargs, i;
+  for (i = 0; i < n; i++)
+  { fn->args = reserve(fn->args, fn->nargs, &fn->argCapacity, sizeof(int));
+    fn->args[fn->nargs++] = -1;
+  }
+  return first;
+}
+
+void addPred(IrFunction * fn, int b, int p)
+{ IrBlock * blk = &fn->blocks[b];
+  blk->preds = reserve(blk->preds, blk->npreds, &blk->predCapacity, sizeof(int));
+  blk->preds[blk->npreds++] = p;
+}
+
+int isTerminator(int op)
+{ return op == IrJump || op == IrBranch || op == IrReturn; }
+
+int hasSideEffect(int op)
+{ switch (op)
+  { case IrStore : case IrStoreG : case IrInput : case IrOutput :
+    case IrCall : case IrSetVar :
+    case IrJump : case IrBranch : case IrReturn :
+      return TRUE;
+    default :
+      return FALSE;
+  }
+}
+
+void freeIr(IrFunction * fn)
+{ int b;
+  for (b = 0; b < fn->nblocks; b++)
+  { free(fn->blocks[b].code);
+    free(fn->blocks[b].preds);
+    free(fn->blocks[b].df);
+  }
+  free(fn->blocks);
+  free(fn->args);
+  free(fn);
+}
+
+/* printSym prints the variable or function sym,
+   globals marked with @ and locals with % */
+static void printSym(FILE * out, BucketList sym)
+{ fprintf(out, "%c%s", sym->scope->parent == NULL ? '@' : '%', sym->name); }
+
+/* printInstr prints instruction in of block blk */
+static void printInstr(FILE * out, const IrFunction * fn, const IrBlock * blk,
+                       const IrInstr * in)
+{ int i;
+  fprintf(out, "  ");
+  if (in->dst >= 0)
+    fprintf(out, "t%d:%s = ", in->dst, typeName[in->type]);
+  fprintf(out, "%s", opName[in->op]);
+  switch (in->op)
+  { case IrConst :
+    case IrParam :
+      fprintf(out, " %d", in->imm);
+      break;
+    case IrGetVar :
+      fprintf(out, " v%d", in->imm);
+      break;
+    case IrSetVar :
+      fprintf(out, " v%d, t%d", in->imm, in->a);
+      break;
+    case IrAddr :
+    case IrLoadG :
+      fprintf(out, " ");
+      printSym(out, in->sym);
+      break;
+    case IrStoreG :
+      fprintf(out, " ");
+      printSym(out, in->sym);
+      fprintf(out, ", t%d", in->a);
+      break;
+    case IrCall :
+      fprintf(out, " ");
+      printSym(out, in->sym);
+      fprintf(out, "(");
+      for (i = 0; i < in->nargs; i++)
+        fprintf(out, "%st%d", i > 0 ? ", " : "", fn->args[in->imm + i]);
+      fprintf(out, ")");
+      break;
+    case IrPhi : /* each operand with the block it comes from */
+      for (i = 0; i < in->nargs; i++)
+        fprintf(out, "%s[t%d, B%d]", i > 0 ? ", " : " ", fn->args[in->imm + i],
+                i < blk->npreds ? blk->preds[i] : -1);
+      break;
+    case IrJump :
+      fprintf(out, " B%d", blk->succ[0]);
+      break;
+    case IrBranch :
+      fprintf(out, " t%d, B%d, B%d", in->a, blk->succ[0], blk->succ[1]);
+      break;
+    default :
+      if (in->a >= 0) fprintf(out, " t%d", in->a);
+      if (in->b >= 0) fprintf(out, ", t%d", in->b);
+      break;
+  }
+  fprintf(out, "\n");
+}
+
+void printIr(FILE * out, const IrFunction * fn)
+{ int b, i;
+  fprintf(out, "\nfunction %s\n", fn->sym->name);
+  for (b = 0; b < fn->nblocks; b++)
+  { const IrBlock * blk = &fn->blocks[b];
+    fprintf(out, "B%d:", b);
+    if (blk->npreds > 0)
+    { fprintf(out, "  preds");
+      for (i = 0; i < blk->npreds; i++)
+        fprintf(out, " B%d", blk->preds[i]);
+    }
+    if (blk->idom >= 0)
+      fprintf(out, "  idom B%d", blk->idom);
+    if (blk->ndf > 0)
+    { fprintf(out, "  df");
+      for (i = 0; i < blk->ndf; i++)
+        fprintf(out, " B%d", blk->df[i]);
+    }
+    if (blk->loopDepth > 0)
+      fprintf(out, "  depth %d", blk->loopDepth);
+    fprintf(out, "\n");
+    for (i = 0; i < blk->ncode; i++)
+      printInstr(out, fn, blk, &blk->code[i]);
+  }
+}
+
+/* Verifier holds what verifyIr knows of the values
+   of the function it checks */
+typedef struct
+{ FILE * out;
+  const IrFunction * fn;
+  int * defBlock; /* block defining each value, -1 if none */
+  int * defIndex; /* its index in the block */
+  unsigned char * type;
+  int errors;
+} Verifier;
+
+static void problem(Verifier * v, int b, const char * message, int value)
+{ fprintf(v->out, "IR error in function %s, block B%d: %s", v->fn->sym->name, b, message);
+  if (value >= 0) fprintf(v->out, " (t%d)", value);
+  fprintf(v->out, "\n");
+  v->errors++;
+}
+
+/* irType is the type of a value holding an ExpType */
+static IrType irType(ExpType t)
+{ return t == IntegerArray ? IrAddress : t == Integer ? IrInt : IrVoid; }
+
+/* checkUse checks operand value of an instruction at
+   index i of block b, which must have type t; a phi
+   operand is used at the end of its predecessor,
+   passed as b with i = -1 */
+static void checkUse(Verifier * v, int b, int i, int value, IrType t)
+{ int d;
+  if (value < 0 || value >= v->fn->nvalues || v->defBlock[value] < 0)
+  { problem(v, b, "operand is not a defined value", value);
+    return;
+  }
+  if (v->type[value] != t)
+    problem(v, b, "operand has the wrong type", value);
+  d = v->defBlock[value];
+  if (d == b ? (i >= 0 && v->defIndex[value] >= i) : !dominates(v->fn, d, b))
+    problem(v, b, "definition does not dominate use", value);
+}
+
+/* checkInstr checks instruction i of block b */
+static void checkInstr(Verifier * v, int b, int i)
+{ const IrFunction * fn = v->fn;
+  const IrBlock * blk = &fn->blocks[b];
+  const IrInstr * in = &blk->code[i];
+  int k;
+  switch (in->op)
+  { case IrConst :
+      break;
+    case IrParam :
+      if (b != 0 || in->imm < 0 || in->imm >= fn->nparams)
+        problem(v, b, "bad parameter", in->dst);
+      else if (in->type != irType(fn->sym->type.funType.params[in->imm]))
+        problem(v, b, "parameter has the wrong type", in->dst);
+      break;
+    case IrUndef :
+      if (b != 0)
+        problem(v, b, "undef outside the entry block", in->dst);
+      break;
+    case IrAdd : case IrSub : case IrMul : case IrDiv :
+    case IrLt : case IrLe : case IrGt : case IrGe : case IrEq : case IrNe :
+      checkUse(v, b, i, in->a, IrInt);
+      checkUse(v, b, i, in->b, IrInt);
+      break;
+    case IrAddr :
+      if (in->sym == NULL || in->sym->type.varType != IntegerArray)
+        problem(v, b, "address of a non-array", in->dst);
+      break;
+    case IrElem :
+      checkUse(v, b, i, in->a, IrAddress);
+      checkUse(v, b, i, in->b, IrInt);
+      break;
+    case IrLoad :
+      checkUse(v, b, i, in->a, IrAddress);
+      break;
+    case IrStore :
+      checkUse(v, b, i, in->a, IrAddress);
+      checkUse(v, b, i, in->b, IrInt);
+      break;
+    case IrLoadG :
+    case IrStoreG :
+      if (in->sym == NULL || in->sym->scope->parent != NULL ||
+          in->sym->type.varType != Integer)
+        problem(v, b, "global access to a non-global", in->dst);
+      if (in->op == IrStoreG)
+        checkUse(v, b, i, in->a, IrInt);
+      break;
+    case IrInput :
+      break;
+    case IrOutput :
+      checkUse(v, b, i, in->a, IrInt);
+      break;
+    case IrCall :
+    { const struct FunctionType * f = &in->sym->type.funType;
+      if (in->nargs != f->paramCount)
+        problem(v, b, "call with the wrong number of arguments", in->dst);
+      else
+        for (k = 0; k < in->nargs; k++)
+          checkUse(v, b, i, fn->args[in->imm + k], irType(f->params[k]));
+      if ((in->dst >= 0) != (f->returnType == Integer))
+        problem(v, b, "call result does not match the return type", in->dst);
+      break;
+    }
+    case IrPhi :
+      if (i > 0 && blk->code[i - 1].op != IrPhi)
+        problem(v, b, "phi after other instructions", in->dst);
+      if (in->nargs != blk->npreds)
+        problem(v, b, "phi operands do not match the predecessors", in->dst);
+      else
+        for (k = 0; k < in->nargs; k++)
+          checkUse(v, blk->preds[k], -1, fn->args[in->imm + k], (IrType) in->type);
+      break;
+    case IrGetVar :
+    case IrSetVar :
+      problem(v, b, "variable access left after SSA construction", in->dst);
+      break;
+    case IrJump :
+      if (blk->nsucc != 1)
+        problem(v, b, "jump without one successor", -1);
+      break;
+    case IrBranch :
+      checkUse(v, b, i, in->a, IrInt);
+      if (blk->nsucc != 2)
+        problem(v, b, "branch without two successors", -1);
+      break;
+    case IrReturn :
+      if (in->a >= 0)
+        checkUse(v, b, i, in->a, IrInt);
+      if (blk->nsucc != 0)
+        problem(v, b, "return with successors", -1);
+      break;
+    default :
+      problem(v, b, "unknown operation", in->dst);
+      break;
+  }
+  if (isTerminator(in->op) != (i == blk->ncode - 1))
+    problem(v, b, i == blk->ncode - 1 ? "block does not end in a terminator"
+                                      : "terminator inside a block", -1);
+}
+
+/* countEdges returns how often p lists s as a
+   successor, or s lists p as a predecessor */
+static int countEdges(const int * list, int n, int x)
+{ int i, count = 0;
+  for (i = 0; i < n; i++)
+    if (list[i] == x) count++;
+  return count;
+}
+
+int verifyIr(FILE * out, const IrFunction * fn)
+{ Verifier v;
+  int b, i;
+  v.out = out;
+  v.fn = fn;
+  v.errors = 0;
+  v.defBlock = malloc((fn->nvalues + 1) * sizeof(int));
+  v.defIndex = malloc((fn->nvalues + 1) * sizeof(int));
+  v.type = malloc(fn->nvalues + 1);
+  if (v.defBlock == NULL || v.defIndex == NULL || v.type == NULL)
+    irOutOfMemory();
+  for (i = 0; i < fn->nvalues; i++)
+    v.defBlock[i] = -1;
+
+  if (fn->nblocks == 0)
+    problem(&v, 0, "function without blocks", -1);
+  else if (fn->blocks[0].npreds != 0)
+    problem(&v, 0, "entry block with predecessors", -1);
+  for (b = 0; b < fn->nblocks; b++)
+  { const IrBlock * blk = &fn->blocks[b];
+    if (blk->ncode == 0)
+      problem(&v, b, "empty block", -1);
+    for (i = 0; i < blk->nsucc; i++)
+      if (blk->succ[i] < 0 || blk->succ[i] >= fn->nblocks ||
+          countEdges(blk->succ, blk->nsucc, blk->succ[i]) !=
+          countEdges(fn->blocks[blk->succ[i]].preds, fn->blocks[blk->succ[i]].npreds, b))
+        problem(&v, b, "successor does not list the block as a predecessor", -1);
+    for (i = 0; i < blk->npreds; i++)
+      if (blk->preds[i] < 0 || blk->preds[i] >= fn->nblocks ||
+          countEdges(fn->blocks[blk->preds[i]].succ, fn->blocks[blk->preds[i]].nsucc, b) == 0)
+        problem(&v, b, "predecessor does not list the block as a successor", -1);
+    if (b > 0 && (blk->idom < 0 || !dominates(fn, blk->idom, b)))
+      problem(&v, b, "bad immediate dominator", -1);
+    for (i = 0; i < blk->ncode; i++)
+    { const IrInstr * in = &blk->code[i];
+      if (in->dst < 0) continue;
+      if (in->dst >= fn->nvalues)
+        problem(&v, b, "value out of range", in->dst);
+      else if (v.defBlock[in->dst] >= 0)
+        problem(&v, b, "value defined twice", in->dst);
+      else
+      { v.defBlock[in->dst] = b;
+        v.defIndex[in->dst] = i;
+        v.type[in->dst] = in->type;
+      }
+    }
+  }
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+      checkInstr(&v, b, i);
+  free(v.defBlock);
+  free(v.defIndex);
+  free(v.type);
+  return v.errors;
+}
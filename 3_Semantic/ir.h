@@ -0,0 +1,168 @@
+/****************************************************/
+/* File: ir.h                                       */
+/* Three-address SSA intermediate representation    */
+/* of the functions of a C-Minus program, between   */
+/* the analyzed syntax tree and the TM code         */
+/****************************************************/
+
+#ifndef _IR_H_
+#define _IR_H_
+
+/* IrOp is the operation of an instruction; dst, a
+ * and b are values (see IrInstr)
+ */
+typedef enum
+{ IrConst,   /* dst = imm */
+  IrParam,   /* dst = parameter imm of the function */
+  IrUndef,   /* dst = a value never assigned */
+  IrAdd, IrSub, IrMul, IrDiv, /* dst = a op b */
+  IrLt, IrLe, IrGt, IrGe, IrEq, IrNe, /* dst = (a op b) ? 1 : 0 */
+  IrAddr,    /* dst = address of the array sym */
+  IrElem,    /* dst = address a + index b */
+  IrLoad,    /* dst = word at address a */
+  IrStore,   /* word at address a = b */
+  IrLoadG,   /* dst = global scalar sym */
+  IrStoreG,  /* global scalar sym = a */
+  IrInput,   /* dst = input() */
+  IrOutput,  /* output(a) */
+  IrCall,    /* dst = sym(args), dst is -1 for void */
+  IrPhi,     /* dst = args[j] coming from preds[j] */
+  IrGetVar,  /* dst = local variable imm (before SSA) */
+  IrSetVar,  /* local variable imm = a (before SSA) */
+  IrJump,    /* go to succ[0] */
+  IrBranch,  /* go to succ[0] if a != 0, else succ[1] */
+  IrReturn   /* return a, or nothing if a is -1 */
+} IrOp;
+
+/* IrType is the type of a value: an integer, or the
+ * address of an integer array
+ */
+typedef enum { IrVoid, IrInt, IrAddress } IrType;
+
+/* IrInstr is one instruction. Values are numbered
+ * from 0 in the function; in SSA form each one is
+ * the dst of exactly one instruction, which
+ * dominates its uses. Calls and phis keep nargs
+ * operands in the function's args array, from
+ * index imm on
+ */
+typedef struct
+{ unsigned char op;   /* IrOp */
+  unsigned char type; /* IrType of dst */
+  int dst;            /* value defined, -1 if none */
+  int a, b;           /* operands, -1 if unused */
+  int imm;
+  int nargs;
+  BucketList sym;     /* IrAddr, IrLoadG, IrStoreG: variable; IrCall: function */
+} IrInstr;
+
+/* IrBlock is a basic block: phis first, then the
+ * other instructions, ending in exactly one jump,
+ * branch or return
+ */
+typedef struct
+{ IrInstr * code;
+  int ncode, capacity;
+  int * preds;        /* predecessors, in the order of phi operands */
+  int npreds, predCapacity;
+  int succ[2];
+  int nsucc;
+  /* filled in by computeDominators (cfg.h) */
+  int idom;           /* immediate dominator, -1 for the entry */
+  int domChild, domSibling; /* dominator tree, -1 terminated */
+  int pre, post;      /* dominator tree preorder and postorder numbers */
+  int * df;           /* dominance frontier */
+  int ndf;
+  /* filled in by findLoops (cfg.h) */
+  int loopHeader;     /* header of the innermost loop holding
+                         the block, -1 if none */
+  int loopParent;     /* of a header: header of the loop
+                         around its loop, -1 if none */
+  int loopDepth;      /* loops holding the block */
+} IrBlock;
+
+/* IrFunction is the IR of one function; block 0 is
+ * the entry, and once built the blocks are in
+ * reverse postorder
+ */
+typedef struct
+{ BucketList sym;
+  int nparams;
+  IrBlock * blocks;
+  int nblocks, blockCapacity;
+  int nvalues;
+  int * args;
+  int nargs, argCapacity;
+  int frameWords; /* words of the activation record below fp for
+                     the return address, parameters and arrays */
+} IrFunction;
+
+/* Function buildIr translates the function declared
+ * by decl, after it has been analyzed, into SSA
+ * form with its control flow graph, dominator tree,
+ * dominance frontiers and loops. The local arrays get
+ * their addresses in the activation record
+ */
+IrFunction * buildIr(TreeNode * decl);
+
+/* Procedure freeIr frees fn and all of its blocks */
+void freeIr(IrFunction * fn);
+
+/* Procedure printIr prints fn to out in a textual
+ * form: one line per instruction, each block headed
+ * by its predecessors, immediate dominator,
+ * dominance frontier and loop depth
+ */
+void printIr(FILE * out, const IrFunction * fn);
+
+/* Function verifyIr checks that fn is well formed
+ * SSA: blocks end in one terminator that matches
+ * their successors, predecessor lists agree with
+ * them, every value is defined once and dominates
+ * its uses, and operands have the right types. It
+ * prints each problem to out and returns how many
+ * there were
+ */
+int verifyIr(FILE * out, const IrFunction * fn);
+
+/* the building blocks used by buildIr and by the
+ * passes over the IR
+ */
+
+/* Function newBlock appends an empty block to fn
+ * and returns its index
+ */
+int newBlock(IrFunction * fn);
+
+/* Function appendInstr appends a copy of in to
+ * block b of fn and returns its index in the block
+ */
+int appendInstr(IrFunction * fn, int b, const IrInstr * in);
+
+/* Function newArgs reserves n operand slots in the
+ * args array of fn, set to -1, and returns the
+ * index of the first
+ */
+int newArgs(IrFunction * fn, int n);
+
+/* Procedure addPred appends p to the predecessors
+ * of block b
+ */
+void addPred(IrFunction * fn, int b, int p);
+
+/* Function isTerminator is TRUE for the last
+ * instruction of a block
+ */
+int isTerminator(int op);
+
+/* Function hasSideEffect is TRUE for instructions
+ * that must run even if their value is unused
+ */
+int hasSideEffect(int op);
+
+/* Procedure irOutOfMemory reports running out of
+ * memory in an IR pass and exits
+ */
+void irOutOfMemory(void);
+
+#endif
@@ -0,0 +1,773 @@
+/****************************************************/
+/* File: irbuild.c                                  */
+/* Translation of the analyzed syntax tree of a     */
+/* function into SSA form: local scalars and        */
+/* parameters first become variables read and set   */
+/* by IrGetVar and IrSetVar, which SSA construction */
+/* replaces by values, placing phis on the iterated */
+/* dominance frontiers of their assignments         */
+/* (Cytron et al.)                                  */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "cfg.h"
+
+/* INITFRAMES = initial depth of the translation's
+   explicit stack; it doubles as needed */
+#define INITFRAMES 256
+
+/* Frame is one node being translated by translate,
+   with the state of its translation so far */
+typedef struct
+{ TreeNode * t;
+  int state;    /* resume point in translateStmt or translateExp */
+  int a, b;     /* blocks or counts, by node kind */
+  TreeNode * cursor; /* next statement or argument */
+} Frame;
+
+/* Builder is the state of the translation of one
+   function */
+typedef struct
+{ IrFunction * fn;
+  int cur;               /* block instructions are appended to */
+  int * values;          /* values of the expressions translated */
+  int nvalues, valueCapacity;
+  unsigned char * varType; /* IrType of each variable */
+  int nvars, varCapacity;
+  int frameDepth;        /* words of the activation record in use */
+} Builder;
+
+/* grow makes room for one more element in an array
+   of count elements with room for *capacity */
+static void * grow(void * array, int count, int * capacity, size_t elemSize)
+{ if (count == *capacity)
+  { *capacity = *capacity == 0 ? INITFRAMES : *capacity * 2;
+    array = realloc(array, *capacity * elemSize);
+    if (array == NULL)
+      irOutOfMemory();
+  }
+  return array;
+}
+
+static void push(Builder * bd, int value)
+{ bd->values = grow(bd->values, bd->nvalues, &bd->valueCapacity, sizeof(int));
+  bd->values[bd->nvalues++] = value;
+}
+
+static int pop(Builder * bd)
+{ return bd->values[--bd->nvalues]; }
+
+/* isVariable is TRUE if b is a local scalar or a
+   parameter, whose address field holds its variable
+   number; the other locals are arrays, whose address
+   field holds their place in the activation record */
+static int isVariable(BucketList b)
+{ return !isGlobal(b) && b->address >= 0; }
+
+/* emit appends an instruction to the current block;
+   it defines a new value unless type is IrVoid */
+static IrInstr * emit(Builder * bd, IrOp op, IrType type, int a, int b)
+{ IrInstr in;
+  int i;
+  memset(&in, 0, sizeof(in));
+  in.op = op;
+  in.type = type;
+  in.dst = (type == IrVoid) ? -1 : bd->fn->nvalues++;
+  in.a = a;
+  in.b = b;
+  i = appendInstr(bd->fn, bd->cur, &in);
+  return &bd->fn->blocks[bd->cur].code[i];
+}
+
+/* emitValue emits an instruction defining a value
+   and returns the value */
+static int emitValue(Builder * bd, IrOp op, IrType type, int a, int b)
+{ return emit(bd, op, type, a, b)->dst; }
+
+/* endBlock ends the current block with a terminator
+   going to the n successors s0 and s1 */
+static void endBlock(Builder * bd, IrOp op, int a, int n, int s0, int s1)
+{ IrBlock * blk;
+  int i;
+  emit(bd, op, IrVoid, a, -1);
+  blk = &bd->fn->blocks[bd->cur];
+  blk->nsucc = n;
+  blk->succ[0] = s0;
+  blk->succ[1] = s1;
+  for (i = 0; i < n; i++)
+    addPred(bd->fn, blk->succ[i], bd->cur);
+}
+
+static void jump(Builder * bd, int target)
+{ endBlock(bd, IrJump, -1, 1, target, -1); }
+
+/* newVariable makes b variable number nvars */
+static int newVariable(Builder * bd, BucketList b, IrType type)
+{ bd->varType = grow(bd->varType, bd->nvars, &bd->varCapacity, 1);
+  bd->varType[bd->nvars] = (unsigned char) type;
+  b->address = bd->nvars;
+  return bd->nvars++;
+}
+
+/* declareLocal makes the scalar declared by decl a
+   variable, and gives an array the next words of
+   the activation record */
+static void declareLocal(Builder * bd, TreeNode * decl)
+{ BucketList b = decl->symbol;
+  if (b == NULL) return;
+  if (decl->type == IntegerArray)
+  { /* element 0 of an array lies lowest */
+    bd->frameDepth += decl->child[0]->attr.val;
+    b->address = -(bd->frameDepth - 1);
+    if (bd->fn->frameWords < bd->frameDepth)
+      bd->fn->frameWords = bd->frameDepth;
+  }
+  else
+    newVariable(bd, b, IrInt);
+}
+
+/* loadVariable returns the value of variable b: an
+   integer, or the address of an array */
+static int loadVariable(Builder * bd, BucketList b)
+{ IrInstr * in;
+  if (isVariable(b))
+  { in = emit(bd, IrGetVar, (IrType) bd->varType[b->address], -1, -1);
+    in->imm = b->address;
+    return in->dst;
+  }
+  if (b->type.varType == IntegerArray)
+    in = emit(bd, IrAddr, IrAddress, -1, -1);
+  else
+    in = emit(bd, IrLoadG, IrInt, -1, -1);
+  in->sym = b;
+  return in->dst;
+}
+
+/* storeVariable assigns value to the scalar b */
+static void storeVariable(Builder * bd, BucketList b, int value)
+{ if (isVariable(b))
+    emit(bd, IrSetVar, IrVoid, value, -1)->imm = b->address;
+  else
+    emit(bd, IrStoreG, IrVoid, value, -1)->sym = b;
+}
+
+/* discard drops the value of statement s if it is an
+   expression */
+static void discard(Builder * bd, TreeNode * s)
+{ if (s->nodekind == ExpK) pop(bd); }
+
+/* binaryOp is the instruction of operator op */
+static IrOp binaryOp(TokenType op)
+{ switch (op)
+  { case PLUS : return IrAdd;
+    case MINUS : return IrSub;
+    case TIMES : return IrMul;
+    case OVER : return IrDiv;
+    case LT : return IrLt;
+    case LE : return IrLe;
+    case GT : return IrGt;
+    case GE : return IrGe;
+    case EQ : return IrEq;
+    default : return IrNe;
+  }
+}
+
+/* translateStmt translates statement f->t from
+ * resume point f->state on, and returns the child to
+ * translate next, or NULL once f->t is done
+ */
+static TreeNode * translateStmt(Builder * bd, Frame * f)
+{ TreeNode * t = f->t;
+  TreeNode * decl;
+  switch (t->kind.stmt) {
+
+    case CompoundK :
+      if (f->state == 0)
+      { f->a = bd->frameDepth;
+        if (t->child[0] != NULL)
+          for (decl = t->child[0]->child[0]; decl != NULL; decl = decl->sibling)
+            declareLocal(bd, decl);
+        f->cursor = (t->child[1] != NULL) ? t->child[1]->child[0] : NULL;
+        f->b = FALSE;
+        f->state = 1;
+      }
+      else if (f->b) /* the statement done was an expression */
+        pop(bd);
+      if (f->cursor != NULL)
+      { TreeNode * next = f->cursor;
+        f->cursor = next->sibling;
+        f->b = (next->nodekind == ExpK);
+        return next;
+      }
+      /* the words of the block are free again */
+      bd->frameDepth = f->a;
+      return NULL;
+
+    case SelectK :
+      switch (f->state++)
+      { case 0 :
+          return t->child[0];
+        case 1 :
+        { int cond = pop(bd);
+          f->a = newBlock(bd->fn); /* then */
+          f->b = newBlock(bd->fn); /* else, or the end */
+          endBlock(bd, IrBranch, cond, 2, f->a, f->b);
+          bd->cur = f->a;
+          return t->child[1];
+        }
+        case 2 :
+          discard(bd, t->child[1]);
+          if (t->child[2] != NULL)
+          { int end = newBlock(bd->fn);
+            jump(bd, end);
+            bd->cur = f->b;
+            f->b = end;
+            return t->child[2];
+          }
+          jump(bd, f->b);
+          bd->cur = f->b;
+          return NULL;
+        default :
+          discard(bd, t->child[2]);
+          jump(bd, f->b);
+          bd->cur = f->b;
+          return NULL;
+      }
+
+    case IterK :
+      switch (f->state++)
+      { case 0 :
+          f->a = newBlock(bd->fn); /* the test */
+          jump(bd, f->a);
+          bd->cur = f->a;
+          return t->child[0];
+        case 1 :
+        { int cond = pop(bd);
+          int body = newBlock(bd->fn);
+          f->b = newBlock(bd->fn); /* the end */
+          endBlock(bd, IrBranch, cond, 2, body, f->b);
+          bd->cur = body;
+          return t->child[1];
+        }
+        default :
+          discard(bd, t->child[1]);
+          jump(bd, f->a);
+          bd->cur = f->b;
+          return NULL;
+      }
+
+    case RetK :
+      if (f->state++ == 0 && t->child[0] != NULL)
+        return t->child[0];
+      endBlock(bd, IrReturn, (t->child[0] != NULL) ? pop(bd) : -1, 0, -1, -1);
+      /* whatever follows cannot be reached */
+      bd->cur = newBlock(bd->fn);
+      return NULL;
+
+    default :
+      return NULL;
+  }
+} /* translateStmt */
+
+/* translateExp translates expression f->t from
+ * resume point f->state on, pushing its value (-1
+ * for a void call) once done, and returns the child
+ * to translate next, or NULL once f->t is done
+ */
+static TreeNode * translateExp(Builder * bd, Frame * f)
+{ TreeNode * t = f->t;
+  BucketList b = t->symbol;
+  IrInstr * in;
+  switch (t->kind.exp) {
+
+    case ConstK :
+      in = emit(bd, IrConst, IrInt, -1, -1);
+      in->imm = t->attr.val;
+      push(bd, in->dst);
+      return NULL;
+
+    case IdK :
+      if (t->child[0] == NULL)
+      { push(bd, loadVariable(bd, b));
+        return NULL;
+      }
+      if (f->state++ == 0)
+        return t->child[0];
+      { int index = pop(bd);
+        int addr = emitValue(bd, IrElem, IrAddress, loadVariable(bd, b), index);
+        push(bd, emitValue(bd, IrLoad, IrInt, addr, -1));
+      }
+      return NULL;
+
+    case AssignK :
+    { TreeNode * var = t->child[0];
+      b = var->symbol;
+      if (var->child[0] == NULL)
+      { if (f->state++ == 0)
+          return t->child[1];
+        /* the value assigned stays as the value of t */
+        storeVariable(bd, b, bd->values[bd->nvalues - 1]);
+        return NULL;
+      }
+      switch (f->state++)
+      { case 0 :
+          return var->child[0];
+        case 1 :
+          return t->child[1];
+        default :
+        { int value = pop(bd);
+          int index = pop(bd);
+          int addr = emitValue(bd, IrElem, IrAddress, loadVariable(bd, b), index);
+          emit(bd, IrStore, IrVoid, addr, value);
+          push(bd, value);
+          return NULL;
+        }
+      }
+    }
+
+    case BinaryOpK :
+      switch (f->state++)
+      { case 0 :
+          return t->child[0];
+        case 1 :
+          return t->child[1];
+        default :
+        { int right = pop(bd);
+          int left = pop(bd);
+          push(bd, emitValue(bd, binaryOp(t->attr.op), IrInt, left, right));
+          return NULL;
+        }
+      }
+
+    case CallK :
+      if (isBuiltin(b, "input"))
+      { push(bd, emitValue(bd, IrInput, IrInt, -1, -1));
+        return NULL;
+      }
+      if (isBuiltin(b, "output"))
+      { if (f->state++ == 0)
+          return t->child[0]->child[0];
+        emit(bd, IrOutput, IrVoid, pop(bd), -1);
+        push(bd, -1);
+        return NULL;
+      }
+      if (f->state == 0)
+      { f->cursor = (t->child[0] != NULL) ? t->child[0]->child[0] : NULL;
+        f->a = 0; /* arguments on the value stack */
+        f->state = 1;
+      }
+      if (f->cursor != NULL)
+      { TreeNode * next = f->cursor;
+        f->cursor = next->sibling;
+        f->a++;
+        return next;
+      }
+      { int first = newArgs(bd->fn, f->a), i;
+        bd->nvalues -= f->a;
+        for (i = 0; i < f->a; i++)
+          bd->fn->args[first + i] = bd->values[bd->nvalues + i];
+        in = emit(bd, IrCall, (b->type.funType.returnType == Integer) ? IrInt : IrVoid, -1, -1);
+        in->imm = first;
+        in->nargs = f->a;
+        in->sym = b;
+        push(bd, in->dst);
+      }
+      return NULL;
+
+    default :
+      push(bd, -1);
+      return NULL;
+  }
+} /* translateExp */
+
+/* translate translates the statement t. Like the
+   tree walks of visit.c it keeps an explicit stack,
+   so that deeply nested code does not overflow the
+   C stack */
+static void translate(Builder * bd, TreeNode * t)
+{ int capacity = 0, top = 0;
+  Frame * stack = grow(NULL, 0, &capacity, sizeof(Frame));
+  stack[top].t = t;
+  stack[top].state = 0;
+  top++;
+  while (top > 0)
+  { Frame * f = &stack[top - 1];
+    TreeNode * next = (f->t->nodekind == StmtK) ? translateStmt(bd, f) : translateExp(bd, f);
+    if (next == NULL)
+    { top--;
+      continue;
+    }
+    stack = grow(stack, top, &capacity, sizeof(Frame));
+    stack[top].t = next;
+    stack[top].state = 0;
+    top++;
+  }
+  free(stack);
+}
+
+/* PhiSite is a phi to be placed for variable var at
+   the start of block */
+typedef struct { int block, var; } PhiSite;
+
+/* placePhis puts a phi for each variable on the
+   iterated dominance frontier of the blocks that
+   assign it; a phi holds its variable in a until
+   renameVariables */
+static void placePhis(Builder * bd)
+{ IrFunction * fn = bd->fn;
+  int n = fn->nblocks, nvars = bd->nvars;
+  int * start = calloc(nvars + 2, sizeof(int)); /* sites[start[k]..start[k+1]) assign k */
+  int * last = malloc((nvars + 1) * sizeof(int));
+  int * sites, * work, * hasPhi, * queued, * count;
+  PhiSite * phis = NULL;
+  int nphis = 0, phiCapacity = 0, b, i, k;
+  if (start == NULL || last == NULL)
+    irOutOfMemory();
+
+  /* the blocks assigning each variable, once each */
+  for (k = 0; k < nvars; k++) last[k] = -1;
+  for (b = 0; b < n; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->op == IrSetVar && last[in->imm] != b)
+      { last[in->imm] = b;
+        start[in->imm + 2]++;
+      }
+    }
+  for (k = 0; k < nvars; k++)
+  { start[k + 2] += start[k + 1];
+    last[k] = -1;
+  }
+  sites = malloc((start[nvars + 1] + 1) * sizeof(int));
+  work = malloc((n + 1) * sizeof(int));
+  hasPhi = malloc((n + 1) * sizeof(int));
+  queued = malloc((n + 1) * sizeof(int));
+  count = calloc(n + 1, sizeof(int));
+  if (sites == NULL || work == NULL || hasPhi == NULL || queued == NULL || count == NULL)
+    irOutOfMemory();
+  for (b = 0; b < n; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->op == IrSetVar && last[in->imm] != b)
+      { last[in->imm] = b;
+        sites[start[in->imm + 1]++] = b;
+      }
+    }
+
+  /* hasPhi[b] and queued[b] hold the last variable
+     + 1 that b got a phi for, or was queued for */
+  for (b = 0; b < n; b++) hasPhi[b] = queued[b] = 0;
+  for (k = 0; k < nvars; k++)
+  { int top = 0;
+    for (i = start[k]; i < start[k + 1]; i++)
+    { work[top++] = sites[i];
+      queued[sites[i]] = k + 1;
+    }
+    while (top > 0)
+    { int x = work[--top];
+      for (i = 0; i < fn->blocks[x].ndf; i++)
+      { int d = fn->blocks[x].df[i];
+        if (hasPhi[d] == k + 1) continue;
+        hasPhi[d] = k + 1;
+        phis = grow(phis, nphis, &phiCapacity, sizeof(PhiSite));
+        phis[nphis].block = d;
+        phis[nphis].var = k;
+        nphis++;
+        count[d]++;
+        if (queued[d] != k + 1)
+        { queued[d] = k + 1;
+          work[top++] = d;
+        }
+      }
+    }
+  }
+
+  /* put the phis in front of the code of each block */
+  for (b = 0; b < n; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    IrInstr * code;
+    if (count[b] == 0) continue;
+    code = malloc((blk->ncode + count[b]) * sizeof(IrInstr));
+    if (code == NULL)
+      irOutOfMemory();
+    memcpy(code + count[b], blk->code, blk->ncode * sizeof(IrInstr));
+    free(blk->code);
+    blk->code = code;
+    blk->ncode += count[b];
+    blk->capacity = blk->ncode;
+    count[b] = 0; /* phis placed so far */
+  }
+  for (i = 0; i < nphis; i++)
+  { IrBlock * blk = &fn->blocks[phis[i].block];
+    IrInstr * phi = &blk->code[count[phis[i].block]++];
+    memset(phi, 0, sizeof(IrInstr));
+    phi->op = IrPhi;
+    phi->type = bd->varType[phis[i].var];
+    phi->dst = fn->nvalues++;
+    phi->a = phis[i].var;
+    phi->b = -1;
+    phi->nargs = blk->npreds;
+    phi->imm = newArgs(fn, blk->npreds);
+  }
+  free(phis);
+  free(start);
+  free(last);
+  free(sites);
+  free(work);
+  free(hasPhi);
+  free(queued);
+  free(count);
+}
+
+/* Renamer is the state of renameVariables */
+typedef struct
+{ IrFunction * fn;
+  const unsigned char * varType;
+  int * current; /* value of each variable where the walk is */
+  int * undef;   /* the IrUndef value of each variable, -1 if none yet */
+  int * repl;    /* value each IrGetVar is replaced by, else -1 */
+  int * log;     /* (variable, old value) pairs to undo */
+  int nlog, logCapacity;
+} Renamer;
+
+/* valueOf returns the value of variable k */
+static int valueOf(Renamer * r, int k)
+{ if (r->current[k] >= 0)
+    return r->current[k];
+  if (r->undef[k] < 0)
+    r->undef[k] = r->fn->nvalues++;
+  return r->undef[k];
+}
+
+static int resolve(const Renamer * r, int v)
+{ while (v >= 0 && r->repl[v] >= 0)
+    v = r->repl[v];
+  return v;
+}
+
+/* assign makes value the value of variable k,
+   logging the old one */
+static void assign(Renamer * r, int k, int value)
+{ r->log = grow(r->log, r->nlog, &r->logCapacity, sizeof(int));
+  r->log[r->nlog++] = k;
+  r->log = grow(r->log, r->nlog, &r->logCapacity, sizeof(int));
+  r->log[r->nlog++] = r->current[k];
+  r->current[k] = value;
+}
+
+/* renameBlock renames the variables of block b and
+   fills in the operands of the phis of its
+   successors that come from b */
+static void renameBlock(Renamer * r, int b)
+{ IrFunction * fn = r->fn;
+  IrBlock * blk = &fn->blocks[b];
+  int i, s, j;
+  for (i = 0; i < blk->ncode; i++)
+  { IrInstr * in = &blk->code[i];
+    if (in->op == IrPhi)
+      assign(r, in->a, in->dst);
+    else if (in->op == IrGetVar)
+      r->repl[in->dst] = valueOf(r, in->imm);
+    else if (in->op == IrSetVar)
+      assign(r, in->imm, resolve(r, in->a));
+  }
+  for (s = 0; s < blk->nsucc; s++)
+  { IrBlock * succ = &fn->blocks[blk->succ[s]];
+    for (j = 0; j < succ->npreds && succ->preds[j] != b; j++)
+      ;
+    for (i = 0; i < succ->ncode && succ->code[i].op == IrPhi; i++)
+      fn->args[succ->code[i].imm + j] = valueOf(r, succ->code[i].a);
+  }
+}
+
+/* renameVariables walks the dominator tree, giving
+   each use of a variable the value last assigned to
+   it on the way down, then rewrites the operands and
+   removes the variable instructions */
+static void renameVariables(Builder * bd)
+{ IrFunction * fn = bd->fn;
+  int n = fn->nblocks, nvars = bd->nvars, limit, b, i, k, top = 0;
+  int * stack = malloc((n + 1) * sizeof(int));
+  int * cursor = malloc((n + 1) * sizeof(int));
+  int * mark = malloc((n + 1) * sizeof(int));
+  Renamer r;
+  r.fn = fn;
+  r.varType = bd->varType;
+  r.current = malloc((nvars + 1) * sizeof(int));
+  r.undef = malloc((nvars + 1) * sizeof(int));
+  limit = fn->nvalues + nvars; /* each variable can add one undef */
+  r.repl = malloc((limit + 1) * sizeof(int));
+  r.log = NULL;
+  r.nlog = r.logCapacity = 0;
+  if (stack == NULL || cursor == NULL || mark == NULL || r.current == NULL ||
+      r.undef == NULL || r.repl == NULL)
+    irOutOfMemory();
+  for (k = 0; k < nvars; k++)
+    r.current[k] = r.undef[k] = -1;
+  for (i = 0; i < limit; i++)
+    r.repl[i] = -1;
+
+  stack[top++] = 0;
+  mark[0] = 0;
+  renameBlock(&r, 0);
+  cursor[0] = fn->blocks[0].domChild;
+  while (top > 0)
+  { int c;
+    b = stack[top - 1];
+    c = cursor[b];
+    if (c >= 0)
+    { cursor[b] = fn->blocks[c].domSibling;
+      mark[c] = r.nlog;
+      renameBlock(&r, c);
+      cursor[c] = fn->blocks[c].domChild;
+      stack[top++] = c;
+      continue;
+    }
+    /* leaving b: undo its assignments */
+    while (r.nlog > mark[b])
+    { r.nlog -= 2;
+      r.current[r.log[r.nlog]] = r.log[r.nlog + 1];
+    }
+    top--;
+  }
+
+  for (b = 0; b < n; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    int j = 0;
+    for (i = 0; i < blk->ncode; i++)
+    { IrInstr in = blk->code[i];
+      if (in.op == IrGetVar || in.op == IrSetVar)
+        continue;
+      if (in.op == IrPhi)
+        in.a = -1;
+      else
+      { in.a = resolve(&r, in.a);
+        in.b = resolve(&r, in.b);
+      }
+      for (k = 0; k < in.nargs; k++)
+        fn->args[in.imm + k] = resolve(&r, fn->args[in.imm + k]);
+      blk->code[j++] = in;
+    }
+    blk->ncode = j;
+  }
+
+  /* the undef values go first in the entry block */
+  for (k = 0; k < nvars; k++)
+    if (r.undef[k] >= 0)
+    { IrBlock * entry = &fn->blocks[0];
+      IrInstr undef;
+      memset(&undef, 0, sizeof(undef));
+      undef.op = IrUndef;
+      undef.type = bd->varType[k];
+      undef.dst = r.undef[k];
+      undef.a = undef.b = -1;
+      appendInstr(fn, 0, &undef);
+      memmove(entry->code + 1, entry->code, (entry->ncode - 1) * sizeof(IrInstr));
+      entry->code[0] = undef;
+    }
+  free(stack);
+  free(cursor);
+  free(mark);
+  free(r.current);
+  free(r.undef);
+  free(r.repl);
+  free(r.log);
+}
+
+/* removeDeadPhis removes the phis and undefs whose
+   values no other instruction needs: a value is
+   live if an instruction other than a phi uses it,
+   or a live phi does */
+static void removeDeadPhis(IrFunction * fn)
+{ int n = fn->nblocks, b, i, k, top = 0;
+  unsigned char * live = calloc(fn->nvalues + 1, 1);
+  int * phiBlock = malloc((fn->nvalues + 1) * sizeof(int));
+  int * phiIndex = malloc((fn->nvalues + 1) * sizeof(int));
+  int * work = malloc((fn->nvalues + 1) * sizeof(int));
+  if (live == NULL || phiBlock == NULL || phiIndex == NULL || work == NULL)
+    irOutOfMemory();
+  for (i = 0; i < fn->nvalues; i++)
+    phiBlock[i] = -1;
+  for (b = 0; b < n; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->op == IrPhi)
+      { phiBlock[in->dst] = b;
+        phiIndex[in->dst] = i;
+        continue;
+      }
+      if (in->a >= 0) live[in->a] = TRUE;
+      if (in->b >= 0) live[in->b] = TRUE;
+      for (k = 0; k < in->nargs; k++)
+        live[fn->args[in->imm + k]] = TRUE;
+    }
+  for (i = 0; i < fn->nvalues; i++)
+    if (live[i] && phiBlock[i] >= 0)
+      work[top++] = i;
+  while (top > 0)
+  { int v = work[--top];
+    IrInstr * phi = &fn->blocks[phiBlock[v]].code[phiIndex[v]];
+    for (k = 0; k < phi->nargs; k++)
+    { int arg = fn->args[phi->imm + k];
+      if (live[arg]) continue;
+      live[arg] = TRUE;
+      if (phiBlock[arg] >= 0)
+        work[top++] = arg;
+    }
+  }
+  for (b = 0; b < n; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    int j = 0;
+    for (i = 0; i < blk->ncode; i++)
+      if ((blk->code[i].op != IrPhi && blk->code[i].op != IrUndef) || live[blk->code[i].dst])
+        blk->code[j++] = blk->code[i];
+    blk->ncode = j;
+  }
+  free(live);
+  free(phiBlock);
+  free(phiIndex);
+  free(work);
+}
+
+IrFunction * buildIr(TreeNode * decl)
+{ Builder bd;
+  IrFunction * fn = calloc(1, sizeof(IrFunction));
+  TreeNode * param;
+  if (fn == NULL)
+    irOutOfMemory();
+  memset(&bd, 0, sizeof(bd));
+  bd.fn = fn;
+  fn->sym = decl->symbol;
+  bd.cur = newBlock(fn);
+
+  /* the parameters come first in the entry block */
+  if (decl->child[0] != NULL)
+    for (param = decl->child[0]->child[0]; param != NULL; param = param->sibling)
+      if (param->symbol != NULL)
+      { IrType type = (param->type == IntegerArray) ? IrAddress : IrInt;
+        int k = newVariable(&bd, param->symbol, type);
+        IrInstr * in = emit(&bd, IrParam, type, -1, -1);
+        in->imm = fn->nparams++;
+        emit(&bd, IrSetVar, IrVoid, in->dst, -1)->imm = k;
+      }
+  bd.frameDepth = fn->frameWords = 2 + fn->nparams;
+
+  translate(&bd, decl->child[1]);
+  /* falling off the end returns */
+  endBlock(&bd, IrReturn, -1, 0, -1, -1);
+
+  orderBlocks(fn);
+  splitCriticalEdges(fn);
+  orderBlocks(fn);
+  computeDominators(fn);
+  findLoops(fn);
+  placePhis(&bd);
+  renameVariables(&bd);
+  removeDeadPhis(fn);
+
+  free(bd.values);
+  free(bd.varType);
+  return fn;
+}
@@ -0,0 +1,487 @@
+/****************************************************/
+/* File: irgen.c                                    */
+/* TM code generation from the IR of a function.    */
+/* Values live in the registers regalloc.c gives    */
+/* them, or in words of the activation record.      */
+/* Constants and array addresses are loaded where   */
+/* they are used, and phis become parallel copies   */
+/* at the end of their predecessors                 */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "code.h"
+#include "regalloc.h"
+#include "irgen.h"
+
+/* the registers values are allocated to: 2, 3 and
+   mp, which only the tree generator's calls use; ac
+   and ac1 stay free for operands loaded from memory */
+static const int allocatable[] = { 2, 3, mp };
+#define NALLOCATABLE ((int) (sizeof(allocatable) / sizeof(allocatable[0])))
+
+/* Lowering is the state of the code generation of
+   one function. The activation record holds, from
+   fp down: the caller's fp, the return address, the
+   parameters and the arrays (fn->frameWords), the
+   values left in memory by allocateRegisters and the
+   words where calls save registers */
+typedef struct
+{ IrFunction * fn;
+  Allocation al;
+  int * uses;      /* uses of each value */
+  unsigned char * defOp; /* IrOp defining each value */
+  int * constant;  /* IrConst values */
+  BucketList * array; /* arrays of IrAddr values */
+  int * label;     /* of each block */
+  int inAc;        /* value known to be in ac, or -1 */
+  int calls;       /* calls generated so far */
+} Lowering;
+
+static void * alloc(size_t size)
+{ void * p = calloc(size > 0 ? size : 1, 1);
+  if (p == NULL)
+    irOutOfMemory();
+  return p;
+}
+
+static int isComparison(int op)
+{ return op >= IrLt && op <= IrNe; }
+
+/* isFused is TRUE if instruction i of blk is a
+   comparison used only by the branch after it,
+   which then jumps on the comparison itself */
+static int isFused(const Lowering * lw, const IrBlock * blk, int i)
+{ return i + 1 < blk->ncode && isComparison(blk->code[i].op) &&
+         blk->code[i + 1].op == IrBranch &&
+         blk->code[i + 1].a == blk->code[i].dst &&
+         lw->uses[blk->code[i].dst] == 1;
+}
+
+/* isImmediate is TRUE if v is a constant small
+   enough to be the displacement of an LDA */
+static int isImmediate(const Lowering * lw, int v)
+{ return lw->defOp[v] == IrConst &&
+         lw->constant[v] > -32768 && lw->constant[v] < 32768;
+}
+
+/* placeValues counts the uses of the values of fn
+   and gives each one that needs it a register or a
+   word: constants and array addresses are loaded
+   where they are used, and fused comparisons are
+   never stored */
+static void placeValues(Lowering * lw)
+{ IrFunction * fn = lw->fn;
+  int n = fn->nvalues, b, i, k;
+  unsigned char * kept = alloc(n + 1);
+
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->a >= 0) lw->uses[in->a]++;
+      if (in->b >= 0) lw->uses[in->b]++;
+      for (k = 0; k < in->nargs; k++)
+        lw->uses[fn->args[in->imm + k]]++;
+      if (in->dst < 0) continue;
+      lw->defOp[in->dst] = in->op;
+      if (in->op == IrConst)
+        lw->constant[in->dst] = in->imm;
+      if (in->op == IrAddr)
+        lw->array[in->dst] = in->sym;
+    }
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->dst >= 0)
+        kept[in->dst] = lw->uses[in->dst] > 0 && in->op != IrConst &&
+          in->op != IrAddr && in->op != IrUndef &&
+          !isFused(lw, &fn->blocks[b], i);
+    }
+  allocateRegisters(fn, kept, allocatable, NALLOCATABLE, &lw->al);
+  free(kept);
+}
+
+/* loadValue loads value v, which is in no
+   register, into register r, unless it is already
+   in ac */
+static void loadValue(Lowering * lw, int r, int v)
+{ if (r == ac)
+  { if (lw->inAc == v) return;
+    lw->inAc = v;
+  }
+  switch (lw->defOp[v])
+  { case IrConst :
+      emitRM(opLDC,r,lw->constant[v],0,"load constant");
+      break;
+    case IrAddr :
+      if (lw->array[v]->scope->parent == NULL)
+        emitRM(opLDA,r,lw->array[v]->address,gp,"load global array address");
+      else
+        emitRM(opLDA,r,lw->array[v]->address,fp,"load local array address");
+      break;
+    case IrUndef :
+      break;
+    default :
+      emitRM(opLD,r,-lw->al.slot[v],fp,"load value");
+      break;
+  }
+}
+
+/* operand returns the register holding value v,
+   loading it into r if it has no register */
+static int operand(Lowering * lw, int v, int r)
+{ if (lw->al.reg[v] != NOREG)
+    return lw->al.reg[v];
+  loadValue(lw, r, v);
+  return r;
+}
+
+/* operands loads the operands of in: a into *ra,
+   from ac if it has no register, and b into *rb,
+   from ac1 */
+static void operands(Lowering * lw, const IrInstr * in, int * ra, int * rb)
+{ *ra = operand(lw,in->a,ac);
+  *rb = (in->b == in->a) ? *ra : operand(lw,in->b,ac1);
+}
+
+/* moveValue puts value v into register r */
+static void moveValue(Lowering * lw, int r, int v)
+{ if (lw->al.reg[v] == NOREG)
+    loadValue(lw, r, v);
+  else if (lw->al.reg[v] != r)
+  { emitRM(opLDA,r,0,lw->al.reg[v],"move value");
+    if (r == ac) lw->inAc = v;
+  }
+}
+
+/* target returns the register to compute value v
+   into: its own, or ac */
+static int target(const Lowering * lw, int v)
+{ return (v >= 0 && lw->al.reg[v] != NOREG) ? lw->al.reg[v] : ac; }
+
+/* storeValue ends the computation of value v into
+   register r, storing it if it lives in memory */
+static void storeValue(Lowering * lw, int v, int r)
+{ if (r == ac) lw->inAc = v;
+  if (v >= 0 && lw->al.reg[v] == NOREG && lw->al.slot[v] != NOSLOT)
+    emitRM(opST,r,-lw->al.slot[v],fp,"store value");
+}
+
+/* jumpOf is the jump taken if ac = a - b satisfies
+   the comparison op */
+static TmOpcode jumpOf(int op)
+{ switch (op)
+  { case IrLt : return opJLT;
+    case IrLe : return opJLE;
+    case IrGt : return opJGT;
+    case IrGe : return opJGE;
+    case IrEq : return opJEQ;
+    default : return opJNE;
+  }
+}
+
+/* inverse is the jump taken when jump is not */
+static TmOpcode inverse(TmOpcode jump)
+{ switch (jump)
+  { case opJLT : return opJGE;
+    case opJLE : return opJGT;
+    case opJGT : return opJLE;
+    case opJGE : return opJLT;
+    case opJEQ : return opJNE;
+    default : return opJEQ;
+  }
+}
+
+/* location encodes where a value is: word w of the
+   record as w, register r as -(r + 1), and nowhere
+   (constants, array addresses) as NOSLOT */
+static int location(const Lowering * lw, int v)
+{ if (lw->al.reg[v] != NOREG) return -(lw->al.reg[v] + 1);
+  return lw->al.slot[v];
+}
+
+/* copyTo copies the value v found at location src
+   to location dst, through ac1 if both are words */
+static void copyTo(Lowering * lw, int dst, int v, int src)
+{ if (dst < 0)
+  { int r = -dst - 1;
+    if (src < 0)
+      emitRM(opLDA,r,0,-src - 1,"copy register");
+    else if (src != NOSLOT)
+      emitRM(opLD,r,-src,fp,"copy from memory");
+    else
+      loadValue(lw,r,v);
+  }
+  else
+  { int r = ac1;
+    if (src < 0)
+      r = -src - 1;
+    else if (src != NOSLOT)
+      emitRM(opLD,ac1,-src,fp,"copy from memory");
+    else
+      loadValue(lw,ac1,v);
+    emitRM(opST,r,-dst,fp,"copy to memory");
+  }
+}
+
+/* copyPhis copies the operands coming from block b
+   into the phis of its successor s. The copies are
+   parallel: one is made once no other copy still
+   reads the location it writes, and when only
+   cycles are left one location of a cycle is first
+   moved to ac */
+static void copyPhis(Lowering * lw, int b, int s)
+{ IrFunction * fn = lw->fn;
+  IrBlock * succ = &fn->blocks[s];
+  int j, i, k, n = 0, nphis;
+  int * dst, * src, * value;
+  for (j = 0; j < succ->npreds && succ->preds[j] != b; j++)
+    ;
+  for (nphis = 0; nphis < succ->ncode && succ->code[nphis].op == IrPhi; nphis++)
+    ;
+  if (nphis == 0) return;
+  dst = alloc(nphis * sizeof(int));
+  src = alloc(nphis * sizeof(int));
+  value = alloc(nphis * sizeof(int));
+  for (i = 0; i < nphis; i++)
+  { int d = succ->code[i].dst, v = fn->args[succ->code[i].imm + j];
+    if (location(lw, d) == NOSLOT || lw->defOp[v] == IrUndef ||
+        location(lw, v) == location(lw, d))
+      continue;
+    dst[n] = location(lw, d);
+    src[n] = location(lw, v);
+    value[n++] = v;
+  }
+  if (n > 0)
+    emitComment("phi copies");
+  while (n > 0)
+  { for (i = 0; i < n; i++)
+    { for (k = 0; k < n && (k == i || src[k] != dst[i]); k++)
+        ;
+      if (k == n) break;
+    }
+    if (i == n)
+    { /* only cycles: free the location of the first */
+      i = 0;
+      if (dst[0] < 0)
+        emitRM(opLDA,ac,0,-dst[0] - 1,"save copy source");
+      else
+        emitRM(opLD,ac,-dst[0],fp,"save copy source");
+      for (k = 1; k < n; k++)
+        if (src[k] == dst[0]) src[k] = -(ac + 1);
+    }
+    copyTo(lw, dst[i], value[i], src[i]);
+    n--;
+    dst[i] = dst[n];
+    src[i] = src[n];
+    value[i] = value[n];
+  }
+  lw->inAc = -1;
+  free(dst);
+  free(src);
+  free(value);
+}
+
+/* genCall generates the call in: the arguments go
+   into the new activation record just below the
+   current one, which the callee pops on return,
+   and the registers live across the call are saved
+   around it */
+static void genCall(Lowering * lw, IrInstr * in)
+{ int size = lw->al.frameSize, saves = lw->al.saves[lw->calls++], k;
+  emitNameComment("-> call ",in->sym->name);
+  for (k = 0; k < in->nargs; k++)
+    emitRM(opST,operand(lw,lw->fn->args[in->imm + k],ac),-(size + 2 + k),fp,
+           "call: store argument");
+  for (k = 0; k < NALLOCATABLE; k++)
+    if (saves & (1 << allocatable[k]))
+      emitRM(opST,allocatable[k],-(lw->al.saveSlot + k),fp,"call: save register");
+  emitRM(opST,fp,-size,fp,"call: save frame pointer");
+  emitRM(opLDA,fp,-size,fp,"call: new frame");
+  emitRM(opLDA,ac,2,pc,"call: return address");
+  emitRM(opST,ac,-1,fp,"call: store return address");
+  emitRM_Label(opLDA,pc,in->sym->address,"call: jump to function");
+  for (k = 0; k < NALLOCATABLE; k++)
+    if (saves & (1 << allocatable[k]))
+      emitRM(opLD,allocatable[k],-(lw->al.saveSlot + k),fp,"call: restore register");
+  lw->inAc = -1;
+  if (in->dst >= 0 && lw->al.reg[in->dst] != NOREG)
+    emitRM(opLDA,lw->al.reg[in->dst],0,ac,"call: move result");
+  storeValue(lw,in->dst,ac);
+  emitNameComment("<- call ",in->sym->name);
+}
+
+/* difference computes a - b of the comparison cmp
+   into ac for a jump on it, and returns the
+   register holding it: a's own if b is 0 */
+static int difference(Lowering * lw, const IrInstr * cmp)
+{ int ra, rb;
+  if (isImmediate(lw, cmp->b))
+  { ra = operand(lw,cmp->a,ac);
+    if (lw->constant[cmp->b] == 0) return ra;
+    emitRM(opLDA,ac,-lw->constant[cmp->b],ra,"compare with constant");
+  }
+  else
+  { operands(lw, cmp, &ra, &rb);
+    emitRO(opSUB,ac,ra,rb,"compare");
+  }
+  lw->inAc = -1;
+  return ac;
+}
+
+/* genBranch generates the branch ending block b,
+   which jumps on the comparison before it if the
+   two are fused */
+static void genBranch(Lowering * lw, int b, int i)
+{ IrBlock * blk = &lw->fn->blocks[b];
+  int yes = blk->succ[0], no = blk->succ[1], r;
+  TmOpcode jump;
+  if (i > 0 && isFused(lw, blk, i - 1))
+  { IrInstr * cmp = &blk->code[i - 1];
+    r = difference(lw, cmp);
+    jump = jumpOf(cmp->op);
+  }
+  else
+  { r = operand(lw,blk->code[i].a,ac);
+    jump = opJNE;
+  }
+  if (yes == b + 1)
+    emitRM_Label(inverse(jump),r,lw->label[no],"branch if false");
+  else
+  { emitRM_Label(jump,r,lw->label[yes],"branch if true");
+    if (no != b + 1)
+      emitRM_Label(opLDA,pc,lw->label[no],"jump");
+  }
+}
+
+/* genArith generates dst = a op b; a constant
+   added or subtracted is the displacement of an
+   LDA */
+static void genArith(Lowering * lw, IrInstr * in)
+{ static const TmOpcode arith[] = { opADD, opSUB, opMUL, opDIV };
+  int d = target(lw, in->dst);
+  if ((in->op == IrAdd || in->op == IrSub) && isImmediate(lw, in->b))
+    emitRM(opLDA,d,in->op == IrAdd ? lw->constant[in->b] : -lw->constant[in->b],
+           operand(lw,in->a,ac),"op: constant");
+  else if (in->op == IrAdd && isImmediate(lw, in->a))
+    emitRM(opLDA,d,lw->constant[in->a],operand(lw,in->b,ac),"op: constant");
+  else
+  { int ra, rb;
+    operands(lw, in, &ra, &rb);
+    emitRO(arith[in->op - IrAdd],d,ra,rb,"op");
+  }
+  storeValue(lw,in->dst,d);
+}
+
+/* genInstr generates instruction i of block b */
+static void genInstr(Lowering * lw, int b, int i)
+{ IrBlock * blk = &lw->fn->blocks[b];
+  IrInstr * in = &blk->code[i];
+  BucketList sym = in->sym;
+  int d = target(lw, in->dst);
+  switch (in->op)
+  { case IrParam :
+      if (d != ac)
+        emitRM(opLD,d,-(2 + in->imm),fp,"load parameter");
+      break;
+    case IrAdd :
+    case IrSub :
+    case IrMul :
+    case IrDiv :
+      genArith(lw, in);
+      break;
+    case IrLt : case IrLe : case IrGt : case IrGe : case IrEq : case IrNe :
+      if (isFused(lw, blk, i)) break;
+      { int ra, rb;
+        operands(lw, in, &ra, &rb);
+        emitRO(opSUB,d,ra,rb,"op: compare");
+      }
+      emitRM(jumpOf(in->op),d,2,pc,"br if true");
+      emitRM(opLDC,d,0,0,"false case");
+      emitRM(opLDA,pc,1,pc,"unconditional jmp");
+      emitRM(opLDC,d,1,0,"true case");
+      storeValue(lw,in->dst,d);
+      break;
+    case IrElem :
+    { int ra, rb;
+      operands(lw, in, &ra, &rb);
+      emitRO(opADD,d,ra,rb,"element address");
+      storeValue(lw,in->dst,d);
+      break;
+    }
+    case IrLoad :
+      emitRM(opLD,d,0,operand(lw,in->a,ac),"load element");
+      storeValue(lw,in->dst,d);
+      break;
+    case IrStore :
+    { int ra = operand(lw,in->a,ac1);
+      emitRM(opST,operand(lw,in->b,ac),0,ra,"store element");
+      break;
+    }
+    case IrLoadG :
+      emitRM(opLD,d,sym->address,gp,"load global");
+      storeValue(lw,in->dst,d);
+      break;
+    case IrStoreG :
+      emitRM(opST,operand(lw,in->a,ac),sym->address,gp,"store global");
+      break;
+    case IrInput :
+      emitRO(opIN,d,0,0,"read integer value");
+      storeValue(lw,in->dst,d);
+      break;
+    case IrOutput :
+      emitRO(opOUT,operand(lw,in->a,ac),0,0,"write value");
+      break;
+    case IrCall :
+      genCall(lw, in);
+      break;
+    case IrJump :
+      copyPhis(lw, b, blk->succ[0]);
+      if (blk->succ[0] != b + 1)
+        emitRM_Label(opLDA,pc,lw->label[blk->succ[0]],"jump");
+      break;
+    case IrBranch :
+      genBranch(lw, b, i);
+      break;
+    case IrReturn :
+      if (in->a >= 0)
+        moveValue(lw, ac, in->a);
+      emitRM(opLD,ac1,-1,fp,"load return address");
+      emitRM(opLD,fp,0,fp,"restore frame pointer");
+      emitRM(opLDA,pc,0,ac1,"return to caller");
+      break;
+    default : /* constants, array addresses, undefs
+                 and phis take no code of their own */
+      break;
+  }
+}
+
+void genIrFunction(IrFunction * fn)
+{ Lowering lw;
+  int n = fn->nvalues, b, i;
+  lw.fn = fn;
+  lw.uses = alloc((n + 1) * sizeof(int));
+  lw.defOp = alloc(n + 1);
+  lw.constant = alloc((n + 1) * sizeof(int));
+  lw.array = alloc((n + 1) * sizeof(BucketList));
+  lw.label = alloc((fn->nblocks + 1) * sizeof(int));
+  lw.calls = 0;
+  for (i = 0; i < n; i++)
+    lw.defOp[i] = IrUndef;
+  placeValues(&lw);
+  for (b = 0; b < fn->nblocks; b++)
+    lw.label[b] = newLabel();
+  for (b = 0; b < fn->nblocks; b++)
+  { placeLabel(lw.label[b]);
+    lw.inAc = -1;
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+      genInstr(&lw, b, i);
+  }
+  freeAllocation(&lw.al);
+  free(lw.uses);
+  free(lw.defOp);
+  free(lw.constant);
+  free(lw.array);
+  free(lw.label);
+}
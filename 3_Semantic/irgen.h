@@ -0,0 +1,17 @@
+/****************************************************/
+/* File: irgen.h                                    */
+/* TM code generation from the IR of a function     */
+/****************************************************/
+
+#ifndef _IRGEN_H_
+#define _IRGEN_H_
+
+/* Procedure genIrFunction generates the TM code of
+ * the body of fn at the current code location, with
+ * the calling sequence of cgen.c: the caller has
+ * built the activation record at fp and stored the
+ * return address at -1(fp)
+ */
+void genIrFunction(IrFunction * fn);
+
+#endif
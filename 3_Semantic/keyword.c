@@ -0,0 +1,57 @@
+/****************************************************/
+/* File: keyword.c                                  */
+/* Reserved word classification shared by the       */
+/* hand-written and the flex C-Minus scanners       */
+/* Uses a perfect hash on the length and the first  */
+/* and last characters of the identifier            */
+/****************************************************/
+
+#include "globals.h"
+#include "keyword.h"
+
+/* KEYWORDSLOTS = size of the keyword hash table,
+   a power of two */
+#define KEYWORDSLOTS 8
+
+/* bounds on the length of a reserved word */
+#define MINKEYWORDLEN 2
+#define MAXKEYWORDLEN 6
+
+/* the hash function; collision-free for the reserved
+   words below (a collision would show up as an
+   overridden initializer warning in keywordTable) */
+#define KEYWORDHASH(len, first, last) \
+  (((len) + ((first) << 1) + ((last) << 3)) & (KEYWORDSLOTS - 1))
+
+#define KEYWORD(str, first, last, tok) \
+  [KEYWORDHASH(sizeof(str) - 1, first, last)] = { str, sizeof(str) - 1, tok }
+
+/* hash table of reserved words, laid out at compile time */
+static const struct
+{
+  const char *str;
+  int len;
+  TokenType tok;
+} keywordTable[KEYWORDSLOTS] = {
+  KEYWORD("if", 'i', 'f', IF),
+  KEYWORD("else", 'e', 'e', ELSE),
+  KEYWORD("while", 'w', 'e', WHILE),
+  KEYWORD("return", 'r', 'n', RETURN),
+  KEYWORD("int", 'i', 't', INT),
+  KEYWORD("void", 'v', 'd', VOID)
+};
+
+/* Function reservedLookup returns the reserved word
+ * token for the len characters at s, or ID if they
+ * do not spell a reserved word
+ */
+TokenType reservedLookup(const char *s, int len)
+{
+  int h;
+  if (len < MINKEYWORDLEN || len > MAXKEYWORDLEN)
+    return ID;
+  h = KEYWORDHASH(len, (unsigned char)s[0], (unsigned char)s[len - 1]);
+  if (keywordTable[h].len == len && memcmp(s, keywordTable[h].str, len) == 0)
+    return keywordTable[h].tok;
+  return ID;
+}
@@ -0,0 +1,16 @@
+/****************************************************/
+/* File: keyword.h                                  */
+/* Reserved word classification shared by the       */
+/* hand-written and the flex C-Minus scanners       */
+/****************************************************/
+
+#ifndef _KEYWORD_H_
+#define _KEYWORD_H_
+
+/* Function reservedLookup returns the reserved word
+ * token for the len characters at s, or ID if they
+ * do not spell a reserved word
+ */
+TokenType reservedLookup(const char *s, int len);
+
+#endif
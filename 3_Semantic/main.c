@@ -9,13 +9,24 @@
 
 /* set NO_PARSE to TRUE to get a scanner-only compiler */
 #define NO_PARSE FALSE
-/* set NO_ANALYZE to TRUE to get a parser-only compiler */
+/* set NO_ANALYZE to TRUE to get a parser-only compiler;
+ * make bench builds one, and one with NO_CODE, with -D
+ */
+#ifndef NO_ANALYZE
 #define NO_ANALYZE FALSE
+#endif
+/* set COMPACT_AST to TRUE to analyze the index-based
+ * compact tree (compact.h) instead of the pointer tree
+ */
+#define COMPACT_AST FALSE
 
 /* set NO_CODE to TRUE to get a compiler that does not
- * generate code
+ * generate code; the code generator reads the
+ * annotated pointer tree, so COMPACT_AST leaves it out
  */
-#define NO_CODE TRUE
+#ifndef NO_CODE
+#define NO_CODE COMPACT_AST
+#endif
 
 #include "util.h"
 #if NO_PARSE
@@ -23,6 +34,9 @@
 #else
 #include "parse.h"
 #if !NO_ANALYZE
+#include "compact.h"
+#include "diag.h"
+#include "symtab.h"
 #include "analyze.h"
 #if !NO_CODE
 #include "cgen.h"
@@ -42,14 +56,133 @@ int TraceScan = FALSE;
 int TraceParse = FALSE;
 int TraceAnalyze = FALSE;
 int TraceCode = FALSE;
+int ListXref = FALSE;
+int AnalyzeJobs = 0;
+int MaxErrors = 0;
+int Streaming = FALSE;
+int LazyBodies = FALSE;
+int GlobalsOnly = FALSE;
+int UseIR = FALSE;
+int DumpIR = FALSE;
+int FoldConstants = FALSE;
 
 int Error = FALSE;
 
+#if !NO_PARSE
+#if !NO_ANALYZE && !NO_CODE
+/* codeFileName returns the name of the code file
+ * of source file pgm: pgm with its extension
+ * replaced by .tm
+ */
+static char * codeFileName(char * pgm)
+{ char * codefile;
+  int fnlen = strcspn(pgm,".");
+  codefile = (char *) calloc(fnlen+4, sizeof(char));
+  strncpy(codefile,pgm,fnlen);
+  strcat(codefile,".tm");
+  return codefile;
+}
+
+/* openCode opens codefile as the code file */
+static void openCode(char * codefile)
+{ code = fopen(codefile,"w");
+  if (code == NULL)
+  { printf("Unable to open %s\n",codefile);
+    exit(1);
+  }
+}
+#endif
+
+/* checkDecl is called by parseStream on each
+ * top-level declaration, before its nodes are
+ * released
+ */
+static void checkDecl(TreeNode * decl, void * analyzer)
+{ if (TraceParse)
+  { fprintf(listing,"\nSyntax tree:\n");
+    printTree(decl);
+  }
+#if NO_ANALYZE
+  (void) analyzer;
+#else
+  streamSymtab((Analyzer) analyzer, decl);
+#if !NO_CODE
+  /* Error would stop the analysis of the rest of
+     the file, so semantic errors are counted */
+  if (diagnosticCount(analyzerDiagnostics((Analyzer) analyzer)) == 0)
+    genDecl(decl);
+#endif
+  releaseLocalScopes();
+#endif
+}
+
+/* compileStream compiles the source one top-level
+ * declaration at a time (option --stream): memory
+ * holds the global scope and one declaration
+ */
+static void compileStream(char * pgm)
+{ void * analyzer = NULL;
+#if NO_ANALYZE || NO_CODE
+  (void) pgm;
+#endif
+#if !NO_ANALYZE
+#if !NO_CODE
+  char * codefile = codeFileName(pgm);
+  int codeFailed = FALSE;
+  startCode(codefile);
+#endif
+  analyzer = createAnalyzer();
+  if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table & Checking Types...\n");
+#endif
+  parseStream(checkDecl, analyzer);
+#if !NO_ANALYZE
+#if !NO_CODE
+  if (diagnosticCount(analyzerDiagnostics((Analyzer) analyzer)) > 0)
+    codeFailed = TRUE;
+#endif
+  finishStreamSymtab((Analyzer) analyzer);
+  freeAnalyzer((Analyzer) analyzer);
+  if (TraceAnalyze && ! Error) fprintf(listing,"\nType Checking Finished\n");
+#if !NO_CODE
+  if (! Error && ! codeFailed)
+  { openCode(codefile);
+    finishCode();
+    fclose(code);
+  }
+  free(codefile);
+#endif
+#endif
+}
+#endif
+
 main( int argc, char * argv[] )
 { TreeNode * syntaxTree;
   char pgm[120]; /* source code file name */
+  while (argc > 2 && argv[1][0] == '-')
+  { if (strcmp(argv[1],"--xref") == 0)
+      ListXref = TRUE;
+    else if (strncmp(argv[1],"--jobs=",7) == 0)
+      AnalyzeJobs = atoi(argv[1] + 7);
+    else if (strncmp(argv[1],"--max-errors=",13) == 0)
+      MaxErrors = atoi(argv[1] + 13);
+    else if (strcmp(argv[1],"--stream") == 0)
+      Streaming = TRUE;
+    else if (strcmp(argv[1],"--lazy") == 0)
+      LazyBodies = TRUE;
+    else if (strcmp(argv[1],"--globals") == 0)
+      GlobalsOnly = LazyBodies = TRUE;
+    else if (strcmp(argv[1],"--ir") == 0)
+      UseIR = TRUE;
+    else if (strcmp(argv[1],"--dump-ir") == 0)
+      DumpIR = UseIR = TRUE;
+    else if (strcmp(argv[1],"--fold") == 0)
+      FoldConstants = TRUE;
+    else
+      break;
+    argv++; argc--;
+  }
   if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+    { fprintf(stderr,"usage: %s [--xref] [--jobs=N] [--max-errors=N] [--stream] [--lazy] [--globals] [--ir] [--dump-ir] [--fold] <filename>\n",argv[0]);
       exit(1);
     }
   strcpy(pgm,argv[1]) ;
@@ -65,35 +198,52 @@ main( int argc, char * argv[] )
 #if NO_PARSE
   while (getToken()!=ENDFILE);
 #else
+  if (Streaming)
+  { LazyBodies = GlobalsOnly = FALSE;
+    compileStream(pgm);
+    freeTrees();
+    fclose(source);
+    return 0;
+  }
   syntaxTree = parse();
+  if (TraceParse && !GlobalsOnly)
+    parseBodies(syntaxTree);
   if (TraceParse) {
     fprintf(listing,"\nSyntax tree:\n");
     printTree(syntaxTree);
+    printTreeStats();
   }
 #if !NO_ANALYZE
   if (! Error)
   { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table & Checking Types...\n");
+    if (GlobalsOnly)
+      buildGlobalSymtab(syntaxTree);
+    else
+#if COMPACT_AST
+    { CompactTree * ct;
+      parseBodies(syntaxTree);
+      ct = compactTree(syntaxTree);
+      if (TraceParse) printCompactTreeStats(ct);
+      buildCompactSymtab(ct);
+      freeCompactTree(ct);
+    }
+#else
     buildSymtab(syntaxTree);
+#endif
     if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
   }
 #if !NO_CODE
-  if (! Error)
-  { char * codefile;
-    int fnlen = strcspn(pgm,".");
-    codefile = (char *) calloc(fnlen+4, sizeof(char));
-    strncpy(codefile,pgm,fnlen);
-    strcat(codefile,".tm");
-    code = fopen(codefile,"w");
-    if (code == NULL)
-    { printf("Unable to open %s\n",codefile);
-      exit(1);
-    }
+  if (! Error && ! GlobalsOnly)
+  { char * codefile = codeFileName(pgm);
+    openCode(codefile);
     codeGen(syntaxTree,codefile);
     fclose(code);
+    free(codefile);
   }
 #endif
 #endif
 #endif
+  freeTrees();
   fclose(source);
   return 0;
 }
@@ -0,0 +1,611 @@
+/****************************************************/
+/* File: opt.c                                      */
+/* Optimization of the SSA form of a function:      */
+/* forwarding of global loads, sparse conditional   */
+/* constant propagation, trivial phis and dead      */
+/* code elimination                                 */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "cfg.h"
+#include "evalop.h"
+#include "opt.h"
+
+/* the lattice of a value: not known yet, one
+   constant, or not known before run time */
+#define TOP 0
+#define CONSTANT 1
+#define BOTTOM 2
+
+static void * alloc(size_t size)
+{ void * p = calloc(size > 0 ? size : 1, 1);
+  if (p == NULL)
+    irOutOfMemory();
+  return p;
+}
+
+/* operandCount and operandAt enumerate the values
+   an instruction uses: a, b, then its args */
+static int operandCount(const IrInstr * in)
+{ return 2 + ((in->op == IrCall || in->op == IrPhi) ? in->nargs : 0); }
+
+static int * operandAt(IrFunction * fn, IrInstr * in, int k)
+{ if (k == 0) return &in->a;
+  if (k == 1) return &in->b;
+  return &fn->args[in->imm + k - 2];
+}
+
+/* find follows the replacements of value v */
+static int find(const int * repl, int v)
+{ while (v >= 0 && repl[v] != v)
+    v = repl[v];
+  return v;
+}
+
+/* renameOperands replaces every operand of fn by
+   the end of its chain of replacements */
+static void renameOperands(IrFunction * fn, const int * repl)
+{ int b, i, k;
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      for (k = 0; k < operandCount(in); k++)
+      { int * v = operandAt(fn, in, k);
+        *v = find(repl, *v);
+      }
+    }
+}
+
+/* Known is the value a global scalar holds, valid
+   while epoch is the current one */
+typedef struct
+{ BucketList sym;
+  int value;
+  int epoch;
+} Known;
+
+/* slotOf returns the slot of sym in the table of
+   size entries, a power of two, or the free slot
+   where it goes */
+static int slotOf(const Known * table, int size, BucketList sym)
+{ unsigned long k = ((unsigned long) sym >> 4) & (size - 1);
+  while (table[k].sym != NULL && table[k].sym != sym)
+    k = (k + 1) & (size - 1);
+  return (int) k;
+}
+
+/* forwardGlobals makes each load of a global scalar
+   known to hold a value a replacement by it. What
+   is known at the end of a block holds in the next
+   one if that is its only predecessor; a call or an
+   array store (which could reach past its array)
+   forgets everything. It returns the loads replaced */
+static int forwardGlobals(IrFunction * fn, int * repl)
+{ int n = 0, size = 1, epoch = 0, count = 0, b, i;
+  Known * table;
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+      if (fn->blocks[b].code[i].op == IrLoadG || fn->blocks[b].code[i].op == IrStoreG)
+        n++;
+  if (n == 0) return 0;
+  while (size < 2 * n)
+    size *= 2;
+  table = alloc(size * sizeof(Known));
+  for (b = 0; b < fn->nblocks; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    if (blk->npreds != 1 || blk->preds[0] != b - 1)
+      epoch++;
+    for (i = 0; i < blk->ncode; i++)
+    { IrInstr * in = &blk->code[i];
+      int k;
+      switch (in->op)
+      { case IrStoreG :
+          k = slotOf(table, size, in->sym);
+          table[k].sym = in->sym;
+          table[k].value = in->a;
+          table[k].epoch = epoch;
+          break;
+        case IrLoadG :
+          k = slotOf(table, size, in->sym);
+          if (table[k].sym == in->sym && table[k].epoch == epoch)
+          { repl[in->dst] = table[k].value;
+            count++;
+            break;
+          }
+          table[k].sym = in->sym;
+          table[k].value = in->dst;
+          table[k].epoch = epoch;
+          break;
+        case IrCall : case IrStore :
+          epoch++;
+          break;
+        default :
+          break;
+      }
+    }
+  }
+  free(table);
+  return count;
+}
+
+/* Sccp is the state of the propagation */
+typedef struct
+{ IrFunction * fn;
+  unsigned char * state; /* lattice of each value */
+  int * value;           /* of the CONSTANT ones */
+  int * useStart;        /* users of value v: useBlock and useIndex */
+  int * useBlock;        /* from useStart[v] to useStart[v + 1] - 1 */
+  int * useIndex;
+  int * edgeStart;       /* edge from preds[j] of block b: edgeStart[b] + j */
+  int * edgeBlock;       /* block each edge goes to */
+  unsigned char * edgeLive; /* executable edges */
+  unsigned char * reached;  /* executable blocks */
+  int * flowWork;        /* edges newly executable */
+  int nflow;
+  int * ssaWork;         /* values whose lattice went down */
+  int nssa;
+} Sccp;
+
+/* findUses fills in the users of every value */
+static void findUses(Sccp * s)
+{ IrFunction * fn = s->fn;
+  int * fill = alloc((fn->nvalues + 1) * sizeof(int));
+  int b, i, k, pass, total = 0;
+  s->useStart = alloc((fn->nvalues + 1) * sizeof(int));
+  /* counted first, then filled in */
+  for (pass = 0; pass < 2; pass++)
+  { for (b = 0; b < fn->nblocks; b++)
+      for (i = 0; i < fn->blocks[b].ncode; i++)
+      { IrInstr * in = &fn->blocks[b].code[i];
+        for (k = 0; k < operandCount(in); k++)
+        { int v = *operandAt(fn, in, k);
+          if (v < 0) continue;
+          if (pass == 0)
+            s->useStart[v + 1]++;
+          else
+          { s->useBlock[fill[v]] = b;
+            s->useIndex[fill[v]++] = i;
+          }
+        }
+      }
+    if (pass == 0)
+    { for (i = 0; i < fn->nvalues; i++)
+        s->useStart[i + 1] += s->useStart[i];
+      total = s->useStart[fn->nvalues];
+      for (i = 0; i < fn->nvalues; i++)
+        fill[i] = s->useStart[i];
+      s->useBlock = alloc(total * sizeof(int));
+      s->useIndex = alloc(total * sizeof(int));
+    }
+  }
+  free(fill);
+}
+
+/* sourceOp is the operator of the binary
+   instruction op, for evalOperator */
+static TokenType sourceOp(int op)
+{ switch (op)
+  { case IrAdd : return PLUS;
+    case IrSub : return MINUS;
+    case IrMul : return TIMES;
+    case IrDiv : return OVER;
+    case IrLt : return LT;
+    case IrLe : return LE;
+    case IrGt : return GT;
+    case IrGe : return GE;
+    case IrEq : return EQ;
+    default : return NE;
+  }
+}
+
+/* lower moves value v down the lattice to state,
+   or to BOTTOM if it meets another constant */
+static void lower(Sccp * s, int v, int state, int value)
+{ if (state == TOP || s->state[v] == BOTTOM) return;
+  if (s->state[v] == CONSTANT)
+  { if (state == CONSTANT && s->value[v] == value) return;
+    state = BOTTOM;
+  }
+  s->state[v] = state;
+  s->value[v] = value;
+  s->ssaWork[s->nssa++] = v;
+}
+
+/* markEdge makes the edge from block p to block b
+   executable */
+static void markEdge(Sccp * s, int p, int b)
+{ const IrBlock * blk = &s->fn->blocks[b];
+  int j;
+  for (j = 0; j < blk->npreds; j++)
+    if (blk->preds[j] == p && !s->edgeLive[s->edgeStart[b] + j])
+    { s->edgeLive[s->edgeStart[b] + j] = TRUE;
+      s->flowWork[s->nflow++] = s->edgeStart[b] + j;
+    }
+}
+
+/* visitOp evaluates an operation. x*0 and the
+   operations of a value with itself are known
+   whatever the value is */
+static void visitOp(Sccp * s, const IrInstr * in)
+{ int sa = s->state[in->a], sb = s->state[in->b];
+  int x = s->value[in->a], y = s->value[in->b], value;
+  if (sa == CONSTANT && sb == CONSTANT)
+  { if (evalOperator(sourceOp(in->op), x, y, &value))
+      lower(s, in->dst, CONSTANT, value);
+    else
+      lower(s, in->dst, BOTTOM, 0);
+    return;
+  }
+  if (in->op == IrMul && ((sa == CONSTANT && x == 0) || (sb == CONSTANT && y == 0)))
+  { lower(s, in->dst, CONSTANT, 0);
+    return;
+  }
+  if (in->a == in->b)
+    switch (in->op)
+    { case IrSub : case IrLt : case IrGt : case IrNe :
+        lower(s, in->dst, CONSTANT, 0);
+        return;
+      case IrLe : case IrGe : case IrEq :
+        lower(s, in->dst, CONSTANT, 1);
+        return;
+      default :
+        break;
+    }
+  if (sa == BOTTOM || sb == BOTTOM)
+    lower(s, in->dst, BOTTOM, 0);
+}
+
+/* visitPhi meets the operands of a phi that come
+   along executable edges */
+static void visitPhi(Sccp * s, int b, const IrInstr * in)
+{ int state = TOP, value = 0, j;
+  for (j = 0; j < in->nargs && state != BOTTOM; j++)
+  { int v = s->fn->args[in->imm + j];
+    if (!s->edgeLive[s->edgeStart[b] + j] || s->state[v] == TOP) continue;
+    if (s->state[v] == BOTTOM || (state == CONSTANT && s->value[v] != value))
+      state = BOTTOM;
+    else
+    { state = CONSTANT;
+      value = s->value[v];
+    }
+  }
+  lower(s, in->dst, state, value);
+}
+
+/* visitInstr evaluates instruction i of block b */
+static void visitInstr(Sccp * s, int b, int i)
+{ const IrBlock * blk = &s->fn->blocks[b];
+  const IrInstr * in = &blk->code[i];
+  switch (in->op)
+  { case IrConst :
+      lower(s, in->dst, CONSTANT, in->imm);
+      break;
+    case IrAdd : case IrSub : case IrMul : case IrDiv :
+    case IrLt : case IrLe : case IrGt : case IrGe : case IrEq : case IrNe :
+      visitOp(s, in);
+      break;
+    case IrPhi :
+      visitPhi(s, b, in);
+      break;
+    case IrJump :
+      markEdge(s, b, blk->succ[0]);
+      break;
+    case IrBranch :
+      if (s->state[in->a] == CONSTANT)
+        markEdge(s, b, blk->succ[s->value[in->a] != 0 ? 0 : 1]);
+      else if (s->state[in->a] == BOTTOM)
+      { markEdge(s, b, blk->succ[0]);
+        markEdge(s, b, blk->succ[1]);
+      }
+      break;
+    default :
+      /* parameters, undefined values, addresses,
+         loads, input and calls */
+      if (in->dst >= 0)
+        lower(s, in->dst, BOTTOM, 0);
+      break;
+  }
+}
+
+/* propagate runs the propagation from the entry
+   until neither worklist has anything left */
+static void propagate(Sccp * s)
+{ IrFunction * fn = s->fn;
+  int i, k;
+  s->reached[0] = TRUE;
+  for (i = 0; i < fn->blocks[0].ncode; i++)
+    visitInstr(s, 0, i);
+  while (s->nflow > 0 || s->nssa > 0)
+  { if (s->nflow > 0)
+    { int b = s->edgeBlock[s->flowWork[--s->nflow]];
+      const IrBlock * blk = &fn->blocks[b];
+      if (!s->reached[b])
+      { s->reached[b] = TRUE;
+        for (i = 0; i < blk->ncode; i++)
+          visitInstr(s, b, i);
+      }
+      else
+        for (i = 0; i < blk->ncode && blk->code[i].op == IrPhi; i++)
+          visitInstr(s, b, i);
+    }
+    else
+    { int v = s->ssaWork[--s->nssa];
+      for (k = s->useStart[v]; k < s->useStart[v + 1]; k++)
+        if (s->reached[s->useBlock[k]])
+          visitInstr(s, s->useBlock[k], s->useIndex[k]);
+    }
+  }
+}
+
+/* makeConstant turns instruction in into the
+   constant value */
+static void makeConstant(IrInstr * in, int value)
+{ in->op = IrConst;
+  in->type = IrInt;
+  in->a = in->b = -1;
+  in->imm = value;
+  in->nargs = 0;
+  in->sym = NULL;
+}
+
+/* putPhisFirst moves the phis of blk that are left
+   ahead of the constants they became */
+static void putPhisFirst(IrBlock * blk)
+{ IrInstr * code = alloc(blk->ncode * sizeof(IrInstr));
+  int n = 0, i;
+  for (i = 0; i < blk->ncode; i++)
+    if (blk->code[i].op == IrPhi)
+      code[n++] = blk->code[i];
+  for (i = 0; i < blk->ncode; i++)
+    if (blk->code[i].op != IrPhi)
+      code[n++] = blk->code[i];
+  memcpy(blk->code, code, blk->ncode * sizeof(IrInstr));
+  free(code);
+}
+
+/* rewrite turns the constant values of executable
+   blocks into constants, and their branches on
+   constants into jumps */
+static void rewrite(Sccp * s)
+{ IrFunction * fn = s->fn;
+  int b, i;
+  for (b = 0; b < fn->nblocks; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    IrInstr * last;
+    int phis = FALSE;
+    if (!s->reached[b]) continue;
+    for (i = 0; i < blk->ncode; i++)
+    { IrInstr * in = &blk->code[i];
+      if (in->dst < 0 || in->op == IrConst || s->state[in->dst] != CONSTANT)
+        continue;
+      if (in->op == IrPhi) phis = TRUE;
+      makeConstant(in, s->value[in->dst]);
+    }
+    if (phis)
+      putPhisFirst(blk);
+    last = &blk->code[blk->ncode - 1];
+    if (last->op == IrBranch && s->state[last->a] == CONSTANT)
+    { int taken = blk->succ[s->value[last->a] != 0 ? 0 : 1];
+      removeEdge(fn, b, blk->succ[s->value[last->a] != 0 ? 1 : 0]);
+      blk->succ[0] = taken;
+      last->op = IrJump;
+      last->a = -1;
+    }
+  }
+}
+
+/* propagateConstants runs sparse conditional
+   constant propagation over fn and drops the
+   blocks it finds unreachable */
+static void propagateConstants(IrFunction * fn)
+{ Sccp s;
+  int nb = fn->nblocks, nedges = 0, b, j;
+  memset(&s, 0, sizeof(s));
+  s.fn = fn;
+  s.state = alloc(fn->nvalues);
+  s.value = alloc(fn->nvalues * sizeof(int));
+  s.edgeStart = alloc((nb + 1) * sizeof(int));
+  for (b = 0; b < nb; b++)
+  { s.edgeStart[b] = nedges;
+    nedges += fn->blocks[b].npreds;
+  }
+  s.edgeStart[nb] = nedges;
+  s.edgeBlock = alloc(nedges * sizeof(int));
+  for (b = 0; b < nb; b++)
+    for (j = 0; j < fn->blocks[b].npreds; j++)
+      s.edgeBlock[s.edgeStart[b] + j] = b;
+  s.edgeLive = alloc(nedges);
+  s.reached = alloc(nb);
+  s.flowWork = alloc(nedges * sizeof(int));
+  s.ssaWork = alloc(2 * fn->nvalues * sizeof(int)); /* two moves down at most */
+  findUses(&s);
+
+  propagate(&s);
+  rewrite(&s);
+  orderBlocks(fn);
+
+  free(s.state);
+  free(s.value);
+  free(s.useStart);
+  free(s.useBlock);
+  free(s.useIndex);
+  free(s.edgeStart);
+  free(s.edgeBlock);
+  free(s.edgeLive);
+  free(s.reached);
+  free(s.flowWork);
+  free(s.ssaWork);
+}
+
+/* removeTrivialPhis replaces each phi whose
+   operands are one value, besides itself, by that
+   value, until no such phi is left */
+static void removeTrivialPhis(IrFunction * fn, int * repl)
+{ int b, i, j, changed = TRUE;
+  while (changed)
+  { changed = FALSE;
+    for (b = 0; b < fn->nblocks; b++)
+    { IrBlock * blk = &fn->blocks[b];
+      for (i = 0; i < blk->ncode && blk->code[i].op == IrPhi; i++)
+      { IrInstr * phi = &blk->code[i];
+        int same = -1;
+        if (repl[phi->dst] != phi->dst) continue;
+        for (j = 0; j < phi->nargs; j++)
+        { int v = find(repl, fn->args[phi->imm + j]);
+          if (v == phi->dst || v == same) continue;
+          if (same >= 0) break;
+          same = v;
+        }
+        if (j < phi->nargs || same < 0) continue;
+        repl[phi->dst] = same;
+        changed = TRUE;
+      }
+    }
+  }
+  /* the replaced phis go with the dead code */
+  renameOperands(fn, repl);
+}
+
+/* Dce is the state of dead code elimination */
+typedef struct
+{ IrFunction * fn;
+  IrInstr ** def;       /* instruction defining each value */
+  int * root;           /* local array each address points into, or -1 */
+  unsigned char * read; /* of each local array: read, or passed on */
+  unsigned char * safe; /* constants no division traps on */
+  unsigned char * live; /* values needed */
+  int * work;
+  int nwork;
+} Dce;
+
+/* findArrays finds the local arrays whose elements
+   are only ever stored to */
+static void findArrays(Dce * d)
+{ IrFunction * fn = d->fn;
+  BucketList * arrays = alloc(fn->nvalues * sizeof(BucketList));
+  int narrays = 0, b, i, k;
+  for (i = 0; i < fn->nvalues; i++)
+    d->root[i] = -1;
+  /* definitions come before their uses outside phis */
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->op == IrAddr && in->sym->scope->parent != NULL)
+      { for (k = 0; k < narrays && arrays[k] != in->sym; k++)
+          ;
+        if (k == narrays) arrays[narrays++] = in->sym;
+        d->root[in->dst] = k;
+      }
+      else if (in->op == IrElem && d->root[in->a] >= 0)
+        d->root[in->dst] = d->root[in->a];
+    }
+  d->read = alloc(narrays);
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      for (k = 0; k < operandCount(in); k++)
+      { int v = *operandAt(fn, in, k);
+        if (v < 0 || d->root[v] < 0) continue;
+        if (k == 0 && (in->op == IrElem || in->op == IrStore)) continue;
+        d->read[d->root[v]] = TRUE;
+      }
+    }
+  free(arrays);
+}
+
+/* isCritical is TRUE for the instructions that
+   must stay whatever uses their value: side effects
+   but the stores to arrays never read, and what may
+   trap at run time */
+static int isCritical(const Dce * d, const IrInstr * in)
+{ switch (in->op)
+  { case IrStore :
+      return d->root[in->a] < 0 || d->read[d->root[in->a]];
+    case IrLoad :
+      return TRUE;
+    case IrDiv :
+      return !d->safe[in->b];
+    default :
+      return hasSideEffect(in->op);
+  }
+}
+
+/* markLive marks value v and, in turn, the values
+   its definition uses */
+static void markLive(Dce * d, int v)
+{ if (v < 0 || d->live[v]) return;
+  d->live[v] = TRUE;
+  d->work[d->nwork++] = v;
+}
+
+static void markOperands(Dce * d, IrInstr * in)
+{ int k;
+  for (k = 0; k < operandCount(in); k++)
+    markLive(d, *operandAt(d->fn, in, k));
+}
+
+/* eliminateDeadCode removes the instructions no
+   critical one needs */
+static void eliminateDeadCode(IrFunction * fn)
+{ Dce d;
+  int b, i, j;
+  d.fn = fn;
+  d.def = alloc(fn->nvalues * sizeof(IrInstr *));
+  d.root = alloc(fn->nvalues * sizeof(int));
+  d.safe = alloc(fn->nvalues);
+  d.live = alloc(fn->nvalues);
+  d.work = alloc(fn->nvalues * sizeof(int));
+  d.nwork = 0;
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+    { IrInstr * in = &fn->blocks[b].code[i];
+      if (in->dst < 0) continue;
+      d.def[in->dst] = in;
+      d.safe[in->dst] = in->op == IrConst && in->imm != 0 && in->imm != -1;
+    }
+  findArrays(&d);
+
+  for (b = 0; b < fn->nblocks; b++)
+    for (i = 0; i < fn->blocks[b].ncode; i++)
+      if (isCritical(&d, &fn->blocks[b].code[i]))
+        markOperands(&d, &fn->blocks[b].code[i]);
+  while (d.nwork > 0)
+  { IrInstr * in = d.def[d.work[--d.nwork]];
+    if (in != NULL)
+      markOperands(&d, in);
+  }
+
+  for (b = 0; b < fn->nblocks; b++)
+  { IrBlock * blk = &fn->blocks[b];
+    for (i = j = 0; i < blk->ncode; i++)
+    { IrInstr * in = &blk->code[i];
+      if (isCritical(&d, in) || (in->dst >= 0 && d.live[in->dst]))
+        blk->code[j++] = *in;
+    }
+    blk->ncode = j;
+  }
+
+  free(d.def);
+  free(d.root);
+  free(d.read);
+  free(d.safe);
+  free(d.live);
+  free(d.work);
+}
+
+void optimizeIr(IrFunction * fn)
+{ int * repl = alloc(fn->nvalues * sizeof(int));
+  int v;
+  for (v = 0; v < fn->nvalues; v++)
+    repl[v] = v;
+  if (forwardGlobals(fn, repl) > 0)
+    renameOperands(fn, repl);
+  propagateConstants(fn);
+  removeTrivialPhis(fn, repl);
+  eliminateDeadCode(fn);
+  computeDominators(fn);
+  findLoops(fn);
+  free(repl);
+}
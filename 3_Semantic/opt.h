@@ -0,0 +1,32 @@
+/****************************************************/
+/* File: opt.h                                      */
+/* Optimization of the SSA form of a function:      */
+/* constant propagation and dead code elimination   */
+/****************************************************/
+
+#ifndef _OPT_H_
+#define _OPT_H_
+
+/* Procedure optimizeIr simplifies fn, as built by
+ * buildIr, in place:
+ * - a load of a global scalar takes the value last
+ *   stored to it or loaded from it, when no call or
+ *   array store comes in between on a straight path;
+ * - sparse conditional constant propagation (Wegman
+ *   and Zadeck, "Constant Propagation with
+ *   Conditional Branches") turns the values that are
+ *   constant on every executable path into
+ *   constants and branches on them into jumps, and
+ *   the blocks left unreachable are dropped;
+ * - phis whose operands are all one value give way
+ *   to it;
+ * - dead code elimination keeps only what a side
+ *   effect needs, marked backwards from the calls,
+ *   input, output, stores and terminators; stores to
+ *   a local array that is never read go too.
+ * Divisions that may trap and loads are kept. The
+ * dominator tree and loops are computed again
+ */
+void optimizeIr(IrFunction * fn);
+
+#endif
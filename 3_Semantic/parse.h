@@ -13,4 +13,31 @@
  */
 TreeNode * parse(void);
 
+/* Procedure parseBody parses a function body
+ * recorded by the parser in lazy mode (option
+ * --lazy) and puts its syntax tree in place of
+ * body; it does nothing to a body already parsed.
+ * A body with syntax errors becomes an empty block
+ */
+void parseBody(TreeNode * body);
+
+/* Procedure parseBodies calls parseBody on the
+ * body of every function in tree
+ */
+void parseBodies(TreeNode * tree);
+
+/* DeclFun is called with each top-level declaration
+ * parsed by parseStream, and the context given to it
+ */
+typedef void (* DeclFun) (TreeNode *, void *);
+
+/* Procedure parseStream parses the source like
+ * parse, but calls handler on each top-level
+ * declaration as soon as it is complete and then
+ * releases its nodes, so the syntax tree of the
+ * whole file never exists at once. Nothing is
+ * handed over once a syntax error has been found
+ */
+void parseStream(DeclFun handler, void * context);
+
 #endif
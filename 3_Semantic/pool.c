@@ -0,0 +1,137 @@
+/****************************************************/
+/* File: pool.c                                     */
+/* Work-stealing thread pool for independent jobs:  */
+/* the jobs are dealt out as contiguous ranges, one */
+/* deque per thread; no job creates new work, so a  */
+/* thread stops once every deque is empty           */
+/****************************************************/
+
+#include <pthread.h>
+#include <unistd.h>
+#include "globals.h"
+#include "pool.h"
+
+/* Deque is the range [head, tail) of job indices
+   still owned by one thread */
+typedef struct
+{ pthread_mutex_t lock;
+  int head;
+  int tail;
+} Deque;
+
+/* Pool is the state shared by the threads of one
+   runJobs call */
+typedef struct
+{ Deque * deques;
+  int threads;
+  JobFun job;
+  void * arg;
+} Pool;
+
+/* Worker is the argument of one pool thread */
+typedef struct
+{ Pool * pool;
+  int self;
+} Worker;
+
+int onlineThreads(void)
+{ long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : (int)n;
+}
+
+/* takeOwn removes the first job of deque d,
+   returning -1 when it is empty */
+static int takeOwn(Deque * d)
+{ int job = -1;
+  pthread_mutex_lock(&d->lock);
+  if (d->head < d->tail)
+    job = d->head++;
+  pthread_mutex_unlock(&d->lock);
+  return job;
+}
+
+/* stealOther removes the last job of the first
+   non-empty deque after self, returning -1 when
+   all of them are empty */
+static int stealOther(Pool * pool, int self)
+{ int k;
+  for (k = 1; k < pool->threads; k++)
+  { Deque * d = &pool->deques[(self + k) % pool->threads];
+    int job = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->head < d->tail)
+      job = --d->tail;
+    pthread_mutex_unlock(&d->lock);
+    if (job >= 0)
+      return job;
+  }
+  return -1;
+}
+
+static void * workLoop(void * arg)
+{ Worker * w = (Worker *) arg;
+  Pool * pool = w->pool;
+  int job;
+
+  for (;;)
+  { job = takeOwn(&pool->deques[w->self]);
+    if (job < 0)
+      job = stealOther(pool, w->self);
+    if (job < 0)
+      break;
+    pool->job(job, pool->arg);
+  }
+  return NULL;
+}
+
+static void outOfMemory(void)
+{ fprintf(stderr, "Out of memory error while starting threads\n");
+  exit(1);
+}
+
+void runJobs(int count, int threads, JobFun job, void * arg)
+{ Pool pool;
+  Worker * workers;
+  pthread_t * ids;
+  int i, started;
+
+  if (threads > count)
+    threads = count;
+  if (threads <= 1)
+  { for (i = 0; i < count; i++)
+      job(i, arg);
+    return;
+  }
+
+  pool.deques = malloc(threads * sizeof(Deque));
+  workers = malloc(threads * sizeof(Worker));
+  ids = malloc(threads * sizeof(pthread_t));
+  if (pool.deques == NULL || workers == NULL || ids == NULL)
+    outOfMemory();
+  pool.threads = threads;
+  pool.job = job;
+  pool.arg = arg;
+
+  for (i = 0; i < threads; i++)
+  { pthread_mutex_init(&pool.deques[i].lock, NULL);
+    pool.deques[i].head = (int)((long)count * i / threads);
+    pool.deques[i].tail = (int)((long)count * (i + 1) / threads);
+    workers[i].pool = &pool;
+    workers[i].self = i;
+  }
+
+  /* thread 0 is the caller; if a thread cannot be
+     started its deque is simply stolen from */
+  for (started = 1; started < threads; started++)
+    if (pthread_create(&ids[started], NULL, workLoop, &workers[started]) != 0)
+      break;
+  workLoop(&workers[0]);
+  for (i = 1; i < started; i++)
+    pthread_join(ids[i], NULL);
+
+  for (i = 0; i < threads; i++)
+    pthread_mutex_destroy(&pool.deques[i].lock);
+  free(pool.deques);
+  free(workers);
+  free(ids);
+}
@@ -0,0 +1,26 @@
+/****************************************************/
+/* File: pool.h                                     */
+/* Work-stealing thread pool for independent jobs   */
+/****************************************************/
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+typedef void (* JobFun) (int, void *);
+
+/* Function onlineThreads returns the number of
+ * processors available to the compiler (at least 1)
+ */
+int onlineThreads(void);
+
+/* Procedure runJobs calls job(i, arg) once for every
+ * i in 0..count-1 on up to threads threads, the
+ * calling thread included, and returns when all of
+ * them are done. Each thread owns a deque of job
+ * indices, takes from its front in order and steals
+ * from the back of another deque once its own is
+ * empty
+ */
+void runJobs(int count, int threads, JobFun job, void * arg);
+
+#endif
@@ -0,0 +1,320 @@
+/****************************************************/
+/* File: regalloc.c                                 */
+/* Linear scan register allocation over the IR of   */
+/* a function. Positions number the instructions    */
+/* in block order, the phis of a block sharing the  */
+/* first, and each value gets one interval from its */
+/* definition to its last use, stretched over the   */
+/* loops it is live around                          */
+/****************************************************/
+
+#include "globals.h"
+#include "symtab.h"
+#include "ir.h"
+#include "regalloc.h"
+
+/* MAXDEPTH = loop depth past which uses weigh no
+   more in spill weights */
+#define MAXDEPTH 5
+
+/* Scan is the state of one allocation */
+typedef struct
+{ const IrFunction * fn;
+  const unsigned char * kept;
+  int npos;          /* positions in the function */
+  int * blockStart;  /* position of the phis of each block */
+  int * blockEnd;    /* position of its terminator */
+  int * loopEnd;     /* of a header: last position in its loop */
+  int * defBlock;    /* block defining each value */
+  int * start;       /* interval of each value, -1 if none */
+  int * end;
+  double * cost;     /* weighted uses and definitions */
+  int * callPos;     /* position of each call */
+  double * callCost; /* weighted calls before each one */
+  int ncalls;
+} Scan;
+
+static void * alloc(size_t size)
+{ void * p = calloc(size > 0 ? size : 1, 1);
+  if (p == NULL)
+    irOutOfMemory();
+  return p;
+}
+
+/* weightOf is what a use or call in block b
+   counts for */
+static double weightOf(const IrFunction * fn, int b)
+{ int depth = fn->blocks[b].loopDepth, k;
+  double w = 1;
+  for (k = 0; k < depth && k < MAXDEPTH; k++)
+    w *= 10;
+  return w;
+}
+
+/* leavingLoop returns the header of the outermost
+   loop that holds block u but not block d, or -1 */
+static int leavingLoop(const IrBlock * blocks, int u, int d)
+{ int x = blocks[u].loopHeader, y = blocks[d].loopHeader, last = -1;
+  while (x != y)
+  { int dx = (x >= 0) ? blocks[x].loopDepth : 0;
+    int dy = (y >= 0) ? blocks[y].loopDepth : 0;
+    if (dx >= dy)
+    { last = x;
+      x = blocks[x].loopParent;
+    }
+    else
+      y = blocks[y].loopParent;
+  }
+  return last;
+}
+
+/* numberPositions numbers the instructions of the
+   blocks and finds the calls and the extent of
+   each loop */
+static void numberPositions(Scan * s)
+{ const IrFunction * fn = s->fn;
+  int n = fn->nblocks, pos = 0, b, i;
+  for (b = 0; b < n; b++)
+  { const IrBlock * blk = &fn->blocks[b];
+    s->blockStart[b] = pos++;
+    for (i = 0; i < blk->ncode; i++)
+    { if (blk->code[i].dst >= 0)
+        s->defBlock[blk->code[i].dst] = b;
+      if (blk->code[i].op == IrPhi) continue;
+      if (blk->code[i].op == IrCall) s->ncalls++;
+      pos++;
+    }
+    s->blockEnd[b] = pos - 1;
+    if (blk->loopHeader >= 0 && s->loopEnd[blk->loopHeader] < s->blockEnd[b])
+      s->loopEnd[blk->loopHeader] = s->blockEnd[b];
+  }
+  s->npos = pos;
+  /* an inner loop's header comes after its parent's */
+  for (b = n - 1; b >= 0; b--)
+  { int p = fn->blocks[b].loopParent;
+    if (fn->blocks[b].loopHeader == b && p >= 0 && s->loopEnd[p] < s->loopEnd[b])
+      s->loopEnd[p] = s->loopEnd[b];
+  }
+}
+
+/* cover stretches the interval of v over pos */
+static void cover(Scan * s, int v, int pos)
+{ if (s->start[v] < 0)
+    s->start[v] = s->end[v] = pos;
+  else if (pos < s->start[v])
+    s->start[v] = pos;
+  else if (pos > s->end[v])
+    s->end[v] = pos;
+}
+
+/* useAt records a use of v at position pos of
+   block b. Along a loop entered after v is defined,
+   v stays live up to the end of the loop, for the
+   next iteration */
+static void useAt(Scan * s, int v, int b, int pos)
+{ int loop;
+  if (v < 0 || !s->kept[v]) return;
+  cover(s, v, pos);
+  s->cost[v] += weightOf(s->fn, b);
+  loop = leavingLoop(s->fn->blocks, b, s->defBlock[v]);
+  if (loop >= 0)
+    cover(s, v, s->loopEnd[loop]);
+}
+
+/* buildIntervals computes the interval and spill
+   cost of every kept value. A phi is written by the
+   copies at the end of its predecessors, which its
+   interval covers; its operands are used there */
+static void buildIntervals(Scan * s)
+{ const IrFunction * fn = s->fn;
+  int b, i, j, k, pos, calls = 0;
+  for (b = 0; b < fn->nblocks; b++)
+  { const IrBlock * blk = &fn->blocks[b];
+    double w = weightOf(fn, b);
+    pos = s->blockStart[b];
+    for (i = 0; i < blk->ncode; i++)
+    { const IrInstr * in = &blk->code[i];
+      if (in->op == IrPhi)
+      { for (j = 0; j < in->nargs; j++)
+          useAt(s, fn->args[in->imm + j], blk->preds[j], s->blockEnd[blk->preds[j]]);
+        if (s->kept[in->dst])
+        { cover(s, in->dst, pos);
+          for (j = 0; j < blk->npreds; j++)
+            cover(s, in->dst, s->blockEnd[blk->preds[j]]);
+          s->cost[in->dst] += w;
+        }
+        continue;
+      }
+      pos++;
+      useAt(s, in->a, b, pos);
+      useAt(s, in->b, b, pos);
+      if (in->op == IrCall)
+      { for (k = 0; k < in->nargs; k++)
+          useAt(s, fn->args[in->imm + k], b, pos);
+        s->callPos[calls] = pos;
+        s->callCost[calls + 1] = s->callCost[calls] + w;
+        calls++;
+      }
+      if (in->dst >= 0 && s->kept[in->dst])
+      { cover(s, in->dst, pos);
+        s->cost[in->dst] += w;
+      }
+    }
+  }
+}
+
+/* callsBefore is the number of calls before
+   position pos */
+static int callsBefore(const Scan * s, int pos)
+{ int lo = 0, hi = s->ncalls;
+  while (lo < hi)
+  { int mid = (lo + hi) / 2;
+    if (s->callPos[mid] < pos) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+/* sortBy returns the n values of items in
+   increasing order of key, which is below npos */
+static int * sortBy(const int * key, const int * items, int n, int npos)
+{ int * count = alloc((npos + 1) * sizeof(int));
+  int * sorted = alloc(n * sizeof(int));
+  int i;
+  for (i = 0; i < n; i++)
+    count[key[items[i]] + 1]++;
+  for (i = 0; i < npos; i++)
+    count[i + 1] += count[i];
+  for (i = 0; i < n; i++)
+    sorted[count[key[items[i]]]++] = items[i];
+  free(count);
+  return sorted;
+}
+
+void allocateRegisters(const IrFunction * fn, const unsigned char * kept,
+                       const int * regs, int nregs, Allocation * al)
+{ Scan s;
+  int n = fn->nvalues, nb = fn->nblocks, count = 0, nspilled = 0;
+  int next = fn->frameWords, nfree = 0, saving = FALSE;
+  int v, i, j, k;
+  int * items, * order, * byEnd, * active, * freeWords;
+  double * weight;
+
+  s.fn = fn;
+  s.kept = kept;
+  s.blockStart = alloc(nb * sizeof(int));
+  s.blockEnd = alloc(nb * sizeof(int));
+  s.loopEnd = alloc(nb * sizeof(int));
+  s.defBlock = alloc(n * sizeof(int));
+  s.start = alloc(n * sizeof(int));
+  s.end = alloc(n * sizeof(int));
+  s.cost = alloc(n * sizeof(double));
+  s.ncalls = 0;
+  numberPositions(&s);
+  s.callPos = alloc(s.ncalls * sizeof(int));
+  s.callCost = alloc((s.ncalls + 1) * sizeof(double));
+  for (v = 0; v < n; v++)
+    s.start[v] = s.end[v] = -1;
+  buildIntervals(&s);
+
+  al->reg = alloc(n * sizeof(int));
+  al->slot = alloc(n * sizeof(int));
+  al->saves = alloc(s.ncalls);
+  for (v = 0; v < n; v++)
+  { al->reg[v] = NOREG;
+    al->slot[v] = NOSLOT;
+  }
+
+  /* a register pays off if the weighted uses
+     outnumber the saves and restores around calls */
+  weight = alloc(n * sizeof(double));
+  items = alloc(n * sizeof(int));
+  for (v = 0; v < n; v++)
+    if (kept[v] && s.start[v] >= 0)
+    { int first = callsBefore(&s, s.start[v] + 1), last = callsBefore(&s, s.end[v]);
+      double benefit = s.cost[v];
+      if (last > first)
+        benefit -= 2 * (s.callCost[last] - s.callCost[first]);
+      weight[v] = benefit / (s.end[v] - s.start[v] + 1);
+      items[count++] = v;
+    }
+  order = sortBy(s.start, items, count, s.npos);
+
+  /* the scan; active[k] holds regs[k], or is -1 */
+  active = alloc(nregs * sizeof(int));
+  for (k = 0; k < nregs; k++)
+    active[k] = -1;
+  for (i = 0; i < count; i++)
+  { int victim = -1;
+    v = order[i];
+    for (k = 0; k < nregs; k++)
+      if (active[k] >= 0 && s.end[active[k]] <= s.start[v])
+        active[k] = -1;
+    if (weight[v] <= 0) continue;
+    for (k = 0; k < nregs && active[k] >= 0; k++)
+      ;
+    if (k == nregs)
+    { for (k = 0; k < nregs; k++)
+        if (victim < 0 || weight[active[k]] < weight[active[victim]])
+          victim = k;
+      if (weight[active[victim]] >= weight[v]) continue;
+      al->reg[active[victim]] = NOREG;
+      k = victim;
+    }
+    active[k] = v;
+    al->reg[v] = regs[k];
+  }
+
+  /* parameters left in memory stay in the words of
+     their arguments; the other values left there
+     share words whose values are dead */
+  for (i = 0; i < fn->blocks[0].ncode; i++)
+  { const IrInstr * in = &fn->blocks[0].code[i];
+    if (in->op == IrParam && kept[in->dst] && al->reg[in->dst] == NOREG)
+      al->slot[in->dst] = 2 + in->imm;
+  }
+  for (i = 0; i < count; i++)
+    if (al->reg[order[i]] == NOREG && al->slot[order[i]] == NOSLOT)
+      items[nspilled++] = order[i];
+  byEnd = sortBy(s.end, items, nspilled, s.npos);
+  freeWords = alloc(nspilled * sizeof(int));
+  for (i = 0, j = 0; i < nspilled; i++)
+  { v = items[i];
+    for (; j < nspilled && s.end[byEnd[j]] <= s.start[v]; j++)
+      if (al->slot[byEnd[j]] != NOSLOT)
+        freeWords[nfree++] = al->slot[byEnd[j]];
+    al->slot[v] = (nfree > 0) ? freeWords[--nfree] : next++;
+  }
+
+  /* the registers live across each call */
+  for (v = 0; v < n; v++)
+    if (al->reg[v] != NOREG)
+      for (k = callsBefore(&s, s.start[v] + 1); k < callsBefore(&s, s.end[v]); k++)
+      { al->saves[k] |= 1 << al->reg[v];
+        saving = TRUE;
+      }
+  al->saveSlot = next;
+  al->frameSize = saving ? next + nregs : next;
+
+  free(s.blockStart);
+  free(s.blockEnd);
+  free(s.loopEnd);
+  free(s.defBlock);
+  free(s.start);
+  free(s.end);
+  free(s.cost);
+  free(s.callPos);
+  free(s.callCost);
+  free(weight);
+  free(items);
+  free(order);
+  free(byEnd);
+  free(active);
+  free(freeWords);
+}
+
+void freeAllocation(Allocation * al)
+{ free(al->reg);
+  free(al->slot);
+  free(al->saves);
+}
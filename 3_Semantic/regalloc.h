@@ -0,0 +1,54 @@
+/****************************************************/
+/* File: regalloc.h                                 */
+/* Linear scan register allocation over the IR of   */
+/* a function, for the TM code generator            */
+/****************************************************/
+
+#ifndef _REGALLOC_H_
+#define _REGALLOC_H_
+
+/* NOSLOT = the word of a value kept nowhere; word 0
+   holds the caller's fp */
+#define NOSLOT 0
+
+/* NOREG = the register of a value kept in memory or
+   nowhere */
+#define NOREG (-1)
+
+/* Allocation says where each value of a function
+ * lives: in a register, or in a word of the
+ * activation record below fp
+ */
+typedef struct
+{ int * reg;      /* TM register of each value, or NOREG */
+  int * slot;     /* word of each value not in a register,
+                     or NOSLOT */
+  unsigned char * saves; /* of each call, in block order: the
+                            registers live across it, one bit
+                            per register number */
+  int saveSlot;   /* first of the words where a call saves
+                     register number k of regs, at saveSlot + k */
+  int frameSize;  /* words of the activation record */
+} Allocation;
+
+/* Function allocateRegisters places the values v of
+ * fn for which kept[v] is TRUE in the registers
+ * regs[0..nregs-1] or in the activation record, by
+ * linear scan over their live intervals in block
+ * order (Poletto and Sarkar, "Linear Scan Register
+ * Allocation"). Where registers run out, the
+ * interval with the lowest spill weight goes to
+ * memory: its uses and definitions, counted ten
+ * times per loop around them, less the saves and
+ * restores of the calls it spans, over its length.
+ * Parameters left in memory stay in the words the
+ * caller stored them in. The caller frees the
+ * result with freeAllocation
+ */
+void allocateRegisters(const IrFunction * fn, const unsigned char * kept,
+                       const int * regs, int nregs, Allocation * al);
+
+/* Procedure freeAllocation frees the arrays of al */
+void freeAllocation(Allocation * al);
+
+#endif
@@ -11,12 +11,96 @@
 /* MAXTOKENLEN is the maximum size of a token */
 #define MAXTOKENLEN 40
 
-/* tokenString array stores the lexeme of each token */
+/* tokenString array stores the lexeme of each token
+ * (filled on demand by currentTokenString)
+ */
 extern char tokenString[MAXTOKENLEN+1];
 
-/* function getToken returns the 
+/* TokenArray holds the whole token stream of a source
+ * buffer as parallel arrays. Lexemes are not copied:
+ * each token is an (offset, length) slice of the text
+ * it was scanned from. Line numbers are packed: each
+ * one is the varint (7 bits a byte, low bits first)
+ * of its difference from the line of the token before
+ * it, or from 0 for the first token, so most tokens
+ * take one byte. They are read back in token order
+ */
+typedef struct
+{
+  int count;             /* number of tokens, ENDFILE included */
+  int capacity;          /* allocated length of each array */
+  unsigned short *kind;  /* TokenType of each token */
+  unsigned char *lines;  /* packed source line of each token */
+  int lineBytes;         /* bytes used in lines */
+  int lineCapacity;      /* allocated length of lines */
+  int lastLine;          /* line of the last token, base of the next delta */
+  unsigned int *offset;  /* start of the lexeme in the text */
+  unsigned int *length;  /* length of the lexeme */
+} TokenArray;
+
+/* Procedure startScan makes the size characters
+ * at text the input of scanTokens
+ */
+void startScan(const char *text, size_t size);
+
+/* Procedure scanRange makes the characters in
+ * [begin, end) of the text given to startScan the
+ * input of scanTokens, the first of them being on
+ * line lineno
+ */
+void scanRange(size_t begin, size_t end, int lineno);
+
+/* Function scanTokens appends the next tokens of
+ * the input, at most max of them, to tokens and
+ * returns TRUE once ENDFILE has been appended; the
+ * parser takes the stream in batches this way. A
+ * batch also ends right after a stop token (pass
+ * ENDFILE for none)
+ */
+int scanTokens(TokenArray *tokens, int max, TokenType stop);
+
+/* Procedure appendToken adds one token to the end
+ * of tokens, growing the arrays when needed
+ */
+void appendToken(TokenArray *tokens, TokenType kind, int lineno,
+                 unsigned int offset, unsigned int length);
+
+/* function getToken returns the
  * next token in source file
  */
 TokenType getToken(void);
 
+/* Procedure skipBlock records in body the block
+ * opened by the "{" last returned by getToken and
+ * moves the scan past its "}" without tokenizing
+ * it. Returns FALSE, leaving the scan where it
+ * is, if the block is not closed
+ */
+int skipBlock(LazyBody *body);
+
+/* Procedure scanBody makes the tokens of a block
+ * recorded by skipBlock, followed by ENDFILE, the
+ * next ones returned by getToken
+ */
+void scanBody(const LazyBody *body);
+
+/* Procedure restartScan releases the source text
+ * read so far, so that the next getToken starts
+ * over on source; trees parsed before must not
+ * have lazy bodies left to parse
+ */
+void restartScan(void);
+
+/* Function currentTokenString copies the lexeme of
+ * the token last returned by getToken into
+ * tokenString and returns it
+ */
+char *currentTokenString(void);
+
+/* Function currentLexeme returns the lexeme of the
+ * token last returned by getToken as a slice of
+ * the source text
+ */
+Lexeme currentLexeme(void);
+
 #endif
@@ -0,0 +1,153 @@
+/****************************************************/
+/* File: sigtab.c                                   */
+/* Interned function signatures: every distinct     */
+/* (return type, parameter types) tuple gets one    */
+/* small integer id. Records live in an array       */
+/* indexed by id; lookup is open-addressed with     */
+/* linear probing and doubles at 50% load. Lookups  */
+/* share a read lock, insertions take it exclusive  */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "sigtab.h"
+#include "arena.h"
+
+/* initial number of slots, a power of two */
+#define INIT_SLOTS 64
+
+typedef struct {
+  unsigned int hash;
+  ExpType returnType;
+  int count;
+  ExpType *params;
+} SigRec;
+
+static SigRec *sigs = NULL;      /* indexed by id, sigs[0] unused */
+static int sigCount = 1;
+static int sigCapacity = 0;
+
+static int *slots = NULL;        /* ids, NO_SIGNATURE when empty */
+static unsigned int slotCount = 0;
+
+static Arena paramArena;         /* parameter arrays of the records */
+
+static pthread_rwlock_t sigLock = PTHREAD_RWLOCK_INITIALIZER;
+
+static void outOfMemory (void) {
+  fprintf(listing, "Out of memory error while interning signatures\n");
+  exit(1);
+}
+
+/* FNV-1a over the return type and the parameter types */
+static unsigned int hashSignature (ExpType returnType, const ExpType *params, int count) {
+  unsigned int h = (2166136261u ^ (unsigned)returnType) * 16777619u;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    h = (h ^ (unsigned)params[i]) * 16777619u;
+  }
+
+  return h;
+}
+
+static void growSlots (void) {
+  unsigned int newCount = slotCount == 0 ? INIT_SLOTS : slotCount * 2;
+  int *newSlots = calloc(newCount, sizeof(int));
+  int id;
+
+  if (newSlots == NULL) {
+    outOfMemory();
+  }
+
+  for (id = 1; id < sigCount; id++) {
+    unsigned int j = sigs[id].hash & (newCount - 1);
+
+    while (newSlots[j] != NO_SIGNATURE) {
+      j = (j + 1) & (newCount - 1);
+    }
+
+    newSlots[j] = id;
+  }
+
+  free(slots);
+  slots = newSlots;
+  slotCount = newCount;
+}
+
+/* findSignature returns the slot holding the id of
+   the signature, or the empty slot where it would go */
+static unsigned int findSignature (unsigned int h, ExpType returnType, const ExpType *params, int count) {
+  unsigned int i;
+
+  for (i = h & (slotCount - 1); slots[i] != NO_SIGNATURE; i = (i + 1) & (slotCount - 1)) {
+    SigRec *rec = &sigs[slots[i]];
+
+    if (rec->hash == h && rec->returnType == returnType && rec->count == count
+      && (count == 0 || memcmp(rec->params, params, count * sizeof(ExpType)) == 0)) {
+      break;
+    }
+  }
+
+  return i;
+}
+
+int internSignature (ExpType returnType, const ExpType *params, int count) {
+  unsigned int h = hashSignature(returnType, params, count);
+  unsigned int i;
+  SigRec *rec;
+  int id = NO_SIGNATURE;
+
+  // 대부분은 이미 있는 시그니처이므로 read lock으로 먼저 찾음
+  pthread_rwlock_rdlock(&sigLock);
+  if (slotCount > 0) {
+    id = slots[findSignature(h, returnType, params, count)];
+  }
+  pthread_rwlock_unlock(&sigLock);
+
+  if (id != NO_SIGNATURE) {
+    return id;
+  }
+
+  pthread_rwlock_wrlock(&sigLock);
+  if ((unsigned int)sigCount * 2 > slotCount) {
+    growSlots();
+  }
+
+  // read lock을 놓은 사이에 다른 스레드가 추가했을 수 있음
+  i = findSignature(h, returnType, params, count);
+  if (slots[i] != NO_SIGNATURE) {
+    id = slots[i];
+    pthread_rwlock_unlock(&sigLock);
+    return id;
+  }
+
+  if (sigCount >= sigCapacity) {
+    sigCapacity = sigCapacity == 0 ? INIT_SLOTS : sigCapacity * 2;
+    sigs = realloc(sigs, sigCapacity * sizeof(SigRec));
+
+    if (sigs == NULL) {
+      outOfMemory();
+    }
+  }
+
+  rec = &sigs[sigCount];
+  rec->hash = h;
+  rec->returnType = returnType;
+  rec->count = count;
+  rec->params = NULL;
+
+  if (count > 0) {
+    rec->params = arenaAlloc(&paramArena, count * sizeof(ExpType));
+
+    if (rec->params == NULL) {
+      outOfMemory();
+    }
+    memcpy(rec->params, params, count * sizeof(ExpType));
+  }
+
+  slots[i] = sigCount;
+  id = sigCount++;
+  pthread_rwlock_unlock(&sigLock);
+  return id;
+}
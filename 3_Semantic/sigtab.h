@@ -0,0 +1,26 @@
+/****************************************************/
+/* File: sigtab.h                                   */
+/* Interned function signatures: every distinct     */
+/* (return type, parameter types) tuple gets one    */
+/* small integer id                                 */
+/****************************************************/
+
+#ifndef _SIGTAB_H_
+#define _SIGTAB_H_
+
+/* id of no signature; real ids start at 1 */
+#define NO_SIGNATURE 0
+
+/**
+ * @brief 반환 타입 returnType과 파라미터 타입 params[0..count-1]로 이루어진
+ * 시그니처의 id를 반환합니다. 같은 시그니처는 항상 같은 id를 가지므로
+ * 시그니처 비교는 id 비교 한 번이면 됩니다.
+ *
+ * @param returnType 
+ * @param params count개의 파라미터 (또는 인자) 타입
+ * @param count 
+ * @return int NO_SIGNATURE가 아닌 id
+ */
+int internSignature (ExpType returnType, const ExpType *params, int count);
+
+#endif
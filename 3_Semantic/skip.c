@@ -0,0 +1,161 @@
+/****************************************************/
+/* File: skip.c                                     */
+/* Vectorized whitespace and comment skipping       */
+/* kernels for the C-Minus scanner                  */
+/* AVX2 or SSE2 is selected at compile time; other  */
+/* targets only use the scalar loops                */
+/****************************************************/
+
+#include "globals.h"
+#include "skip.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VECLEN 32
+typedef __m256i Vec;
+#define vecLoad(p) _mm256_loadu_si256((const __m256i *)(p))
+#define vecSplat(c) _mm256_set1_epi8(c)
+#define vecEq(a, b) _mm256_cmpeq_epi8(a, b)
+#define vecOr(a, b) _mm256_or_si256(a, b)
+#define vecAnd(a, b) _mm256_and_si256(a, b)
+#define vecMask(v) ((unsigned)_mm256_movemask_epi8(v))
+#define ALLSET 0xFFFFFFFFu
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VECLEN 16
+typedef __m128i Vec;
+#define vecLoad(p) _mm_loadu_si128((const __m128i *)(p))
+#define vecSplat(c) _mm_set1_epi8(c)
+#define vecEq(a, b) _mm_cmpeq_epi8(a, b)
+#define vecOr(a, b) _mm_or_si128(a, b)
+#define vecAnd(a, b) _mm_and_si128(a, b)
+#define vecMask(v) ((unsigned)_mm_movemask_epi8(v))
+#define ALLSET 0xFFFFu
+#endif
+
+/* Function skipBlanks returns the first character
+ * in [p, end) that is not a blank, tab or newline,
+ * or end if there is none
+ */
+const char *skipBlanks(const char *p, const char *end)
+{
+#ifdef VECLEN
+  const Vec blank = vecSplat(' ');
+  const Vec tab = vecSplat('\t');
+  const Vec newline = vecSplat('\n');
+  while (end - p >= VECLEN)
+  {
+    Vec v = vecLoad(p);
+    unsigned mask = vecMask(vecOr(vecOr(vecEq(v, blank), vecEq(v, tab)),
+                                  vecEq(v, newline)));
+    if (mask != ALLSET)
+      return p + __builtin_ctz(~mask);
+    p += VECLEN;
+  }
+#endif
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n'))
+    p++;
+  return p;
+}
+
+/* Function findCommentEnd returns the position just
+ * after the first "*" "/" pair in [p, end), or NULL
+ * if the comment is not closed before end
+ */
+const char *findCommentEnd(const char *p, const char *end)
+{
+#ifdef VECLEN
+  const Vec star = vecSplat('*');
+  const Vec slash = vecSplat('/');
+  /* the second load reads one character past the
+     block, so keep VECLEN + 1 characters available */
+  while (end - p > VECLEN)
+  {
+    unsigned mask = vecMask(vecAnd(vecEq(vecLoad(p), star),
+                                   vecEq(vecLoad(p + 1), slash)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask) + 2;
+    p += VECLEN;
+  }
+#endif
+  for (; p + 1 < end; p++)
+    if (p[0] == '*' && p[1] == '/')
+      return p + 2;
+  return NULL;
+}
+
+/* Function findBlockEnd returns the position just
+ * after the "}" closing the block whose "{" comes
+ * just before p, skipping nested blocks and
+ * comments, or NULL if the block is not closed
+ * before end. C-Minus has no string or character
+ * literals, so braces outside comments are tokens
+ */
+const char *findBlockEnd(const char *p, const char *end)
+{
+  int depth = 1;
+#ifdef VECLEN
+  const Vec open = vecSplat('{');
+  const Vec close = vecSplat('}');
+  const Vec slash = vecSplat('/');
+#endif
+  while (p < end)
+  {
+#ifdef VECLEN
+    /* jump to the next brace or slash */
+    while (end - p >= VECLEN)
+    {
+      Vec v = vecLoad(p);
+      unsigned mask = vecMask(vecOr(vecOr(vecEq(v, open), vecEq(v, close)),
+                                    vecEq(v, slash)));
+      if (mask != 0)
+      {
+        p += __builtin_ctz(mask);
+        break;
+      }
+      p += VECLEN;
+    }
+    if (p == end)
+      break;
+#endif
+    switch (*p++)
+    {
+    case '{':
+      depth++;
+      break;
+    case '}':
+      if (--depth == 0)
+        return p;
+      break;
+    case '/':
+      if (p < end && *p == '*')
+      {
+        p = findCommentEnd(p + 1, end);
+        if (p == NULL)
+          return NULL;
+      }
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* Function countNewlines returns the number of
+ * newline characters in [p, end)
+ */
+int countNewlines(const char *p, const char *end)
+{
+  int n = 0;
+#ifdef VECLEN
+  const Vec newline = vecSplat('\n');
+  while (end - p >= VECLEN)
+  {
+    n += __builtin_popcount(vecMask(vecEq(vecLoad(p), newline)));
+    p += VECLEN;
+  }
+#endif
+  for (; p < end; p++)
+    if (*p == '\n')
+      n++;
+  return n;
+}
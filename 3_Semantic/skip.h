@@ -0,0 +1,35 @@
+/****************************************************/
+/* File: skip.h                                     */
+/* Vectorized whitespace and comment skipping       */
+/* kernels for the C-Minus scanner                  */
+/****************************************************/
+
+#ifndef _SKIP_H_
+#define _SKIP_H_
+
+/* Function skipBlanks returns the first character
+ * in [p, end) that is not a blank, tab or newline,
+ * or end if there is none
+ */
+const char *skipBlanks(const char *p, const char *end);
+
+/* Function findCommentEnd returns the position just
+ * after the first "*" "/" pair in [p, end), or NULL
+ * if the comment is not closed before end
+ */
+const char *findCommentEnd(const char *p, const char *end);
+
+/* Function findBlockEnd returns the position just
+ * after the "}" closing the block whose "{" comes
+ * just before p, skipping nested blocks and
+ * comments, or NULL if the block is not closed
+ * before end
+ */
+const char *findBlockEnd(const char *p, const char *end);
+
+/* Function countNewlines returns the number of
+ * newline characters in [p, end)
+ */
+int countNewlines(const char *p, const char *end);
+
+#endif
@@ -0,0 +1,106 @@
+/****************************************************/
+/* File: srcbuf.c                                   */
+/* Whole-file source buffer for the C-Minus scanner */
+/* Regular files are mapped with mmap, other inputs */
+/* fall back to a growable heap buffer              */
+/****************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "globals.h"
+#include "srcbuf.h"
+
+/* INITBUFSIZE = initial size of the heap buffer
+   used when the source cannot be mapped */
+#define INITBUFSIZE 65536
+
+/* readWholeStream reads fp until EOF into a heap
+   buffer that doubles whenever it fills up */
+static int readWholeStream(SourceBuffer *buf, FILE *fp)
+{
+  size_t capacity = INITBUFSIZE;
+  size_t n;
+  char *text = malloc(capacity);
+  if (text == NULL)
+    return FALSE;
+  buf->size = 0;
+  while ((n = fread(text + buf->size, 1, capacity - buf->size, fp)) > 0)
+  {
+    buf->size += n;
+    if (buf->size == capacity)
+    {
+      char *grown = realloc(text, capacity * 2);
+      if (grown == NULL)
+      {
+        free(text);
+        return FALSE;
+      }
+      text = grown;
+      capacity *= 2;
+    }
+  }
+  if (ferror(fp))
+  {
+    free(text);
+    return FALSE;
+  }
+  buf->text = text;
+  buf->mapped = FALSE;
+  return TRUE;
+}
+
+/* Function loadSource fills buf with the whole
+ * contents of fp. Returns FALSE on a read error
+ */
+int loadSource(SourceBuffer *buf, FILE *fp)
+{
+  struct stat st;
+  int fd = fileno(fp);
+  buf->text = NULL;
+  buf->size = 0;
+  buf->mapped = FALSE;
+  buf->released = 0;
+  if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      madvise(p, st.st_size, MADV_SEQUENTIAL);
+      buf->text = p;
+      buf->size = st.st_size;
+      buf->mapped = TRUE;
+      return TRUE;
+    }
+  }
+  return readWholeStream(buf, fp);
+}
+
+/* Procedure releaseSourceBefore gives the pages of
+ * a mapped buffer that lie wholly before p back to
+ * the system; the text there must not be read again
+ */
+void releaseSourceBefore(SourceBuffer *buf, const char *p)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t end = (size_t)(p - buf->text) / page * page;
+  if (!buf->mapped || end <= buf->released)
+    return;
+  madvise(buf->text + buf->released, end - buf->released, MADV_DONTNEED);
+  buf->released = end;
+}
+
+/* Procedure releaseSource unmaps or frees
+ * the text held by buf
+ */
+void releaseSource(SourceBuffer *buf)
+{
+  if (buf->mapped)
+    munmap(buf->text, buf->size);
+  else
+    free(buf->text);
+  buf->text = NULL;
+  buf->size = 0;
+  buf->mapped = FALSE;
+}
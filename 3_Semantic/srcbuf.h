@@ -0,0 +1,38 @@
+/****************************************************/
+/* File: srcbuf.h                                   */
+/* Whole-file source buffer for the C-Minus scanner */
+/****************************************************/
+
+#ifndef _SRCBUF_H_
+#define _SRCBUF_H_
+
+/* SourceBuffer holds the complete text of a source
+ * file in memory. Regular files are mapped with mmap,
+ * anything else (pipes, terminals) is read into a
+ * growable heap buffer
+ */
+typedef struct
+{
+  char *text;  /* first character of the source text */
+  size_t size; /* number of characters in text */
+  int mapped;  /* TRUE if text was obtained with mmap */
+  size_t released; /* characters given back by releaseSourceBefore */
+} SourceBuffer;
+
+/* Function loadSource fills buf with the whole
+ * contents of fp. Returns FALSE on a read error
+ */
+int loadSource(SourceBuffer *buf, FILE *fp);
+
+/* Procedure releaseSourceBefore gives the pages of
+ * a mapped buffer that lie wholly before p back to
+ * the system; the text there must not be read again
+ */
+void releaseSourceBefore(SourceBuffer *buf, const char *p);
+
+/* Procedure releaseSource unmaps or frees
+ * the text held by buf
+ */
+void releaseSource(SourceBuffer *buf);
+
+#endif
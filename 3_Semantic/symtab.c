@@ -2,8 +2,14 @@
 /* File: symtab.c                                   */
 /* Symbol table implementation for the TINY compiler*/
 /* (allows only one symbol table)                   */
-/* Symbol table is implemented as a chained         */
-/* hash table                                       */
+/* Small scopes are searched linearly; past        */
+/* SMALL_SCOPE symbols a scope builds an open-      */
+/* addressing index with linear probing over a      */
+/* power-of-two array, cached 64-bit name hashes    */
+/* and one control byte per slot. While a scope    */
+/* is entered, its symbols are also bound in a      */
+/* per-thread name table whose entries are shadow   */
+/* stacks, so nested lookups cost one probe         */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -11,95 +17,433 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "globals.h"
 #include "symtab.h"
-
-
-/* SHIFT is the power of two used as multiplier
-   in hash function  */
-#define SHIFT 4
+#include "intern.h"
+#include "arena.h"
+#include "sigtab.h"
 
 
 const int ONLY_FUNC_SYMBOL = FuncSymbol;
 const int ONLY_VAR_SYMBOL = VarSymbol;
 const int ALL_SYMBOL = FuncSymbol | VarSymbol;
 
-/* the hash function */
-static int hash ( char * key )
-{ int temp = 0;
-  int i = 0;
-  while (key[i] != '\0')
-  { temp = ((temp << SHIFT) + key[i]) % HASH_TABLE_SIZE;
-    ++i;
+/* INIT_SLOTS = slots of a scope's first index, a power of two */
+#define INIT_SLOTS (SMALL_SCOPE > 4 ? 2 * SMALL_SCOPE : 8)
+
+/* control byte of an empty slot; used slots hold
+   the top 7 bits of the name hash, so a probe skips
+   most non-matching slots without touching them */
+#define EMPTY_SLOT 0x80
+#define SLOT_TAG(h) ((unsigned char)((h) >> 57))
+
+/* scopes, symbols, line lists and parameters live as
+   long as the symbol table, so they are bump-allocated;
+   each thread has its own arenas, whose chunks outlive
+   the thread. The global scope and everything it owns
+   come from globalArena, local scopes from localArena,
+   which releaseLocalScopes empties */
+static _Thread_local Arena globalArena;
+static _Thread_local Arena localArena;
+
+/* arena of the memory owned by scope */
+#define SCOPE_ARENA(scope) ((scope)->parent == NULL ? &globalArena : &localArena)
+
+static void * allocSymtab (Arena *arena, size_t size) {
+  void *p = arenaAlloc(arena, size);
+
+  if (p == NULL) {
+    fprintf(stderr, "Out of memory error while building the symbol table\n");
+    exit(1);
   }
-  return temp;
+  return p;
 }
 
-static ParameterList createParameter (ExpType type) {
-  ParameterList p = malloc(sizeof(struct Parameter));
-  p->type = type;
-  p->next = NULL;
+/* INIT_PARAMS = initial capacity of a parameter array */
+#define INIT_PARAMS 4
 
-  return p;
+/* appendParameter adds type at the tail of the
+   parameter array of func, doubling it when full */
+static void appendParameter (BucketList func, ExpType type) {
+  struct FunctionType *f = &func->type.funType;
+
+  if (f->paramCount == f->paramCapacity) {
+    int capacity = f->paramCapacity == 0 ? INIT_PARAMS : f->paramCapacity * 2;
+    ExpType *params = allocSymtab(SCOPE_ARENA(func->scope), capacity * sizeof(ExpType));
+
+    if (f->paramCount > 0) {
+      memcpy(params, f->params, f->paramCount * sizeof(ExpType));
+    }
+    f->params = params;
+    f->paramCapacity = capacity;
+  }
+
+  f->params[f->paramCount++] = type;
+  f->signature = NO_SIGNATURE;
+}
+
+/* clearParameters gives func an empty parameter list */
+static void clearParameters (BucketList func) {
+  func->type.funType.params = NULL;
+  func->type.funType.paramCount = 0;
+  func->type.funType.paramCapacity = 0;
+  func->type.funType.signature = NO_SIGNATURE;
 }
 
 
-static LineList createLine (int lineno) {
-  LineList line = malloc(sizeof(struct LineListRec));
-  line->lineno = lineno;
-  line->next = NULL;
+/* line index chunks start at INIT_LINE_CHUNK bytes
+   and double up to MAX_LINE_CHUNK; a chunk always has
+   room for MAX_VARINT more bytes before an append */
+#define INIT_LINE_CHUNK 8
+#define MAX_LINE_CHUNK 256
+#define MAX_VARINT 5
 
-  return line;
+static LineChunk createLineChunk (BucketList symbol, int size) {
+  LineChunk chunk = allocSymtab(SCOPE_ARENA(symbol->scope), sizeof(struct LineChunkRec) + size);
+
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+
+  return chunk;
 }
 
+void addReference (BucketList symbol, int lineno) {
+  LineIndex *index = &symbol->lines;
+  LineChunk chunk = index->last;
+  int delta = lineno - index->lastLine;
+  unsigned int zigzag;
+
+  if (index->count > 0 && delta == 0) {
+    return;
+  }
+
+  if (chunk == NULL || chunk->size - chunk->used < MAX_VARINT) {
+    int size = INIT_LINE_CHUNK;
+    if (chunk != NULL) {
+      size = chunk->size * 2 < MAX_LINE_CHUNK ? chunk->size * 2 : MAX_LINE_CHUNK;
+    }
 
-static BucketList createBucket (char* name, int lineno) {
-  BucketList bucket = malloc(sizeof(struct BucketListRec));
+    LineChunk next = createLineChunk(symbol, size);
+    if (chunk == NULL) {
+      index->first = next;
+    } else {
+      chunk->next = next;
+    }
+    index->last = chunk = next;
+  }
 
-  bucket->name = strdup(name);
-  bucket->lines = createLine(lineno);
+  // 음수 delta도 작은 수가 되도록 zigzag 인코딩 후 7비트씩 저장
+  zigzag = ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31);
+  while (zigzag >= 0x80) {
+    chunk->data[chunk->used++] = (unsigned char)(zigzag | 0x80);
+    zigzag >>= 7;
+  }
+  chunk->data[chunk->used++] = (unsigned char)zigzag;
+
+  index->lastLine = lineno;
+  index->count++;
+}
+
+/* LineCursor walks a LineIndex from its first line */
+typedef struct LineCursor {
+  LineChunk chunk;
+  int pos;
+  int line;
+} LineCursor;
+
+/* nextLine stores the next line of the cursor in
+   lineno, returning FALSE at the end of the index */
+static int nextLine (LineCursor *cursor, int *lineno) {
+  unsigned int zigzag = 0;
+  int shift = 0;
+  unsigned char byte;
+
+  while (cursor->chunk != NULL && cursor->pos == cursor->chunk->used) {
+    cursor->chunk = cursor->chunk->next;
+    cursor->pos = 0;
+  }
+  if (cursor->chunk == NULL) {
+    return FALSE;
+  }
+
+  do {
+    byte = cursor->chunk->data[cursor->pos++];
+    zigzag |= (unsigned int)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  cursor->line += (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+  *lineno = cursor->line;
+  return TRUE;
+}
+
+static void printLines (FILE *listing, BucketList symbol) {
+  LineCursor cursor = { symbol->lines.first, 0, 0 };
+  int lineno;
+
+  while (nextLine(&cursor, &lineno)) {
+    fprintf(listing, "%4d ", lineno);
+  }
+}
+
+
+static BucketList createBucket (ScopeList scope, char* name, int lineno) {
+  BucketList bucket = allocSymtab(SCOPE_ARENA(scope), sizeof(struct BucketListRec));
+
+  bucket->name = name;
+  bucket->scope = scope;
+  bucket->lines.first = bucket->lines.last = NULL;
+  bucket->lines.lastLine = 0;
+  bucket->lines.count = 0;
+  addReference(bucket, lineno);
   bucket->next = NULL;
+  bucket->address = 0;
 
   return bucket;
 }
 
+/* placeSymbol stores bucket in the first empty slot
+   of its probe sequence; symbols are never moved, so
+   same-name symbols stay in insertion order */
+static void placeSymbol (ScopeList scope, BucketList bucket, unsigned long long h) {
+  unsigned int mask = scope->capacity - 1;
+  unsigned int i = h & mask;
+
+  while (scope->ctrl[i] != EMPTY_SLOT) {
+    i = (i + 1) & mask;
+  }
+
+  scope->ctrl[i] = SLOT_TAG(h);
+  scope->slots[i].hash = h;
+  scope->slots[i].symbol = bucket;
+}
+
+/* growSlots builds the index of a small scope from its
+   inline array, or doubles an existing index. The old
+   slots are re-placed with their cached hashes, starting
+   just after an empty slot so that no probe run is split
+   and same-name symbols keep their order */
+static void growSlots (ScopeList scope) {
+  int oldCapacity = scope->capacity;
+  int capacity = oldCapacity == 0 ? INIT_SLOTS : oldCapacity * 2;
+  SymbolSlot *oldSlots = scope->slots;
+  unsigned char *oldCtrl = scope->ctrl;
+  // local scopes are released with localArena, so their index comes from it too
+  SymbolSlot *slots = scope->parent == NULL ?
+    malloc(capacity * (sizeof(SymbolSlot) + 1)) : allocSymtab(&localArena, capacity * (sizeof(SymbolSlot) + 1));
+  int start, k;
+
+  if (slots == NULL) {
+    fprintf(stderr, "Out of memory error while building the symbol table\n");
+    exit(1);
+  }
+
+  scope->slots = slots;
+  scope->ctrl = (unsigned char *)(slots + capacity);
+  scope->capacity = capacity;
+  memset(scope->ctrl, EMPTY_SLOT, capacity);
+
+  if (oldCapacity == 0) {
+    for (k = 0; k < scope->symbolCount; k++) {
+      placeSymbol(scope, scope->small[k], nameHash(scope->small[k]->name));
+    }
+  } else {
+    for (start = 0; oldCtrl[start] != EMPTY_SLOT; start++)
+      ;
+    for (k = 1; k <= oldCapacity; k++) {
+      int i = (start + k) & (oldCapacity - 1);
+
+      if (oldCtrl[i] != EMPTY_SLOT) {
+        placeSymbol(scope, oldSlots[i].symbol, oldSlots[i].hash);
+      }
+    }
+  }
+
+  if (scope->parent == NULL) {
+    free(oldSlots);
+  }
+}
+
 static void insertBucket (ScopeList scope, BucketList bucket) {
-  int hashed = hash(bucket->name);
+  if (scope->capacity == 0 && scope->symbolCount < SMALL_SCOPE) {
+    // 작은 스코프는 inline 배열에 순서대로 저장
+    scope->small[scope->symbolCount] = bucket;
+  } else {
+    // SMALL_SCOPE를 넘거나 load factor 3/4를 넘으면 인덱스를 만들거나 두 배로 키움
+    if ((scope->symbolCount + 1) * 4 > scope->capacity * 3) {
+      growSlots(scope);
+    }
+    placeSymbol(scope, bucket, nameHash(bucket->name));
+  }
+  scope->symbolCount++;
 
-  if (scope->bucket[hashed][1] == NULL) {
-    scope->bucket[hashed][0] = scope->bucket[hashed][1] = bucket;
-    bucket->next = NULL;
+  bucket->scope = scope;
+  bucket->shadowed = NULL;
+  bucket->next = NULL;
+  if (scope->last == NULL) {
+    scope->first = scope->last = bucket;
   } else {
-    scope->bucket[hashed][1]->next = bucket;
-    scope->bucket[hashed][1] = bucket;
+    scope->last->next = bucket;
+    scope->last = bucket;
   }
 }
 
 
-static ScopeList createScope (void) {
-  ScopeList scope = malloc(sizeof(struct ScopeListRec));
-  
-  for (int i = 0; i < HASH_TABLE_SIZE; i++) {
-    scope->bucket[i][0] = scope->bucket[i][1] = NULL;
+/* BindingSlot is one entry of the global name table:
+   an interned name and the top of its shadow stack,
+   the innermost visible symbol of that name */
+typedef struct {
+  char *name;
+  BucketList top;
+} BindingSlot;
+
+/* the name table is keyed by interned pointer, open
+   addressed with linear probing and doubled at 50% load;
+   every thread enters its own scopes, so it has a table
+   of its own */
+static _Thread_local BindingSlot *bindSlots = NULL;
+static _Thread_local unsigned int bindCapacity = 0;
+static _Thread_local unsigned int bindCount = 0;
+
+/* innermost scope entered with enterScope */
+static _Thread_local ScopeList activeScope = NULL;
+
+/* scope set by freezeScope and the last memloc
+   visible in it */
+static _Thread_local ScopeList frozenScope = NULL;
+static _Thread_local int frozenLimit = 0;
+
+/* probeBinding returns the slot of name, or the
+   empty slot where it would go */
+static BindingSlot *probeBinding (char *name) {
+  unsigned int mask = bindCapacity - 1;
+  unsigned int i = nameHash(name) & mask;
+
+  while (bindSlots[i].name != NULL && bindSlots[i].name != name) {
+    i = (i + 1) & mask;
+  }
+
+  return &bindSlots[i];
+}
+
+static void growBindings (void) {
+  BindingSlot *old = bindSlots;
+  unsigned int oldCapacity = bindCapacity;
+  unsigned int i;
+
+  bindCapacity = oldCapacity == 0 ? 256 : oldCapacity * 2;
+  bindSlots = calloc(bindCapacity, sizeof(BindingSlot));
+
+  if (bindSlots == NULL) {
+    fprintf(stderr, "Out of memory error while building the symbol table\n");
+    exit(1);
+  }
+
+  for (i = 0; i < oldCapacity; i++) {
+    if (old[i].name != NULL) {
+      *probeBinding(old[i].name) = old[i];
+    }
+  }
+
+  free(old);
+}
+
+/* bindSymbol pushes bucket on the shadow stack of
+   its name. As in lookupScope, the first symbol of a
+   kind declared in a scope wins, so a later one of
+   the same scope and kind is not pushed */
+static void bindSymbol (BucketList bucket) {
+  BindingSlot *slot;
+  BucketList b;
+
+  if ((bindCount + 1) * 2 > bindCapacity) {
+    growBindings();
+  }
+
+  slot = probeBinding(bucket->name);
+  if (slot->name == NULL) {
+    slot->name = bucket->name;
+    slot->top = NULL;
+    bindCount++;
+  }
+
+  for (b = slot->top; b != NULL && b->scope == bucket->scope; b = b->shadowed) {
+    if (b->kind == bucket->kind) {
+      return;
+    }
+  }
+
+  bucket->shadowed = slot->top;
+  slot->top = bucket;
+}
+
+void enterScope (ScopeList scope) {
+  BucketList b;
+
+  // 이름 테이블은 스레드의 것이므로, 다른 분석이 global scope 안에 있는 동안에는 들어갈 수 없음
+  assert(scope->parent != NULL || activeScope == NULL);
+  activeScope = scope;
+  for (b = scope->first; b != NULL; b = b->next) {
+    bindSymbol(b);
   }
+}
+
+void leaveScope (ScopeList scope) {
+  BucketList b;
+
+  for (b = scope->first; b != NULL; b = b->next) {
+    BindingSlot *slot = probeBinding(b->name);
+
+    while (slot->top != NULL && slot->top->scope == scope) {
+      slot->top = slot->top->shadowed;
+    }
+  }
+  activeScope = scope->parent;
+}
+
+static ScopeList createScope (ScopeList parent) {
+  ScopeList scope = allocSymtab(parent == NULL ? &globalArena : &localArena, sizeof(struct ScopeListRec));
+
+  scope->ctrl = NULL;
+  scope->slots = NULL;
+  scope->capacity = 0;
+  scope->symbolCount = 0;
+  scope->first = scope->last = NULL;
 
   scope->name = NULL;
-  scope->parent = NULL;
+  scope->parent = parent;
   scope->locationCount = 0;
+  scope->function = NULL;
 
   return scope;
 }
 
+/* names of the global scope and its built-in
+   functions, interned once: the intern table is
+   not safe to update from several threads */
+static pthread_once_t builtinOnce = PTHREAD_ONCE_INIT;
+static char *globalName, *inputName, *outputName;
+
+static void internBuiltins (void) {
+  globalName = internName("global", 6);
+  inputName = internName("input", 5);
+  outputName = internName("output", 6);
+}
+
 ScopeList createGlobalScope (void) {
-  ScopeList scope = createScope();
+  ScopeList scope = createScope(NULL);
   
-  scope->name = strdup("global");
+  pthread_once(&builtinOnce, internBuiltins);
+  scope->name = globalName;
 
   {
-    BucketList bucket = createBucket("input", 0);
+    BucketList bucket = createBucket(scope, inputName, 0);
     bucket->kind = FuncSymbol;
     bucket->type.funType.returnType = Integer;
-    bucket->type.funType.params = NULL;
+    clearParameters(bucket);
+    functionSignature(bucket);
 
     bucket->memloc = scope->locationCount++;
     
@@ -107,10 +451,12 @@ ScopeList createGlobalScope (void) {
   }
 
   {
-    BucketList bucket = createBucket("output", 0);
+    BucketList bucket = createBucket(scope, outputName, 0);
     bucket->kind = FuncSymbol;
     bucket->type.funType.returnType = Void;
-    bucket->type.funType.params = createParameter(Integer);
+    clearParameters(bucket);
+    appendParameter(bucket, Integer);
+    functionSignature(bucket);
     
     bucket->memloc = scope->locationCount++;
 
@@ -121,49 +467,94 @@ ScopeList createGlobalScope (void) {
 }
 
 ScopeList createLocalScope (char* name, ScopeList parent) {
-  ScopeList scope = createScope();
+  ScopeList scope = createScope(parent);
   scope->name = name;
-  scope->parent = parent;
+  scope->function = parent->function;
 
   return scope;
 }
 
+void releaseLocalScopes (void) {
+  arenaReset(&localArena);
+}
 
-BucketList lookupFunctionOnGlobalWithLocation (ScopeList scope, char *name, int location) {
-  while (scope->parent != NULL) {
-    scope = scope->parent;
+
+/* findSymbol returns the first symbol of scope named
+   name whose kind is in kindFlag */
+static BucketList findSymbol (ScopeList scope, char *name, int kindFlag) {
+  if (scope->capacity == 0) {
+    for (int k = 0; k < scope->symbolCount; k++) {
+      BucketList b = scope->small[k];
+
+      if (b->name == name && (b->kind & kindFlag) != 0) {
+        return b;
+      }
+    }
+    return NULL;
   }
 
-  int h = hash(name);
-  BucketList b = scope->bucket[h][0];
+  unsigned long long h = nameHash(name);
+  unsigned char tag = SLOT_TAG(h);
+  unsigned int mask = scope->capacity - 1;
+  unsigned int i;
+
+  for (i = h & mask; scope->ctrl[i] != EMPTY_SLOT; i = (i + 1) & mask) {
+    BucketList b = scope->slots[i].symbol;
 
-  while (b != NULL) {
-    if (b->memloc == location) {
-      break;
+    // control byte와 캐시된 hash가 맞을 때만 심볼을 읽음
+    if (scope->ctrl[i] == tag && scope->slots[i].hash == h
+      && b->name == name && (b->kind & kindFlag) != 0) {
+      return b;
     }
-    
-    b = b->next;
   }
-  
-  return b;
+
+  return NULL;
 }
 
-BucketList lookupScope (ScopeList scope, char *name, int kindFlag) {
-  int h = hash(name);
-  BucketList b = scope->bucket[h][0];
+/* findVisible is findSymbol, hiding the symbols of
+   the frozen scope declared after its limit; the
+   first match has the lowest memloc of its name */
+static BucketList findVisible (ScopeList scope, char *name, int kindFlag) {
+  BucketList b = findSymbol(scope, name, kindFlag);
 
-  while (b != NULL) {
-    if (strcmp(name, b->name) == 0 && (b->kind & kindFlag) != 0) {
-      break;
-    }
-    
-    b = b->next;
+  if (b != NULL && scope == frozenScope && b->memloc > frozenLimit) {
+    return NULL;
   }
-  
   return b;
 }
 
+BucketList lookupScope (ScopeList scope, char *name, int kindFlag) {
+  return findVisible(scope, name, kindFlag);
+}
+
+void freezeScope (ScopeList scope, int limit) {
+  frozenScope = scope;
+  frozenLimit = limit;
+}
+
 BucketList lookupScopeRecursive (ScopeList scope, char *name, int kindFlag) {
+  if (scope != NULL && scope == activeScope && bindCapacity > 0) {
+    // 들어가 있는 scope: shadow stack을 위에서부터 보고 kind가 맞는 첫 binding의 scope에서 멈춤
+    // 같은 scope 안에서는 먼저 선언된 심볼이 우선 (lookupScope와 같은 순서)
+    BucketList found = NULL;
+
+    for (BucketList b = probeBinding(name)->top; b != NULL; b = b->shadowed) {
+      if (found != NULL && b->scope != found->scope) {
+        break;
+      }
+      if ((b->kind & kindFlag) != 0 && (found == NULL || b->memloc < found->memloc)) {
+        found = b;
+      }
+    }
+
+    // frozen scope는 bind되지 않으므로, 못 찾았으면 그 scope를 직접 찾음
+    if (found == NULL && frozenScope != NULL) {
+      found = findVisible(frozenScope, name, kindFlag);
+    }
+
+    return found;
+  }
+
   while (scope != NULL) {
     BucketList b = lookupScope(scope, name, kindFlag);
 
@@ -173,7 +564,16 @@ BucketList lookupScopeRecursive (ScopeList scope, char *name, int kindFlag) {
 
     scope = scope->parent;
   }
-  
+
+  return NULL;
+}
+
+int isGlobal (BucketList symbol) {
+  return symbol->scope->parent == NULL;
+}
+
+int isBuiltin (BucketList symbol, const char *name) {
+  return isGlobal(symbol) && strcmp(symbol->name, name) == 0;
 }
 
 /* Procedure st_insert inserts line numbers and
@@ -182,43 +582,40 @@ BucketList lookupScopeRecursive (ScopeList scope, char *name, int kindFlag) {
  * first time, otherwise ignored
  */
 BucketList insertSymbol(ScopeList scope, char* name, SymbolKind kind, ExpType type, int lineno) {
-  BucketList l = createBucket(name, lineno);
+  BucketList l = createBucket(scope, name, lineno);
 
-    l->memloc = scope->locationCount++;
-    l->kind = kind;
+  l->memloc = scope->locationCount++;
+  l->kind = kind;
 
-    if (kind == VarSymbol) {
-      l->type.varType = type;
-    } else {
-      l->type.funType.returnType = type;
-      l->type.funType.params = NULL;
-    }
+  if (kind == VarSymbol) {
+    l->type.varType = type;
+  } else {
+    l->type.funType.returnType = type;
+    clearParameters(l);
+  }
 
-    insertBucket(scope, l);
+  insertBucket(scope, l);
 
-    return l;
-}
+  if (scope == activeScope) {
+    bindSymbol(l);
+  }
 
-void addReference(ScopeList scope, char* name, SymbolKind kind, int lineno) {
-  // TODO: 
+  return l;
 }
 
+int functionSignature (BucketList func) {
+  struct FunctionType *f = &func->type.funType;
+
+  if (f->signature == NO_SIGNATURE) {
+    f->signature = internSignature(f->returnType, f->params, f->paramCount);
+  }
+  return f->signature;
+}
 
 void addParameterType (ScopeList scope, ExpType type) {
-  BucketList func = lookupFunctionOnGlobalWithLocation(scope, scope->name, scope->funcSymbolLocOnGlobal);
-  assert(func != NULL);
-  
-  ParameterList iter = func->type.funType.params;
-  
-  if (iter == NULL) {
-    func->type.funType.params = createParameter(type);
-  } else {
-    while (iter->next != NULL) {
-      iter = iter->next;
-    }
+  assert(scope->function != NULL);
 
-    iter->next = createParameter(type);
-  }
+  appendParameter(scope->function, type);
 }
 
 
@@ -227,21 +624,16 @@ void addParameterType (ScopeList scope, ExpType type) {
  * to the listing file
  */
 void printScope(FILE * listing, ScopeList scope)
-{ int i;
+{
 
   fprintf(listing, "Scope: %s\n", scope->name ? scope->name : "");
   fprintf(listing,"Symbol Name    Location  Type        Line Numbers\n");
   fprintf(listing,"-------------  --------  ---------   ------------\n");
 
-  for (i=0;i<HASH_TABLE_SIZE;++i) {
-    if (scope->bucket[i][0] == NULL) {
-      continue;
-    }
-
-    BucketList l = scope->bucket[i][0];
+  {
+    BucketList l = scope->first;
 
     while (l != NULL) {
-      LineList t = l->lines;
       fprintf(listing,"%-14s ",l->name);
       fprintf(listing,"%-8d  ",l->memloc);
       {
@@ -267,23 +659,18 @@ void printScope(FILE * listing, ScopeList scope)
           fprintf(listing,"%-9s", typeString);
         }
       }
-      while (t != NULL)
-      { fprintf(listing,"%4d ",t->lineno);
-        t = t->next;
-      }
+      printLines(listing, l);
       fprintf(listing,"\n");
 
 
       if (l->kind == FuncSymbol) {
-        ParameterList p = l->type.funType.params;
+        struct FunctionType *f = &l->type.funType;
         fprintf(listing, "params: ");
-        if (p == NULL) {
+        if (f->paramCount == 0) {
           fprintf(listing, "void\n");
         } else {
-          ExpType type;
-
-          while (p != NULL) {
-            ExpType type = p->type;
+          for (int k = 0; k < f->paramCount; k++) {
+            ExpType type = f->params[k];
             const char* typeString = NULL;
 
                     switch (type) {
@@ -294,7 +681,6 @@ void printScope(FILE * listing, ScopeList scope)
         }
 
                 fprintf(listing, "%s, ", typeString);
-            p = p->next;
           }
           fprintf(listing, "\n");
 
@@ -305,3 +691,44 @@ void printScope(FILE * listing, ScopeList scope)
   }
   
 } /* printSymTab */
+
+
+/* totals of the symbols listed by printXref on
+   this thread */
+static _Thread_local long xrefLines = 0;
+static _Thread_local long xrefChunks = 0;
+static _Thread_local long xrefBytes = 0;
+
+/* Procedure printXref prints the cross-reference
+ * listing of the symbols of scope
+ */
+void printXref(FILE * listing, ScopeList scope)
+{ BucketList l;
+  LineChunk chunk;
+
+  fprintf(listing, "Scope: %s\n", scope->name ? scope->name : "");
+  fprintf(listing,"Symbol Name    Kind  Lines  Line Numbers\n");
+  fprintf(listing,"-------------  ----  -----  ------------\n");
+
+  for (l = scope->first; l != NULL; l = l->next)
+  { fprintf(listing,"%-14s ",l->name);
+    fprintf(listing,"%-4s  ",l->kind == FuncSymbol ? "func" : "var");
+    fprintf(listing,"%5d  ",l->lines.count);
+    printLines(listing, l);
+    fprintf(listing,"\n");
+    xrefLines += l->lines.count;
+    for (chunk = l->lines.first; chunk != NULL; chunk = chunk->next)
+    { xrefChunks++;
+      xrefBytes += sizeof(struct LineChunkRec) + chunk->size;
+    }
+  }
+  fprintf(listing,"\n");
+} /* printXref */
+
+/* Procedure printXrefStats prints the totals
+ * of the line indexes listed by printXref
+ */
+void printXrefStats(FILE * listing)
+{ fprintf(listing, "Line index: %ld lines in %ld chunks, %ld bytes\n",
+          xrefLines, xrefChunks, xrefBytes);
+}
@@ -10,47 +10,79 @@
 #define _SYMTAB_H_
 
 
-#define HASH_TABLE_SIZE 211
-
 typedef enum { FuncSymbol = 1, VarSymbol = 2 } SymbolKind;
 
-const int ONLY_FUNC_SYMBOL;
-const int ONLY_VAR_SYMBOL;
-const int ALL_SYMBOL;
-
-typedef struct LineListRec
-   { int lineno;
-     struct LineListRec * next;
-   } * LineList;
-
-
-typedef struct Parameter {
-  ExpType type;
-  struct Parameter* next;
-} * ParameterList;
+extern const int ONLY_FUNC_SYMBOL;
+extern const int ONLY_VAR_SYMBOL;
+extern const int ALL_SYMBOL;
+
+/* LineChunk is one block of the line index of a
+   symbol: each line is stored as the zigzag varint
+   of its difference from the line before it */
+typedef struct LineChunkRec
+   { struct LineChunkRec * next;
+     unsigned short size; /* bytes in data */
+     unsigned short used;
+     unsigned char data[];
+   } * LineChunk;
+
+/* LineIndex lists the distinct lines a symbol is
+   declared and referenced on, in the order seen */
+typedef struct LineIndex
+   { LineChunk first, last;
+     int lastLine; /* base of the next delta */
+     int count;    /* lines recorded */
+   } LineIndex;
 
 
 typedef struct FunctionType {
   ExpType returnType;
-  ParameterList params;
+  ExpType *params; // parameter types in declaration order
+  int paramCount; // tail index: where the next parameter goes
+  int paramCapacity;
+  int signature; // interned (returnType, params) id, see functionSignature
 } ;
 
 typedef struct BucketListRec
-   { char * name;
-     LineList lines;
+   { char * name; /* interned, see intern.h */
+     LineIndex lines;
      int memloc ; /* memory location for variable */
-     struct BucketListRec * next;
+     int address; /* cgen: word offset from gp or fp, or entry label of a function */
+     struct BucketListRec * next; /* next symbol of the same scope */
+     ScopeList scope; /* scope the symbol is declared in */
+     struct BucketListRec * shadowed; /* next binding of the same name, see enterScope */
      SymbolKind kind;
      union { ExpType varType; struct FunctionType funType; } type;
    } * BucketList;
 
 
+/* SymbolSlot is one slot of the open-addressing
+   index of a scope: the cached 64-bit name hash
+   and the symbol stored there */
+typedef struct SymbolSlot {
+  unsigned long long hash;
+  BucketList symbol;
+} SymbolSlot;
+
+
+/* SMALL_SCOPE = symbols a scope holds in its inline
+   array before it builds a hash index; 0 indexes
+   every scope from its first symbol */
+#ifndef SMALL_SCOPE
+#define SMALL_SCOPE 4
+#endif
+
 typedef struct ScopeListRec {
   char *name;
-  BucketList bucket[HASH_TABLE_SIZE][2]; // [0] is first, [1] is last
+  int symbolCount;
+  BucketList small[SMALL_SCOPE > 0 ? SMALL_SCOPE : 1]; // searched linearly until the index exists
+  unsigned char *ctrl; // per-slot metadata: empty, or 7 bits of the hash
+  SymbolSlot *slots; // linear probing, power-of-two capacity (0 while small)
+  int capacity;
+  BucketList first, last; // symbols in insertion order, linked by next
   struct ScopeListRec *parent; // for symbol table hierarchy
   int locationCount;
-  int funcSymbolLocOnGlobal;
+  BucketList function; // function symbol the scope belongs to, NULL for global
 } * ScopeList;
 
 
@@ -71,6 +103,14 @@ ScopeList createGlobalScope (void);
  */
 ScopeList createLocalScope (char* name, ScopeList parent);
 
+
+/**
+ * @brief 현재 스레드에서 만든 local scope들과 그 심볼들을 한 번에 해제합니다.
+ * global scope와 그 심볼, 파라미터, line index는 남습니다.
+ * 해제된 scope를 가리키는 노드(TreeNode.scope, symbol)가 더 이상 쓰이지 않을 때만 호출합니다.
+ */
+void releaseLocalScopes (void);
+
 /* Procedure st_insert inserts line numbers and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
@@ -79,21 +119,85 @@ ScopeList createLocalScope (char* name, ScopeList parent);
 BucketList insertSymbol(ScopeList scope, char* name, SymbolKind kind, ExpType type, int lineno);
 
 
+/**
+ * @brief symbol이 lineno에서 참조되었음을 line index에 O(1)로 추가합니다.
+ * 직전에 추가된 줄과 같은 줄이면 다시 저장하지 않습니다.
+ *
+ * @param symbol 
+ * @param lineno 
+ */
+void addReference (BucketList symbol, int lineno);
+
+
+/**
+ * @brief scope가 속한 함수 심볼(scope->function)의 파라미터 목록 끝에 type을 추가합니다.
+ *
+ * @param scope 
+ * @param type 
+ */
 void addParameterType (ScopeList scope, ExpType type);
 
 
+/**
+ * @brief 함수 심볼 func의 (반환 타입, 파라미터 타입) 시그니처 id를 반환합니다 (sigtab.h).
+ * 처음 호출될 때 intern하고, 파라미터가 추가되면 다시 계산합니다.
+ * 분석기는 선언의 파라미터가 모두 등록된 뒤에 한 번 호출하고, 호출 검사에서는 부르지 않습니다.
+ *
+ * @param func FuncSymbol
+ * @return int 
+ */
+int functionSignature (BucketList func);
+
 /**
  * @brief 주어진 scope에서만 주어진 kindFlag, name에 해당하는 symbol을 lookup합니다.
  * 
  * @param scope 
- * @param name 
+ * @param name interned 이름 (포인터로 비교합니다)
  * @return BucketList 없는 경우 NULL을 반환합니다.
  */
 BucketList lookupScope (ScopeList scope, char *name, int kindFlag);
 
 BucketList lookupScopeRecursive (ScopeList scope, char *name, int kindFlag);
 
-BucketList lookupFunctionOnGlobalWithLocation (ScopeList scope, char *name, int location);
+/* Function isGlobal returns TRUE if symbol is
+ * declared in the global scope
+ */
+int isGlobal (BucketList symbol);
+
+/* Function isBuiltin returns TRUE if the function
+ * symbol is the built-in function named name
+ */
+int isBuiltin (BucketList symbol, const char *name);
+
+/**
+ * @brief 현재 스레드에서 scope를 읽기 전용으로 보고, memloc이 limit 이하인 심볼만 보이게 합니다.
+ * scope는 enterScope하지 않아도 lookup의 마지막 단계에서 찾습니다. 병렬 분석에서
+ * 함수 본문을 검사하는 스레드가 그 함수까지 선언된 global scope만 보도록 씁니다.
+ * NULL을 넘기면 해제합니다.
+ *
+ * @param scope 
+ * @param limit 보이는 마지막 심볼의 memloc
+ */
+void freezeScope (ScopeList scope, int limit);
+
+/**
+ * @brief scope에 들어갑니다. scope의 심볼들을 이름별 shadow stack 위에 올리고,
+ * 이후 이 scope에 insert되는 심볼도 바로 올립니다. 이 scope에 대한
+ * lookupScopeRecursive는 중첩 깊이와 상관없이 이름 테이블을 한 번만 probe합니다.
+ * scope는 parent 순서대로 중첩해서 들어가고 나와야 합니다. 이름 테이블은 스레드마다 하나이므로,
+ * 한 스레드에서는 global scope를 나오기 전에 다른 global scope에 들어갈 수 없습니다 (assert).
+ *
+ * @param scope 
+ */
+void enterScope (ScopeList scope);
+
+/**
+ * @brief enterScope로 들어간 scope에서 나옵니다. scope의 심볼들을 shadow stack에서 내리고,
+ * parent scope가 다시 가장 안쪽 scope가 됩니다.
+ *
+ * @param scope 
+ */
+void leaveScope (ScopeList scope);
 
 /* Procedure printSymTab prints a formatted 
  * listing of the symbol table contents 
@@ -101,4 +205,16 @@ BucketList lookupFunctionOnGlobalWithLocation (ScopeList scope, char *name, int
  */
 void printScope(FILE * listing, ScopeList scope);
 
+/* Procedure printXref prints the cross-reference
+ * listing of the symbols of scope: every line each
+ * one is declared or referenced on
+ */
+void printXref(FILE * listing, ScopeList scope);
+
+/* Procedure printXrefStats prints the number of
+ * lines and the memory of the line indexes listed
+ * by printXref
+ */
+void printXrefStats(FILE * listing);
+
 #endif
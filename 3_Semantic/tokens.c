@@ -0,0 +1,286 @@
+/****************************************************/
+/* File: tokens.c                                   */
+/* Token array and token cursor shared by the       */
+/* hand-written and the flex C-Minus scanners       */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "srcbuf.h"
+#include "skip.h"
+
+/* INITTOKENS = initial capacity of the token array */
+#define INITTOKENS 4096
+
+/* MAXVARINT = most bytes a packed line delta takes */
+#define MAXVARINT 5
+
+/* TOKENBATCH = tokens scanned at a time; the token
+   array never holds more than one batch */
+#define TOKENBATCH 65536
+
+/* lexeme of the current token */
+char tokenString[MAXTOKENLEN + 1];
+
+static SourceBuffer srcBuf; /* whole text of the source file */
+static TokenArray tokens;   /* token stream of srcBuf */
+static int current = -1;    /* index of the token last returned */
+static int linePos = 0;     /* packed line of the next token */
+static int currentLine = 0; /* line of the token last returned */
+static int scanDone = FALSE; /* TRUE once ENDFILE is in tokens */
+static int inBody = FALSE;   /* TRUE once scanBody has been called */
+
+/* echo position for EchoSource: the next line
+   to be listed and its line number */
+static const char *echoPos = NULL;
+static int echoLine = 0;
+
+/* growArray reallocates one of the token arrays */
+static void *growArray(void *array, int capacity, size_t elemSize)
+{
+  void *grown = realloc(array, capacity * elemSize);
+  if (grown == NULL)
+  {
+    fprintf(listing, "Out of memory error at line %d\n", lineno);
+    exit(1);
+  }
+  return grown;
+}
+
+/* packLine appends line as the varint of its
+   difference from the line of the last token */
+static void packLine(TokenArray *tokens, int line)
+{
+  unsigned int delta = (unsigned int)(line - tokens->lastLine);
+  if (tokens->lineCapacity - tokens->lineBytes < MAXVARINT)
+  {
+    tokens->lineCapacity = (tokens->lineCapacity == 0) ? INITTOKENS : tokens->lineCapacity * 2;
+    tokens->lines = growArray(tokens->lines, tokens->lineCapacity, 1);
+  }
+  while (delta >= 0x80)
+  {
+    tokens->lines[tokens->lineBytes++] = (unsigned char)(delta | 0x80);
+    delta >>= 7;
+  }
+  tokens->lines[tokens->lineBytes++] = (unsigned char)delta;
+  tokens->lastLine = line;
+}
+
+/* unpackLine returns the line of the token whose
+   packed delta starts at *pos, given the line of
+   the token before it, and moves *pos past it */
+static int unpackLine(const TokenArray *tokens, int *pos, int line)
+{
+  unsigned int delta = 0;
+  int shift = 0;
+  unsigned char byte;
+  do
+  {
+    byte = tokens->lines[(*pos)++];
+    delta |= (unsigned int)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return (int)((unsigned int)line + delta);
+}
+
+/* clearTokens empties tokens and the cursor over
+   them */
+static void clearTokens(void)
+{
+  tokens.count = 0;
+  tokens.lineBytes = 0;
+  tokens.lastLine = 0;
+  linePos = 0;
+  currentLine = 0;
+}
+
+/* Procedure appendToken adds one token to the end
+ * of tokens, growing the arrays when needed
+ */
+void appendToken(TokenArray *tokens, TokenType kind, int lineno,
+                 unsigned int offset, unsigned int length)
+{
+  int i = tokens->count;
+  if (i == tokens->capacity)
+  {
+    tokens->capacity = (i == 0) ? INITTOKENS : i * 2;
+    tokens->kind = growArray(tokens->kind, tokens->capacity, sizeof(unsigned short));
+    tokens->offset = growArray(tokens->offset, tokens->capacity, sizeof(unsigned int));
+    tokens->length = growArray(tokens->length, tokens->capacity, sizeof(unsigned int));
+  }
+  tokens->kind[i] = (unsigned short)kind;
+  packLine(tokens, lineno);
+  tokens->offset[i] = offset;
+  tokens->length[i] = length;
+  tokens->count++;
+}
+
+/* echoThrough lists every source line up to
+   and including line number last */
+static void echoThrough(int last)
+{
+  const char *end = srcBuf.text + srcBuf.size;
+  while (echoLine < last && echoPos < end)
+  {
+    const char *eol = memchr(echoPos, '\n', end - echoPos);
+    eol = (eol == NULL) ? end : eol + 1;
+    echoLine++;
+    fprintf(listing, "%4d: %.*s", echoLine, (int)(eol - echoPos), echoPos);
+    echoPos = eol;
+  }
+}
+
+/* nextBatch replaces the tokens already returned
+   with the next batch of the source. When streaming,
+   the source text before the new batch is no longer
+   needed (lexemes are interned as they are parsed),
+   so its pages are given back */
+static void nextBatch(void)
+{
+  if (Streaming && srcBuf.mapped && tokens.count > 0)
+  {
+    const char *keep = srcBuf.text + tokens.offset[tokens.count - 1];
+    if (EchoSource && echoPos < keep)
+      keep = echoPos;
+    releaseSourceBefore(&srcBuf, keep);
+  }
+  clearTokens();
+  /* with lazy bodies a batch ends at each "{" of
+     the top level, since skipBlock may drop the
+     tokens after it */
+  scanDone = scanTokens(&tokens, TOKENBATCH,
+                        LazyBodies && !inBody ? LCURLY : ENDFILE);
+  current = 0;
+  currentLine = unpackLine(&tokens, &linePos, currentLine);
+}
+
+/* restartAt makes the tokens of the current scan
+   range come next, dropping those still buffered */
+static void restartAt(void)
+{
+  clearTokens();
+  current = -1;
+  scanDone = FALSE;
+}
+
+/* advance moves current to the next token,
+   loading the source on the first call */
+static void advance(void)
+{
+  if (srcBuf.text == NULL)
+  {
+    if (!loadSource(&srcBuf, source))
+    {
+      fprintf(listing, "Unable to read source file\n");
+      exit(1);
+    }
+    startScan(srcBuf.text, srcBuf.size);
+    echoPos = srcBuf.text;
+  }
+  /* stay on ENDFILE once it has been reached */
+  if (current < tokens.count - 1)
+  {
+    current++;
+    currentLine = unpackLine(&tokens, &linePos, currentLine);
+  }
+  else if (!scanDone)
+    nextBatch();
+}
+
+/* function getToken returns the
+ * next token in source file
+ */
+TokenType getToken(void)
+{
+  TokenType currentToken;
+  advance();
+  currentToken = tokens.kind[current];
+  lineno = currentLine;
+  if (EchoSource)
+    echoThrough(lineno);
+  if (TraceScan)
+  {
+    fprintf(listing, "\t%d: ", lineno);
+    printToken(currentToken, currentTokenString());
+  }
+  return currentToken;
+}
+
+/* Procedure skipBlock records in body the block
+ * opened by the "{" last returned by getToken and
+ * moves the scan past its "}" without tokenizing
+ * it. Returns FALSE, leaving the scan where it
+ * is, if the block is not closed
+ */
+int skipBlock(LazyBody *body)
+{
+  const char *text = srcBuf.text;
+  const char *close;
+  body->offset = tokens.offset[current];
+  body->lineno = currentLine;
+  close = findBlockEnd(text + body->offset + 1, text + srcBuf.size);
+  if (close == NULL)
+    return FALSE;
+  body->end = (unsigned int)(close - text);
+  lineno = body->lineno + countNewlines(text + body->offset, text + body->end);
+  scanRange(body->end, srcBuf.size, lineno);
+  restartAt();
+  return TRUE;
+}
+
+/* Procedure scanBody makes the tokens of a block
+ * recorded by skipBlock, followed by ENDFILE, the
+ * next ones returned by getToken
+ */
+void scanBody(const LazyBody *body)
+{
+  inBody = TRUE;
+  scanRange(body->offset, body->end, body->lineno);
+  restartAt();
+}
+
+/* Procedure restartScan releases the source text
+ * read so far, so that the next getToken starts
+ * over on source; trees parsed before must not
+ * have lazy bodies left to parse
+ */
+void restartScan(void)
+{
+  if (srcBuf.text != NULL)
+    releaseSource(&srcBuf);
+  restartAt();
+  inBody = FALSE;
+  echoPos = NULL;
+  echoLine = 0;
+}
+
+/* Function currentTokenString copies the lexeme of
+ * the token last returned by getToken into
+ * tokenString and returns it
+ */
+char *currentTokenString(void)
+{
+  unsigned int n = 0;
+  if (current >= 0)
+  {
+    n = tokens.length[current];
+    if (n > MAXTOKENLEN)
+      n = MAXTOKENLEN;
+    memcpy(tokenString, srcBuf.text + tokens.offset[current], n);
+  }
+  tokenString[n] = '\0';
+  return tokenString;
+}
+
+/* Function currentLexeme returns the lexeme of the
+ * token last returned by getToken as a slice of
+ * the source text
+ */
+Lexeme currentLexeme(void)
+{
+  Lexeme l;
+  l.text = srcBuf.text + tokens.offset[current];
+  l.len = tokens.length[current];
+  return l;
+}
@@ -8,11 +8,33 @@
 
 #include "globals.h"
 #include "util.h"
+#include "arena.h"
+#include "visit.h"
 
-/* Procedure printToken prints a token
- * and its lexeme to the listing file
+/* every syntax tree node of the compilation
+ * unit is carved out of treeArena
  */
-void printToken(TokenType token, const char *tokenString)
+static Arena treeArena;
+
+/* number of live nodes of each NodeKind */
+static int nodeCount[ListK + 1];
+
+/* allocNode returns a zeroed node from treeArena */
+static TreeNode *allocNode(NodeKind kind)
+{
+  TreeNode *t = arenaAlloc(&treeArena, sizeof(TreeNode));
+  if (t != NULL)
+  {
+    memset(t, 0, sizeof(TreeNode));
+    nodeCount[kind]++;
+  }
+  return t;
+}
+
+/* Procedure fprintToken prints a token
+ * and its lexeme to out
+ */
+void fprintToken(FILE *out, TokenType token, const char *tokenString)
 {
   switch (token)
   {
@@ -22,92 +44,103 @@ void printToken(TokenType token, const char *tokenString)
   case RETURN:
   case INT:
   case VOID:
-    fprintf(listing,
+    fprintf(out,
             "reserved word: %s\n", tokenString);
     break;
   case ASSIGN:
-    fprintf(listing, "=\n");
+    fprintf(out, "=\n");
     break;
   case EQ:
-    fprintf(listing, "==\n");
+    fprintf(out, "==\n");
     break;
   case NE:
-    fprintf(listing, "!=\n");
+    fprintf(out, "!=\n");
     break;
   case LT:
-    fprintf(listing, "<\n");
+    fprintf(out, "<\n");
     break;
   case LE:
-    fprintf(listing, "<=\n");
+    fprintf(out, "<=\n");
     break;
   case GT:
-    fprintf(listing, ">\n");
+    fprintf(out, ">\n");
     break;
   case GE:
-    fprintf(listing, ">=\n");
+    fprintf(out, ">=\n");
     break;
   case PLUS:
-    fprintf(listing, "+\n");
+    fprintf(out, "+\n");
     break;
   case MINUS:
-    fprintf(listing, "-\n");
+    fprintf(out, "-\n");
     break;
   case TIMES:
-    fprintf(listing, "*\n");
+    fprintf(out, "*\n");
     break;
   case OVER:
-    fprintf(listing, "/\n");
+    fprintf(out, "/\n");
     break;
   case LPAREN:
-    fprintf(listing, "(\n");
+    fprintf(out, "(\n");
     break;
   case RPAREN:
-    fprintf(listing, ")\n");
+    fprintf(out, ")\n");
     break;
   case LBRACE:
-    fprintf(listing, "[\n");
+    fprintf(out, "[\n");
     break;
   case RBRACE:
-    fprintf(listing, "]\n");
+    fprintf(out, "]\n");
     break;
   case LCURLY:
-    fprintf(listing, "{\n");
+    fprintf(out, "{\n");
     break;
   case RCURLY:
-    fprintf(listing, "}\n");
+    fprintf(out, "}\n");
     break;
   case SEMI:
-    fprintf(listing, ";\n");
+    fprintf(out, ";\n");
     break;
   case COMMA:
-    fprintf(listing, ",\n");
+    fprintf(out, ",\n");
     break;
   case ENDFILE:
-    fprintf(listing, "EOF\n");
+    fprintf(out, "EOF\n");
     break;
   case NUM:
-    fprintf(listing,
+    fprintf(out,
             "NUM, val= %s\n", tokenString);
     break;
   case ID:
-    fprintf(listing,
+    fprintf(out,
             "ID, name= %s\n", tokenString);
     break;
   case ERROR:
-    fprintf(listing,
+    fprintf(out,
             "ERROR: %s\n", tokenString);
     break;
+  case LAZY_BODY: /* a whole block, see skipBlock */
+    fprintf(out, "{\n");
+    break;
   default: /* should never happen */
-    fprintf(listing, "Unknown token: %d\n", token);
+    fprintf(out, "Unknown token: %d\n", token);
   }
 }
 
+/* Procedure printToken prints a token
+ * and its lexeme to the listing file
+ */
+void printToken(TokenType token, const char *tokenString)
+{
+  fprintToken(listing, token, tokenString);
+}
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
 TreeNode *newStmtNode(StmtKind kind)
 {
-  TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
+  TreeNode *t = allocNode(StmtK);
   int i;
   if (t == NULL)
     fprintf(listing, "Out of memory error at line %d\n", lineno);
@@ -124,12 +157,33 @@ TreeNode *newStmtNode(StmtKind kind)
   return t;
 }
 
+/* Function newLazyBodyNode creates the CompoundK
+ * node standing for a function body that has not
+ * been parsed yet (see parseBody)
+ */
+TreeNode *newLazyBodyNode(const LazyBody *body)
+{
+  TreeNode *t = newStmtNode(CompoundK);
+  if (t != NULL)
+  {
+    t->attr.lazy = arenaAlloc(&treeArena, sizeof(LazyBody));
+    if (t->attr.lazy == NULL)
+    {
+      fprintf(listing, "Out of memory error at line %d\n", lineno);
+      return t;
+    }
+    *t->attr.lazy = *body;
+    t->lineno = body->lineno;
+  }
+  return t;
+}
+
 /* Function newExpNode creates a new expression
  * node for syntax tree construction
  */
 TreeNode *newExpNode(ExpKind kind)
 {
-  TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
+  TreeNode *t = allocNode(ExpK);
   int i;
   if (t == NULL)
     fprintf(listing, "Out of memory error at line %d\n", lineno);
@@ -149,7 +203,7 @@ TreeNode *newExpNode(ExpKind kind)
 
 
 TreeNode *newDeclNode(DeclKind kind) {
-  TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
+  TreeNode *t = allocNode(DeclK);
   int i;
 
   if (t == NULL) {
@@ -172,7 +226,7 @@ TreeNode *newDeclNode(DeclKind kind) {
 
 
 TreeNode *newListNode(ListKind kind) {
-  TreeNode *t = (TreeNode *)malloc(sizeof(TreeNode));
+  TreeNode *t = allocNode(ListK);
   int i;
 
   if (t == NULL) {
@@ -210,6 +264,41 @@ char *copyString(char *s)
   return t;
 }
 
+/* Procedure freeTrees releases every syntax tree
+ * node allocated so far in one step
+ */
+void freeTrees(void)
+{
+  arenaRelease(&treeArena);
+  memset(nodeCount, 0, sizeof(nodeCount));
+}
+
+/* Procedure resetTrees releases every syntax tree
+ * node allocated so far, keeping the memory for
+ * the nodes allocated next
+ */
+void resetTrees(void)
+{
+  arenaReset(&treeArena);
+  memset(nodeCount, 0, sizeof(nodeCount));
+}
+
+/* Procedure printTreeStats prints the number of
+ * syntax tree nodes of each kind and the memory
+ * they occupy to the listing file
+ */
+void printTreeStats(void)
+{
+  fprintf(listing, "\nSyntax tree allocation:\n");
+  fprintf(listing, "  Statement nodes:   %d\n", nodeCount[StmtK]);
+  fprintf(listing, "  Expression nodes:  %d\n", nodeCount[ExpK]);
+  fprintf(listing, "  Declaration nodes: %d\n", nodeCount[DeclK]);
+  fprintf(listing, "  List nodes:        %d\n", nodeCount[ListK]);
+  fprintf(listing, "  %lu bytes used of %lu reserved in %d chunks\n",
+          (unsigned long)treeArena.bytes, (unsigned long)treeArena.reserved,
+          treeArena.chunkCount);
+}
+
 /* Variable indentno is used by printTree to
  * store current number of spaces to indent
  */
@@ -247,115 +336,142 @@ static void printTypes(ExpType t) {
   }
 }
 
-/* procedure printTree prints a syntax tree to the
- * listing file using indentation to indicate subtrees
+/* Procedure printNodeLabel prints the line that
+ * describes one node, without its children.
+ * attr is the op, val or has_else field, name the
+ * name field, and hasValue tells whether a RetK
+ * node returns an expression
  */
-void printTree(TreeNode *tree)
+void printNodeLabel(NodeKind nodekind, int kind, int attr,
+                    char *name, ExpType type, int hasValue)
 {
-  int i;
-  int indented;
-
-  indented = FALSE;
-  if (tree != NULL && tree->nodekind != ListK) {
-    INDENT;
-    indented = TRUE;
-  }
-  
-  while (tree != NULL)
+  if (nodekind == StmtK)
   {
-    if (tree->nodekind != ListK
-      && !(tree->nodekind == StmtK && tree->kind.stmt == NopK)
-    ) {
-      printSpaces();
+    switch (kind)
+    {
+    case CompoundK:
+      fprintf(listing, "Compound Statement:\n");
+      break;
+    case SelectK:
+      if (attr == TRUE) {
+        fprintf(listing, "If-Else Statement:\n");
+      } else {
+        fprintf(listing, "If Statement:\n");
+      }
+      break;
+    case IterK:
+      fprintf(listing, "While Statement:\n");
+      break;
+    case RetK:
+      if (!hasValue) {
+        fprintf(listing, "Non-value Return Statement\n");
+      } else {
+        fprintf(listing, "Return Statement:\n");
+      }
+      break;
+    case NopK:
+      // Print nothing!
+      break;
+    default:
+      fprintf(listing, "Unknown ExpNode kind\n");
+      break;
     }
-
-    if (tree->nodekind == StmtK)
+  } else if (nodekind == ExpK) {
+    switch (kind)
     {
-      switch (tree->kind.stmt)
-      {
-      case CompoundK:
-        fprintf(listing, "Compound Statement:\n");
-        break;
-      case SelectK:
-        if (tree->attr.has_else == TRUE) {
-          fprintf(listing, "If-Else Statement:\n");
-        } else {
-          fprintf(listing, "If Statement:\n");
-        }
+    case AssignK:
+      fprintf(listing, "Assign:\n");
+      break;
+    case BinaryOpK:
+      fprintf(listing, "Op: ");
+      printToken(attr, "\0");
+      break;
+    case ConstK:
+      fprintf(listing, "Const: %d\n", attr);
+      break;
+    case IdK:
+      fprintf(listing, "Variable: name = %s\n", name);
+      break;
+    case CallK:
+      fprintf(listing, "Call: function name = %s\n", name);
+      break;
+    default:
+      fprintf(listing, "Unknown ExpNode kind\n");
+      break;
+    }
+  } else if (nodekind == DeclK) {
+    switch (kind) {
+      case FunK:
+        fprintf(listing, "Function Declaration: name = %s, return type = ", name);
+        printTypes(type);
+        fprintf(listing, "\n");
         break;
-      case IterK:
-        fprintf(listing, "While Statement:\n");
+      case VarK:
+        fprintf(listing, "Variable Declaration: name = %s, type = ", name);
+        printTypes(type);
+        fprintf(listing, "\n");
         break;
-      case RetK:
-        if (tree->child[0] == NULL) {
-          fprintf(listing, "Non-value Return Statement\n");
+      case ParamK:
+        if (name != NULL) {
+          fprintf(listing, "Parameter: name = %s, type = ", name);
+          printTypes(type);
+          fprintf(listing, "\n");
         } else {
-          fprintf(listing, "Return Statement:\n");
+          fprintf(listing, "Void Parameter\n");
         }
+
         break;
-      case NopK:
-        // Print nothing!
-        break;
-      default:
-        fprintf(listing, "Unknown ExpNode kind\n");
-        break;
-      }
-    } else if (tree->nodekind == ExpK) {
-      switch (tree->kind.exp)
-      {
-      case AssignK:
-        fprintf(listing, "Assign:\n");
-        break;
-      case BinaryOpK:
-        fprintf(listing, "Op: ");
-        printToken(tree->attr.op, "\0");
-        break;
-      case ConstK:
-        fprintf(listing, "Const: %d\n", tree->attr.val);
-        break;
-      case IdK:
-        fprintf(listing, "Variable: name = %s\n", tree->attr.name);
-        break;
-      case CallK:
-        fprintf(listing, "Call: function name = %s\n", tree->attr.name);
-        break;
-      default:
-        fprintf(listing, "Unknown ExpNode kind\n");
-        break;
-      }
-    } else if (tree->nodekind == DeclK) {
-      switch (tree->kind.decl) {
-        case FunK:
-          fprintf(listing, "Function Declaration: name = %s, return type = ", tree->attr.name);
-          printTypes(tree->type);
-          fprintf(listing, "\n");
-          break;
-        case VarK:
-          fprintf(listing, "Variable Declaration: name = %s, type = ", tree->attr.name);
-          printTypes(tree->type);
-          fprintf(listing, "\n");
-          break;
-        case ParamK:
-          if (tree->attr.name != NULL) {
-            fprintf(listing, "Parameter: name = %s, type = ", tree->attr.name);
-            printTypes(tree->type);
-            fprintf(listing, "\n");
-          } else {
-            fprintf(listing, "Void Parameter\n");
-          }
-
-          break;
-      }
-    } else {
-      fprintf(listing, "Unknown node kind\n");
-    }
-    for (i = 0; i < MAXCHILDREN; i++) {
-      printTree(tree->child[i]);
     }
-    tree = tree->sibling;
+  } else {
+    fprintf(listing, "Unknown node kind\n");
+  }
+}
+
+/* printNode prints one node at the current
+ * indentation, for printTree
+ */
+static void printNode(TreeNode *tree, ScopeList scope, void *context)
+{
+  int kind = tree->kind.stmt;
+  int named = tree->nodekind == DeclK
+    || (tree->nodekind == ExpK && (kind == IdK || kind == CallK));
+
+  (void)scope;
+  (void)context;
+
+  if (tree->nodekind != ListK
+    && !(tree->nodekind == StmtK && kind == NopK)
+  ) {
+    printSpaces();
   }
 
-  if (indented == TRUE) {
+  printNodeLabel(tree->nodekind, kind, named ? 0 : tree->attr.val,
+                 named ? tree->attr.name : NULL, tree->type,
+                 tree->child[0] != NULL);
+}
+
+/* sibling lists headed by a ListK node are not indented */
+static void indentList(TreeNode *head, void *context)
+{
+  (void)context;
+  if (head->nodekind != ListK) {
+    INDENT;
+  }
+}
+
+static void unindentList(TreeNode *head, void *context)
+{
+  (void)context;
+  if (head->nodekind != ListK) {
     UNINDENT;
   }
 }
+
+/* procedure printTree prints a syntax tree to the
+ * listing file using indentation to indicate subtrees
+ */
+void printTree(TreeNode *tree)
+{
+  Visitor printer = { printNode, NULL, NULL, NULL, indentList, unindentList };
+  visitTree(tree, NULL, &printer, NULL);
+}
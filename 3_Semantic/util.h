@@ -13,11 +13,22 @@
  */
 void printToken( TokenType, const char* );
 
+/* Procedure fprintToken prints a token
+ * and its lexeme to the given file
+ */
+void fprintToken( FILE *, TokenType, const char* );
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
 TreeNode * newStmtNode(StmtKind);
 
+/* Function newLazyBodyNode creates the CompoundK
+ * node standing for a function body that has not
+ * been parsed yet (see parseBody)
+ */
+TreeNode * newLazyBodyNode(const LazyBody *);
+
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
@@ -32,6 +43,32 @@ TreeNode * newListNode(ListKind);
  */
 char * copyString( char * );
 
+/* Procedure freeTrees releases every syntax tree
+ * node allocated so far in one step
+ */
+void freeTrees(void);
+
+/* Procedure resetTrees releases every syntax tree
+ * node allocated so far, keeping the memory for
+ * the nodes allocated next
+ */
+void resetTrees(void);
+
+/* Procedure printTreeStats prints the number of
+ * syntax tree nodes of each kind and the memory
+ * they occupy to the listing file
+ */
+void printTreeStats(void);
+
+/* Procedure printNodeLabel prints the line that
+ * describes one node, without its children.
+ * attr is the op, val or has_else field, name the
+ * name field, and hasValue tells whether a RetK
+ * node returns an expression
+ */
+void printNodeLabel(NodeKind nodekind, int kind, int attr,
+                    char *name, ExpType type, int hasValue);
+
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
@@ -0,0 +1,138 @@
+/****************************************************/
+/* File: visit.c                                    */
+/* Non-recursive syntax tree traversal for C-Minus  */
+/****************************************************/
+
+#include "globals.h"
+#include "visit.h"
+
+/* INITFRAMES = initial depth of the traversal stack */
+#define INITFRAMES 256
+
+/* Frame is one level of the traversal stack: the
+   node being visited, the head of its sibling list,
+   the scope it appears in, the scope its children
+   see and the next child slot to descend into
+   (-1 before preProc has run) */
+typedef struct
+{ TreeNode * t;
+  TreeNode * head;
+  ScopeList scope;
+  ScopeList inner;
+  int next;
+} Frame;
+
+/* pushFrame starts the sibling list t on top of
+   the stack, growing it when needed */
+static void pushFrame(Frame ** stack, int * top, int * capacity,
+                      TreeNode * t, ScopeList scope)
+{
+  if (*top == *capacity)
+  {
+    Frame * grown = realloc(*stack, *capacity * 2 * sizeof(Frame));
+    if (grown == NULL)
+    {
+      fprintf(listing, "Out of memory error while walking the syntax tree\n");
+      exit(1);
+    }
+    *stack = grown;
+    *capacity *= 2;
+  }
+  (*stack)[*top].t = t;
+  (*stack)[*top].head = t;
+  (*stack)[*top].scope = scope;
+  (*stack)[*top].inner = scope;
+  (*stack)[*top].next = -1;
+  (*top)++;
+}
+
+/* walk visits t and everything below it, and the
+   siblings of t as well when siblings is TRUE */
+static void walk(TreeNode * t, ScopeList scope, const Visitor * v,
+                 void * context, int siblings)
+{
+  int capacity = INITFRAMES, top = 0;
+  Frame * stack;
+
+  if (t == NULL)
+    return;
+  stack = malloc(capacity * sizeof(Frame));
+  if (stack == NULL)
+  {
+    fprintf(listing, "Out of memory error while walking the syntax tree\n");
+    exit(1);
+  }
+  if (v->enterList != NULL)
+    v->enterList(t, context);
+  pushFrame(&stack, &top, &capacity, t, scope);
+
+  while (top > 0)
+  {
+    Frame * f = &stack[top - 1];
+    TreeNode * child;
+
+    if (f->next < 0)
+    { /* first time on this node */
+      if (v->preProc != NULL)
+        v->preProc(f->t, f->scope, context);
+      if (f->t->scope != NULL)
+      {
+        f->inner = f->t->scope;
+        if (v->pushScope != NULL)
+          v->pushScope(f->inner);
+      }
+      f->next = 0;
+    }
+
+    if (f->next < MAXCHILDREN)
+    { /* descend into the next non-empty child slot */
+      child = f->t->child[f->next++];
+      if (child != NULL)
+      {
+        if (v->enterList != NULL)
+          v->enterList(child, context);
+        pushFrame(&stack, &top, &capacity, child, f->inner);
+      }
+      continue;
+    }
+
+    /* all children done: finish the node and
+       move on to its sibling in the same frame */
+    if (f->t->scope != NULL && v->popScope != NULL)
+      v->popScope(f->inner);
+    if (v->postProc != NULL)
+      v->postProc(f->t, f->scope, context);
+    if (f->t->sibling != NULL && (siblings || top > 1))
+    {
+      f->t = f->t->sibling;
+      f->inner = f->scope;
+      f->next = -1;
+    }
+    else
+    {
+      if (v->leaveList != NULL)
+        v->leaveList(f->head, context);
+      top--;
+    }
+  }
+  free(stack);
+}
+
+/* Procedure visitTree walks the sibling list t and
+ * everything below it in preorder and postorder,
+ * calling the hooks of v
+ */
+void visitTree(TreeNode * t, ScopeList scope, const Visitor * v,
+               void * context)
+{
+  walk(t, scope, v, context, TRUE);
+}
+
+/* Procedure visitNode walks t and everything below
+ * it like visitTree, leaving out the siblings of t
+ */
+void visitNode(TreeNode * t, ScopeList scope, const Visitor * v,
+               void * context)
+{
+  walk(t, scope, v, context, FALSE);
+}
@@ -0,0 +1,43 @@
+/****************************************************/
+/* File: visit.h                                    */
+/* Non-recursive syntax tree traversal for C-Minus  */
+/****************************************************/
+
+#ifndef _VISIT_H_
+#define _VISIT_H_
+
+typedef void (* VisitFun) (TreeNode *, ScopeList, void *);
+typedef void (* ScopeFun) (ScopeList);
+typedef void (* ListFun) (TreeNode *, void *);
+
+/* Visitor bundles the hooks called by visitTree;
+ * any of them may be NULL. The node and list hooks
+ * also get the context passed to visitTree
+ */
+typedef struct
+{ VisitFun preProc;   /* node, before its children; may set t->scope */
+  VisitFun postProc;  /* node, after its children */
+  ScopeFun pushScope; /* entering the scope opened by a node */
+  ScopeFun popScope;  /* leaving that scope again */
+  ListFun enterList;  /* first node of a sibling list, before preProc */
+  ListFun leaveList;  /* first node of a sibling list, after the last postProc */
+} Visitor;
+
+/* Procedure visitTree walks the sibling list t and
+ * everything below it in preorder and postorder,
+ * calling the hooks of v. Both hooks of a node get the
+ * scope the node appears in; its children get the
+ * scope it opens (t->scope), if any. The walk keeps its
+ * own stack, so neither long sibling lists nor deep
+ * nesting use C stack
+ */
+void visitTree(TreeNode * t, ScopeList scope, const Visitor * v,
+               void * context);
+
+/* Procedure visitNode walks t and everything below
+ * it like visitTree, leaving out the siblings of t
+ */
+void visitNode(TreeNode * t, ScopeList scope, const Visitor * v,
+               void * context);
+
+#endif